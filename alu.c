@@ -38,12 +38,18 @@ typedef struct alu_t {
 void initialize_alu(alu_p);
 
 /** Allocates and initializes a new ALU module */
-alu_p alu_create() {
-    alu_p alu = calloc(1, sizeof(alu_t));
+alu_p alu_create() { return alu_create_at(calloc(1, sizeof(alu_t))); }
+
+/** Initializes an ALU module in storage supplied by the caller */
+alu_p alu_create_at(void *storage) {
+    alu_p alu = storage;
     initialize_alu(alu);
     return alu;
 }
 
+/** Gets the number of bytes an ALU module needs */
+size_t alu_size() { return sizeof(alu_t); }
+
 /** Reinitializes the ALU without reallocation */
 void alu_reset(alu_p alu) { initialize_alu(alu); }
 
@@ -59,6 +65,13 @@ const alu_snapshot_t alu_get_snapshot(alu_p alu) {
     return snapshot;
 }
 
+/** Puts the ALU back the way a snapshot found it */
+void alu_restore_snapshot(alu_p alu, const alu_snapshot_t *snapshot) {
+    alu->sr1 = snapshot->a;
+    alu->sr2 = snapshot->b;
+    alu->result = snapshot->result;
+}
+
 /** Load ALU source register 1 */
 void alu_load_sr1(alu_p alu, word_t data) { alu->sr1 = data; }
 
@@ -34,6 +34,13 @@ typedef struct alu_t *alu_p;
 /** Allocates and initializes a new ALU module */
 alu_p alu_create();
 
+/** Initializes a new ALU module in zeroed storage of at least alu_size() bytes supplied by the
+ * caller. An ALU created this way is released along with its storage, not with alu_destroy */
+alu_p alu_create_at(void *storage);
+
+/** Gets the number of bytes an ALU module needs */
+size_t alu_size();
+
 /** Reinitializes the ALU without reallocation */
 void alu_reset(alu_p alu);
 
@@ -46,6 +53,9 @@ void alu_destroy(alu_p alu);
 /** Takes a snapshot of the ALU data for debugging or display purposes */
 const alu_snapshot_t alu_get_snapshot(alu_p);
 
+/** Puts the ALU back the way a snapshot found it. Used to restore a saved state */
+void alu_restore_snapshot(alu_p, const alu_snapshot_t *);
+
 /** Load ALU source register 1 */
 void alu_load_sr1(alu_p, word_t data);
 
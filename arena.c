@@ -0,0 +1,90 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Arena Module File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** A released slot. Its first bytes link it to the slot released before it */
+typedef struct arena_slot_t {
+    struct arena_slot_t *next;
+} arena_slot_t;
+
+typedef struct arena_t {
+    char *base;
+    size_t slot_size;
+    size_t slot_count;
+    /** Slots below this index have been handed out at least once */
+    size_t used;
+    /** Slots that were handed out and given back, most recent first */
+    arena_slot_t *free_list;
+} arena_t, *arena_p;
+
+/** Allocates and initializes a new arena */
+arena_p arena_create(size_t slot_size, size_t slot_count) {
+    arena_p arena = calloc(1, sizeof(arena_t));
+    arena->slot_size = ARENA_ROUND_UP(slot_size < sizeof(arena_slot_t) ? sizeof(arena_slot_t)
+                                                                        : slot_size);
+    arena->slot_count = slot_count;
+    arena->base = aligned_alloc(ARENA_ALIGNMENT, arena->slot_size * slot_count);
+    if (arena->base == NULL) {
+        free(arena);
+        return NULL;
+    }
+    return arena;
+}
+
+/** Deallocates the arena */
+void arena_destroy(arena_p arena) {
+    free(arena->base);
+    free(arena);
+}
+
+/** Hands out a zeroed slot */
+void *arena_alloc(arena_p arena) {
+    void *slot;
+    if (arena->free_list != NULL) {
+        slot = arena->free_list;
+        arena->free_list = arena->free_list->next;
+    } else if (arena->used < arena->slot_count) {
+        slot = arena->base + arena->used * arena->slot_size;
+        arena->used++;
+    } else {
+        return NULL;
+    }
+    memset(slot, 0, arena->slot_size);
+    return slot;
+}
+
+/** Gives a slot back to the arena */
+void arena_free(arena_p arena, void *slot) {
+    arena_slot_t *released = slot;
+    released->next = arena->free_list;
+    arena->free_list = released;
+}
+
+/** Gets the size of each slot */
+size_t arena_get_slot_size(arena_p arena) { return arena->slot_size; }
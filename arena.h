@@ -0,0 +1,57 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Arena Module Header File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/** Every slot starts on a cache line boundary */
+#define ARENA_ALIGNMENT 64
+
+/** Rounds a size up to a whole number of cache lines */
+#define ARENA_ROUND_UP(size) (((size) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+typedef struct arena_t *arena_p;
+
+/** Allocates an arena holding up to slot_count equally sized slots in one contiguous,
+ * cache-aligned block. Returns NULL if the block could not be allocated */
+arena_p arena_create(size_t slot_size, size_t slot_count);
+
+/** Deallocates the arena along with every slot still handed out from it */
+void arena_destroy(arena_p);
+
+/** Hands out a zeroed slot, reusing the most recently released one if there is one and
+ * otherwise bumping past the last slot used. Returns NULL once every slot is in use */
+void *arena_alloc(arena_p);
+
+/** Gives a slot back to the arena it came from */
+void arena_free(arena_p, void *slot);
+
+/** Gets the size of each slot, which is the requested size rounded up to the alignment */
+size_t arena_get_slot_size(arena_p);
+
+#endif
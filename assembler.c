@@ -0,0 +1,1139 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Assembler Module File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#include "assembler.h"
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+/** Starting capacities of the line list, the symbol hash table and the name pool. Each doubles
+ * whenever it fills; the hash table when it is half full */
+#define ASSEMBLER_INITIAL_LINES 256
+#define ASSEMBLER_INITIAL_SYMBOLS 64
+#define ASSEMBLER_INITIAL_POOL 1024
+
+/** A label, an instruction and up to three operands */
+#define ASSEMBLER_OPERANDS_MAX 3
+#define ASSEMBLER_TOKENS_MAX (ASSEMBLER_OPERANDS_MAX + 2)
+
+/** Returned in place of a token count for a line that can't be split up */
+#define ASSEMBLER_TOO_MANY_TOKENS -1
+#define ASSEMBLER_UNCLOSED_STRING -2
+
+#define ASSEMBLER_ERROR_SIZE 96
+#define ASSEMBLER_LISTING_SIZE 64
+
+/** How an instruction's operands are encoded. The operands each one takes are spelled out in
+ * operand_specs below */
+#define ASSEMBLER_FORMAT_OPERATE 0     /* ADD, AND: DR, SR1, SR2 or imm5 */
+#define ASSEMBLER_FORMAT_NOT 1         /* DR, SR */
+#define ASSEMBLER_FORMAT_BRANCH 2      /* PCoffset9, with the condition already in the base */
+#define ASSEMBLER_FORMAT_JUMP 3        /* JMP, JSRR: BaseR */
+#define ASSEMBLER_FORMAT_JSR 4         /* PCoffset11 */
+#define ASSEMBLER_FORMAT_PC_RELATIVE 5 /* LD, LDI, LEA, ST, STI: DR, PCoffset9 */
+#define ASSEMBLER_FORMAT_BASE 6        /* LDR, STR: DR, BaseR, offset6 */
+#define ASSEMBLER_FORMAT_TRAP 7        /* trapvect8 */
+#define ASSEMBLER_FORMAT_NONE 8        /* RET, RTI */
+#define ASSEMBLER_FORMAT_ALIAS 9       /* GETC, OUT or PUTC, PUTS, IN, PUTSP, HALT */
+#define ASSEMBLER_FORMAT_STACK 10      /* PUSH, POP: DR */
+#define ASSEMBLER_FORMAT_ORIG 11
+#define ASSEMBLER_FORMAT_FILL 12
+#define ASSEMBLER_FORMAT_BLKW 13
+#define ASSEMBLER_FORMAT_STRINGZ 14
+#define ASSEMBLER_FORMAT_END 15
+
+/** One letter per operand, indexed by format: R a register, N a number, A a number or a label,
+ * B a register or a number and S a quoted string */
+static const char *operand_specs[] = {"RRB", "RR", "A", "R", "A", "RA", "RRN", "N",
+                                      "",    "",   "R", "N", "A", "N", "S", ""};
+
+/** Operand types */
+#define ASSEMBLER_OPERAND_REGISTER 0
+#define ASSEMBLER_OPERAND_NUMBER 1
+#define ASSEMBLER_OPERAND_SYMBOL 2
+#define ASSEMBLER_OPERAND_STRING 3
+
+typedef struct assembler_op_t {
+    const char *name;
+    word_t base;
+    int format;
+} assembler_op_t;
+
+/** Every instruction and directive, with the bits it always sets */
+static const assembler_op_t ops[] = {
+    {"ADD", 0x1000, ASSEMBLER_FORMAT_OPERATE},  {"AND", 0x5000, ASSEMBLER_FORMAT_OPERATE},
+    {"NOT", 0x903F, ASSEMBLER_FORMAT_NOT},      {"BR", 0x0E00, ASSEMBLER_FORMAT_BRANCH},
+    {"BRN", 0x0800, ASSEMBLER_FORMAT_BRANCH},   {"BRZ", 0x0400, ASSEMBLER_FORMAT_BRANCH},
+    {"BRP", 0x0200, ASSEMBLER_FORMAT_BRANCH},   {"BRNZ", 0x0C00, ASSEMBLER_FORMAT_BRANCH},
+    {"BRNP", 0x0A00, ASSEMBLER_FORMAT_BRANCH},  {"BRZP", 0x0600, ASSEMBLER_FORMAT_BRANCH},
+    {"BRNZP", 0x0E00, ASSEMBLER_FORMAT_BRANCH}, {"JMP", 0xC000, ASSEMBLER_FORMAT_JUMP},
+    {"JSRR", 0x4000, ASSEMBLER_FORMAT_JUMP},    {"RET", 0xC1C0, ASSEMBLER_FORMAT_NONE},
+    {"JSR", 0x4800, ASSEMBLER_FORMAT_JSR},      {"LD", 0x2000, ASSEMBLER_FORMAT_PC_RELATIVE},
+    {"LDI", 0xA000, ASSEMBLER_FORMAT_PC_RELATIVE},
+    {"LEA", 0xE000, ASSEMBLER_FORMAT_PC_RELATIVE},
+    {"ST", 0x3000, ASSEMBLER_FORMAT_PC_RELATIVE},
+    {"STI", 0xB000, ASSEMBLER_FORMAT_PC_RELATIVE},
+    {"LDR", 0x6000, ASSEMBLER_FORMAT_BASE},     {"STR", 0x7000, ASSEMBLER_FORMAT_BASE},
+    {"TRAP", 0xF000, ASSEMBLER_FORMAT_TRAP},    {"RTI", 0x8000, ASSEMBLER_FORMAT_NONE},
+    {"GETC", 0xF020, ASSEMBLER_FORMAT_ALIAS},   {"OUT", 0xF021, ASSEMBLER_FORMAT_ALIAS},
+    {"PUTC", 0xF021, ASSEMBLER_FORMAT_ALIAS},
+    {"PUTS", 0xF022, ASSEMBLER_FORMAT_ALIAS},   {"IN", 0xF023, ASSEMBLER_FORMAT_ALIAS},
+    {"PUTSP", 0xF024, ASSEMBLER_FORMAT_ALIAS},  {"HALT", 0xF025, ASSEMBLER_FORMAT_ALIAS},
+    {"PUSH", 0xD000, ASSEMBLER_FORMAT_STACK},   {"POP", 0xD020, ASSEMBLER_FORMAT_STACK},
+    {".ORIG", 0, ASSEMBLER_FORMAT_ORIG},        {".FILL", 0, ASSEMBLER_FORMAT_FILL},
+    {".BLKW", 0, ASSEMBLER_FORMAT_BLKW},        {".STRINGZ", 0, ASSEMBLER_FORMAT_STRINGZ},
+    {".END", 0, ASSEMBLER_FORMAT_END}};
+
+#define ASSEMBLER_OP_COUNT (sizeof(ops) / sizeof(ops[0]))
+
+typedef struct assembler_token_t {
+    const char *text;
+    size_t length;
+} assembler_token_t;
+
+/** A register number, a number, a symbol index or the pool offset of a string */
+typedef struct assembler_operand_t {
+    int type;
+    long value;
+} assembler_operand_t;
+
+/** A source line that has a label or an instruction on it */
+typedef struct assembler_line_t {
+    unsigned int number;
+    word_t address;
+    /** Words the line takes up. Up to a whole memory's worth for .BLKW */
+    unsigned int length;
+    /** The instruction or directive, or NULL for a line with only a label */
+    const assembler_op_t *op;
+    /** The symbol index of the label, or -1 */
+    int label;
+    int operand_count;
+    assembler_operand_t operands[ASSEMBLER_OPERANDS_MAX];
+    /** The line's text, hashed, so an edit to it can be spotted on the next assembly */
+    unsigned long hash;
+    size_t text_length;
+    /** Where each label operand pointed when the line was encoded. These are the only
+     * symbols its words depend on */
+    word_t resolved[ASSEMBLER_OPERANDS_MAX];
+} assembler_line_t;
+
+typedef struct assembler_symbol_t {
+    /** Offset of the name in the pool */
+    size_t name;
+    word_t address;
+    bool_t is_defined;
+} assembler_symbol_t;
+
+typedef struct assembler_error_t {
+    unsigned int line;
+    char message[ASSEMBLER_ERROR_SIZE];
+} assembler_error_t;
+
+/** Everything one assembly produces */
+typedef struct assembler_program_t {
+    assembler_line_t *lines;
+    size_t line_count;
+    size_t line_capacity;
+
+    /** Symbols in the order they were first seen. The hash table holds an index into them for
+     * each name, or -1 for an empty slot, and is probed linearly */
+    assembler_symbol_t *symbols;
+    size_t symbol_count;
+    int *table;
+    size_t table_capacity;
+
+    /** Symbol names and decoded strings, each NUL terminated */
+    char *pool;
+    size_t pool_length;
+    size_t pool_capacity;
+
+    bool_t has_origin;
+    word_t origin;
+    /** One past the last word laid out, which is MEMORY_SIZE if the program ends at xFFFF */
+    unsigned long end;
+    word_t *words;
+    size_t word_count;
+} assembler_program_t;
+
+typedef struct assembler_t {
+    /** The program being assembled, or the last one once it is done. The previous program is
+     * kept beside it, so each assembly can reuse what didn't change since the last, and is
+     * swapped back in if an assembly fails */
+    assembler_program_t *program;
+    assembler_program_t *previous;
+    bool_t has_program;
+    assembler_program_t programs[2];
+
+    /** Addresses whose words differ from the previous program's */
+    word_t *changes;
+    size_t change_count;
+    size_t change_capacity;
+
+    assembler_error_t errors[ASSEMBLER_ERRORS_MAX];
+    unsigned int error_count;
+} assembler_t, *assembler_p;
+
+/** Allocates the buffers of an empty program */
+void assembler_init_program(assembler_program_t *);
+
+/** Deallocates the buffers of a program */
+void assembler_free_program(assembler_program_t *);
+
+/** Swaps the program with the previous one */
+void assembler_swap(assembler_p);
+
+/** Empties the program for another assembly, keeping its allocations */
+void assembler_clear(assembler_p);
+
+/** Finds the line of the previous program that the line is an unedited copy of: the same
+ * text at the same address, with its labels still where they were. Returns NULL if there isn't
+ * one. The cursor only moves forward, since both programs' lines are in address order */
+const assembler_line_t *assembler_find_unchanged(assembler_p, const assembler_line_t *,
+                                                 size_t *cursor);
+
+/** Records the addresses of the words a newly encoded line changed */
+void assembler_record_changes(assembler_p, const assembler_line_t *);
+
+/** First pass: lays out one source line */
+void assembler_lay_out(assembler_p, const char *text, const char *end, unsigned int number,
+                       word_t *address, bool_t *ended);
+
+/** Second pass: encodes the words of one line */
+void assembler_encode(assembler_p, assembler_line_t *);
+
+/** Splits a source line into tokens, stopping at a comment. Returns the number found, or
+ * ASSEMBLER_TOO_MANY_TOKENS or ASSEMBLER_UNCLOSED_STRING */
+int assembler_tokenize(const char *text, const char *end, assembler_token_t *);
+
+/** Finds the instruction or directive a token names, or returns NULL */
+const assembler_op_t *assembler_find_op(const assembler_token_t *);
+
+/** Turns a token into an operand of the kind the spec letter asks for. Returns FALSE, having
+ * reported the error, if it isn't one */
+bool_t assembler_parse_operand(assembler_p, const assembler_token_t *, char spec,
+                               unsigned int number, assembler_operand_t *);
+
+/** Parses a register name (R0 to R7). Returns -1 if the token isn't one */
+int assembler_parse_register(const assembler_token_t *);
+
+/** Parses #decimal, decimal, xhex or 0xhex. Returns FALSE if the token isn't a number */
+bool_t assembler_parse_number(const assembler_token_t *, long *value);
+
+/** Returns whether the token can be a label: a letter or underscore, then letters, digits and
+ * underscores, and not something else already */
+bool_t assembler_is_label(const assembler_token_t *);
+
+/** Finds a symbol by name, adding it undefined if it isn't there yet. Returns its index */
+int assembler_intern(assembler_p, const char *name, size_t length);
+
+/** Hashes a name without regard to case (FNV-1a) */
+unsigned long assembler_hash(const char *name, size_t length);
+
+/** Hashes a line of source exactly as it is */
+unsigned long assembler_hash_line(const char *text, size_t length);
+
+/** Copies bytes into the pool and NUL terminates them. Returns their offset */
+size_t assembler_pool_add(assembler_p, const char *text, size_t length);
+
+/** Resolves an operand to the value it stands for, a symbol to its address. Returns FALSE,
+ * having reported the error, if the symbol was never defined */
+bool_t assembler_resolve(assembler_p, const assembler_line_t *, int operand, long *value);
+
+/** Resolves a PC-relative operand and checks it fits in a field of the given width. A label is
+ * turned into the offset to it; a number is taken as the offset itself */
+word_t assembler_offset(assembler_p, const assembler_line_t *, int operand, int bits);
+
+/** Checks a signed immediate fits in a field of the given width and returns its bits. Numbers
+ * written in hex from x8000 up are taken as negative */
+word_t assembler_immediate(assembler_p, const assembler_line_t *, long value, int bits);
+
+/** Records an error against a source line */
+void assembler_error(assembler_p, unsigned int line, const char *format, ...);
+
+/** Writes one listing line */
+void assembler_write_listing_line(FILE *, word_t address, word_t word, unsigned int number,
+                                  const char *label, const char *name, const char *operands);
+
+/** Writes the operands of an instruction the way the listing shows them */
+void assembler_format_operands(assembler_p, const assembler_line_t *, char *, size_t);
+
+/** Allocates an assembler with nothing assembled */
+assembler_p assembler_create() {
+    assembler_p assembler = calloc(1, sizeof(assembler_t));
+    assembler_init_program(&assembler->programs[0]);
+    assembler_init_program(&assembler->programs[1]);
+    assembler->program = &assembler->programs[0];
+    assembler->previous = &assembler->programs[1];
+    assembler->has_program = FALSE;
+    assembler->change_capacity = ASSEMBLER_INITIAL_LINES;
+    assembler->changes = malloc(sizeof(word_t) * assembler->change_capacity);
+    assembler_clear(assembler);
+    return assembler;
+}
+
+/** Deallocates the assembler */
+void assembler_destroy(assembler_p assembler) {
+    assembler_free_program(&assembler->programs[0]);
+    assembler_free_program(&assembler->programs[1]);
+    free(assembler->changes);
+    free(assembler);
+}
+
+/** Assembles the source in two passes over it. The first pass keeps a record of every line
+ * that has a label or an instruction, so the second only walks those records. Records the
+ * previous program already encoded the same way have their words copied instead */
+bool_t assembler_assemble(assembler_p assembler, const char *source, size_t length) {
+    bool_t had_program = assembler->has_program;
+    assembler_swap(assembler);
+    assembler_clear(assembler);
+    assembler_program_t *program = assembler->program;
+    const char *end = source + length;
+    const char *text = source;
+    unsigned int number = 0;
+    word_t address = 0;
+    bool_t ended = FALSE;
+    while (text < end && ended == FALSE) {
+        const char *line_end = memchr(text, '\n', end - text);
+        if (line_end == NULL) {
+            line_end = end;
+        }
+        number++;
+        assembler_lay_out(assembler, text, line_end, number, &address, &ended);
+        text = line_end + 1;
+    }
+    if (program->has_origin == FALSE && assembler->error_count == 0) {
+        assembler_error(assembler, number, "no .ORIG");
+    }
+    if (assembler->error_count > 0) {
+        assembler_swap(assembler);
+        return FALSE;
+    }
+
+    free(program->words);
+    program->word_count = program->end - program->origin;
+    program->words = malloc(sizeof(word_t) * (program->word_count + 1));
+    const assembler_program_t *previous = assembler->previous;
+    size_t cursor = 0;
+    size_t i;
+    for (i = 0; i < program->line_count; i++) {
+        assembler_line_t *line = &program->lines[i];
+        const assembler_line_t *unchanged =
+            (had_program == TRUE) ? assembler_find_unchanged(assembler, line, &cursor) : NULL;
+        if (unchanged != NULL) {
+            memcpy(program->words + (word_t)(line->address - program->origin),
+                   previous->words + (word_t)(line->address - previous->origin),
+                   sizeof(word_t) * line->length);
+            memcpy(line->resolved, unchanged->resolved, sizeof(line->resolved));
+        } else {
+            assembler_encode(assembler, line);
+            assembler_record_changes(assembler, line);
+        }
+    }
+    if (assembler->error_count > 0) {
+        assembler_swap(assembler);
+        assembler->change_count = 0;
+        return FALSE;
+    }
+    if (had_program == FALSE) {
+        /* Everything is new, and the records above didn't have anything to compare with */
+        assembler->change_count = 0;
+    }
+    assembler->has_program = TRUE;
+    return TRUE;
+}
+
+/** Gets where the program goes */
+word_t assembler_get_origin(assembler_p assembler) { return assembler->program->origin; }
+
+/** Gets the words of the program */
+const word_t *assembler_get_words(assembler_p assembler) { return assembler->program->words; }
+
+/** Gets the number of words in the program */
+size_t assembler_get_count(assembler_p assembler) { return assembler->program->word_count; }
+
+/** Gets the addresses of the words that changed in the last assembly */
+const word_t *assembler_get_changes(assembler_p assembler, size_t *count) {
+    *count = assembler->change_count;
+    return assembler->changes;
+}
+
+/** Looks up the address of a label */
+bool_t assembler_lookup(assembler_p assembler, const char *name, word_t *address) {
+    assembler_program_t *program = assembler->program;
+    size_t length = strlen(name);
+    size_t mask = program->table_capacity - 1;
+    size_t slot = assembler_hash(name, length) & mask;
+    while (program->table[slot] >= 0) {
+        assembler_symbol_t *symbol = &program->symbols[program->table[slot]];
+        const char *other = program->pool + symbol->name;
+        if (strlen(other) == length && strncasecmp(other, name, length) == 0) {
+            *address = symbol->address;
+            return symbol->is_defined;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return FALSE;
+}
+
+/** Writes the errors from the last assembly */
+void assembler_write_errors(assembler_p assembler, const char *file_name, FILE *file) {
+    unsigned int i;
+    unsigned int kept =
+        (assembler->error_count < ASSEMBLER_ERRORS_MAX) ? assembler->error_count
+                                                        : ASSEMBLER_ERRORS_MAX;
+    for (i = 0; i < kept; i++) {
+        fprintf(file, "%s:%u: %s\n", file_name, assembler->errors[i].line,
+                assembler->errors[i].message);
+    }
+    if (assembler->error_count > kept) {
+        fprintf(file, "%s: %u more errors\n", file_name, assembler->error_count - kept);
+    }
+}
+
+/** Writes a listing of the last assembly. .BLKW and .STRINGZ get a line for every word they
+ * take up, listed as the .FILL that would have put it there */
+void assembler_write_listing(assembler_p assembler, FILE *file) {
+    assembler_program_t *program = assembler->program;
+    char operands[ASSEMBLER_LISTING_SIZE];
+    size_t i;
+    for (i = 0; i < program->line_count; i++) {
+        const assembler_line_t *line = &program->lines[i];
+        const char *label = (line->label >= 0)
+                                ? program->pool + program->symbols[line->label].name
+                                : "";
+        if (line->op == NULL) {
+            continue;
+        }
+        if (line->op->format == ASSEMBLER_FORMAT_ORIG) {
+            snprintf(operands, sizeof(operands), "x%04X", program->origin);
+            assembler_write_listing_line(file, 0, program->origin, line->number, label,
+                                         line->op->name, operands);
+            continue;
+        }
+        unsigned int j;
+        for (j = 0; j < line->length; j++) {
+            word_t address = line->address + j;
+            word_t word = program->words[(word_t)(address - program->origin)];
+            if (line->op->format >= ASSEMBLER_FORMAT_FILL) {
+                snprintf(operands, sizeof(operands), "x%04X", word);
+                assembler_write_listing_line(file, address, word, line->number,
+                                             (j == 0) ? label : "", ".FILL", operands);
+            } else {
+                assembler_format_operands(assembler, line, operands, sizeof(operands));
+                const char *name =
+                    (line->op->format == ASSEMBLER_FORMAT_ALIAS) ? "TRAP" : line->op->name;
+                assembler_write_listing_line(file, address, word, line->number, label, name,
+                                             operands);
+            }
+        }
+    }
+}
+
+/** Allocates the buffers of an empty program */
+void assembler_init_program(assembler_program_t *program) {
+    program->line_capacity = ASSEMBLER_INITIAL_LINES;
+    program->lines = malloc(sizeof(assembler_line_t) * program->line_capacity);
+    program->table_capacity = ASSEMBLER_INITIAL_SYMBOLS;
+    program->table = malloc(sizeof(int) * program->table_capacity);
+    program->symbols = malloc(sizeof(assembler_symbol_t) * program->table_capacity / 2);
+    program->pool_capacity = ASSEMBLER_INITIAL_POOL;
+    program->pool = malloc(program->pool_capacity);
+    program->words = NULL;
+    program->word_count = 0;
+}
+
+/** Deallocates the buffers of a program */
+void assembler_free_program(assembler_program_t *program) {
+    free(program->lines);
+    free(program->table);
+    free(program->symbols);
+    free(program->pool);
+    free(program->words);
+}
+
+/** Swaps the program with the previous one */
+void assembler_swap(assembler_p assembler) {
+    assembler_program_t *program = assembler->program;
+    assembler->program = assembler->previous;
+    assembler->previous = program;
+}
+
+/** Empties the program for another assembly */
+void assembler_clear(assembler_p assembler) {
+    assembler_program_t *program = assembler->program;
+    program->line_count = 0;
+    program->symbol_count = 0;
+    memset(program->table, -1, sizeof(int) * program->table_capacity);
+    program->pool_length = 0;
+    program->has_origin = FALSE;
+    program->origin = 0;
+    program->end = 0;
+    program->word_count = 0;
+    assembler->change_count = 0;
+    assembler->error_count = 0;
+}
+
+/** Finds the line of the previous program that the line is an unedited copy of */
+const assembler_line_t *assembler_find_unchanged(assembler_p assembler,
+                                                 const assembler_line_t *line,
+                                                 size_t *cursor) {
+    const assembler_program_t *previous = assembler->previous;
+    const assembler_program_t *program = assembler->program;
+    while (*cursor < previous->line_count &&
+           previous->lines[*cursor].address < line->address) {
+        (*cursor)++;
+    }
+    size_t i;
+    for (i = *cursor;
+         i < previous->line_count && previous->lines[i].address == line->address; i++) {
+        const assembler_line_t *old = &previous->lines[i];
+        if (old->hash != line->hash || old->text_length != line->text_length ||
+            old->length != line->length) {
+            continue;
+        }
+        int j;
+        for (j = 0; j < line->operand_count; j++) {
+            const assembler_operand_t *operand = &line->operands[j];
+            if (operand->type == ASSEMBLER_OPERAND_SYMBOL &&
+                (program->symbols[operand->value].is_defined == FALSE ||
+                 program->symbols[operand->value].address != old->resolved[j])) {
+                return NULL;
+            }
+        }
+        return old;
+    }
+    return NULL;
+}
+
+/** Records the addresses of the words a newly encoded line changed. Words the previous program
+ * didn't have count as changed */
+void assembler_record_changes(assembler_p assembler, const assembler_line_t *line) {
+    const assembler_program_t *previous = assembler->previous;
+    const assembler_program_t *program = assembler->program;
+    unsigned int i;
+    for (i = 0; i < line->length; i++) {
+        word_t address = line->address + i;
+        word_t offset = address - previous->origin;
+        word_t word = program->words[(word_t)(address - program->origin)];
+        if (offset < previous->word_count && previous->words[offset] == word) {
+            continue;
+        }
+        if (assembler->change_count == assembler->change_capacity) {
+            assembler->change_capacity *= 2;
+            assembler->changes =
+                realloc(assembler->changes, sizeof(word_t) * assembler->change_capacity);
+        }
+        assembler->changes[assembler->change_count++] = address;
+    }
+}
+
+/** Lays out one source line: defines its label at the current address, checks its operands
+ * and moves the address past the words it will take up */
+void assembler_lay_out(assembler_p assembler, const char *text, const char *end,
+                       unsigned int number, word_t *address, bool_t *ended) {
+    assembler_program_t *program = assembler->program;
+    assembler_token_t tokens[ASSEMBLER_TOKENS_MAX];
+    int count = assembler_tokenize(text, end, tokens);
+    if (count == ASSEMBLER_TOO_MANY_TOKENS) {
+        assembler_error(assembler, number, "too many operands");
+        return;
+    }
+    if (count == ASSEMBLER_UNCLOSED_STRING) {
+        assembler_error(assembler, number, "string isn't closed");
+        return;
+    }
+    if (count == 0) {
+        return;
+    }
+
+    assembler_line_t line;
+    line.number = number;
+    line.address = *address;
+    line.length = 0;
+    line.label = -1;
+    line.operand_count = 0;
+    line.hash = assembler_hash_line(text, end - text);
+    line.text_length = end - text;
+    int next = 1;
+    line.op = assembler_find_op(&tokens[0]);
+    if (line.op == NULL) {
+        /* A label may end in a colon */
+        if (tokens[0].length > 1 && tokens[0].text[tokens[0].length - 1] == ':') {
+            tokens[0].length--;
+        }
+        if (assembler_is_label(&tokens[0]) == FALSE) {
+            assembler_error(assembler, number, "unknown instruction %.*s",
+                            (int)tokens[0].length, tokens[0].text);
+            return;
+        }
+        line.label = assembler_intern(assembler, tokens[0].text, tokens[0].length);
+        if (count > 1) {
+            line.op = assembler_find_op(&tokens[1]);
+            if (line.op == NULL) {
+                assembler_error(assembler, number, "unknown instruction %.*s",
+                                (int)tokens[1].length, tokens[1].text);
+            }
+            next = 2;
+        }
+    }
+
+    if (line.op != NULL && line.op->format == ASSEMBLER_FORMAT_END) {
+        *ended = TRUE;
+    } else if (line.op != NULL && line.op->format != ASSEMBLER_FORMAT_ORIG &&
+               program->has_origin == FALSE) {
+        assembler_error(assembler, number, "%s before .ORIG", line.op->name);
+        return;
+    }
+    if (line.label >= 0) {
+        assembler_symbol_t *symbol = &program->symbols[line.label];
+        if (symbol->is_defined == TRUE) {
+            assembler_error(assembler, number, "%s is already defined",
+                            program->pool + symbol->name);
+        }
+        symbol->is_defined = TRUE;
+        symbol->address = *address;
+    }
+
+    if (line.op != NULL) {
+        const char *spec = operand_specs[line.op->format];
+        int expected = strlen(spec);
+        if (count - next != expected) {
+            assembler_error(assembler, number, "%s takes %d operand%s", line.op->name, expected,
+                            (expected == 1) ? "" : "s");
+        } else {
+            int i;
+            for (i = 0; i < expected; i++) {
+                if (assembler_parse_operand(assembler, &tokens[next + i], spec[i], number,
+                                            &line.operands[i]) == FALSE) {
+                    break;
+                }
+            }
+            line.operand_count = i;
+        }
+
+        bool_t complete = (line.operand_count == expected) ? TRUE : FALSE;
+        switch (line.op->format) {
+        case ASSEMBLER_FORMAT_ORIG:
+            if (program->has_origin == TRUE) {
+                assembler_error(assembler, number, "only one .ORIG is supported");
+            } else if (complete == TRUE) {
+                long origin = line.operands[0].value;
+                if (origin < 0 || origin >= MEMORY_SIZE) {
+                    assembler_error(assembler, number, ".ORIG x%lX is out of range", origin);
+                }
+                program->has_origin = TRUE;
+                program->origin = origin;
+                *address = origin;
+                line.address = origin;
+                program->end = origin;
+                if (line.label >= 0) {
+                    program->symbols[line.label].address = origin;
+                }
+            }
+            break;
+        case ASSEMBLER_FORMAT_END:
+            break;
+        case ASSEMBLER_FORMAT_BLKW:
+            if (complete == TRUE) {
+                long blocks = line.operands[0].value;
+                if (blocks < 1 || blocks > MEMORY_SIZE) {
+                    assembler_error(assembler, number, ".BLKW %ld is out of range", blocks);
+                } else {
+                    line.length = blocks;
+                }
+            }
+            break;
+        case ASSEMBLER_FORMAT_STRINGZ:
+            if (complete == TRUE) {
+                line.length = strlen(program->pool + line.operands[0].value) + 1;
+            }
+            break;
+        default:
+            line.length = 1;
+            break;
+        }
+    }
+
+    /* The last word may sit at xFFFF, which wraps the address around to zero, so the check is
+     * made against the end instead */
+    if (program->end + line.length > MEMORY_SIZE) {
+        assembler_error(assembler, number, "program runs past xFFFF");
+        *ended = TRUE;
+        return;
+    }
+    *address = line.address + line.length;
+    if (line.length > 0) {
+        program->end = line.address + line.length;
+    }
+
+    if (program->line_count == program->line_capacity) {
+        program->line_capacity *= 2;
+        program->lines =
+            realloc(program->lines, sizeof(assembler_line_t) * program->line_capacity);
+    }
+    program->lines[program->line_count++] = line;
+}
+
+/** Encodes the words of one line into the program */
+void assembler_encode(assembler_p assembler, assembler_line_t *line) {
+    assembler_program_t *program = assembler->program;
+    if (line->op == NULL || line->length == 0) {
+        return;
+    }
+    /* Where the labels point now is kept, for the next assembly to tell if they've moved */
+    int i;
+    for (i = 0; i < line->operand_count; i++) {
+        if (line->operands[i].type == ASSEMBLER_OPERAND_SYMBOL) {
+            line->resolved[i] = program->symbols[line->operands[i].value].address;
+        }
+    }
+    word_t *words = program->words + (word_t)(line->address - program->origin);
+    const assembler_operand_t *operands = line->operands;
+    word_t word = line->op->base;
+    long value;
+    switch (line->op->format) {
+    case ASSEMBLER_FORMAT_OPERATE:
+        word |= (operands[0].value << 9) | (operands[1].value << 6);
+        if (operands[2].type == ASSEMBLER_OPERAND_REGISTER) {
+            word |= operands[2].value;
+        } else {
+            word |= 0x20 | assembler_immediate(assembler, line, operands[2].value, 5);
+        }
+        break;
+    case ASSEMBLER_FORMAT_NOT:
+        word |= (operands[0].value << 9) | (operands[1].value << 6);
+        break;
+    case ASSEMBLER_FORMAT_BRANCH:
+        word |= assembler_offset(assembler, line, 0, 9);
+        break;
+    case ASSEMBLER_FORMAT_JUMP:
+        word |= operands[0].value << 6;
+        break;
+    case ASSEMBLER_FORMAT_JSR:
+        word |= assembler_offset(assembler, line, 0, 11);
+        break;
+    case ASSEMBLER_FORMAT_PC_RELATIVE:
+        word |= (operands[0].value << 9) | assembler_offset(assembler, line, 1, 9);
+        break;
+    case ASSEMBLER_FORMAT_BASE:
+        word |= (operands[0].value << 9) | (operands[1].value << 6) |
+                assembler_immediate(assembler, line, operands[2].value, 6);
+        break;
+    case ASSEMBLER_FORMAT_TRAP:
+        if (operands[0].value < 0 || operands[0].value > 0xFF) {
+            assembler_error(assembler, line->number, "trap vector x%lX is out of range",
+                            operands[0].value);
+        }
+        word |= operands[0].value & 0xFF;
+        break;
+    case ASSEMBLER_FORMAT_STACK:
+        word |= operands[0].value << 9;
+        break;
+    case ASSEMBLER_FORMAT_FILL:
+        if (assembler_resolve(assembler, line, 0, &value) == TRUE &&
+            (value < -0x8000 || value > 0xFFFF)) {
+            assembler_error(assembler, line->number, ".FILL %ld is out of range", value);
+        }
+        word = value;
+        break;
+    case ASSEMBLER_FORMAT_BLKW:
+        memset(words, 0, sizeof(word_t) * line->length);
+        return;
+    case ASSEMBLER_FORMAT_STRINGZ: {
+        const unsigned char *string =
+            (const unsigned char *)program->pool + operands[0].value;
+        unsigned int j;
+        for (j = 0; j < line->length; j++) {
+            words[j] = string[j];
+        }
+        return;
+    }
+    default:
+        break;
+    }
+    words[0] = word;
+}
+
+/** Splits a source line into tokens. Commas count as white space, so "ADD R0, R0, #1" and
+ * "ADD R0 R0 #1" are the same. A quoted string is one token, quotes included */
+int assembler_tokenize(const char *text, const char *end, assembler_token_t *tokens) {
+    int count = 0;
+    while (TRUE) {
+        while (text < end && (isspace((unsigned char)*text) || *text == ',')) {
+            text++;
+        }
+        if (text == end || *text == ';') {
+            return count;
+        }
+        if (count == ASSEMBLER_TOKENS_MAX) {
+            return ASSEMBLER_TOO_MANY_TOKENS;
+        }
+        const char *start = text;
+        if (*text == '"') {
+            text++;
+            while (text < end && *text != '"') {
+                text += (*text == '\\' && text + 1 < end) ? 2 : 1;
+            }
+            if (text == end) {
+                return ASSEMBLER_UNCLOSED_STRING;
+            }
+            text++;
+        } else {
+            while (text < end && !isspace((unsigned char)*text) && *text != ',' &&
+                   *text != ';' && *text != '"') {
+                text++;
+            }
+        }
+        tokens[count].text = start;
+        tokens[count].length = text - start;
+        count++;
+    }
+}
+
+/** Finds the instruction or directive a token names, without regard to case */
+const assembler_op_t *assembler_find_op(const assembler_token_t *token) {
+    size_t i;
+    for (i = 0; i < ASSEMBLER_OP_COUNT; i++) {
+        if (strlen(ops[i].name) == token->length &&
+            strncasecmp(ops[i].name, token->text, token->length) == 0) {
+            return &ops[i];
+        }
+    }
+    return NULL;
+}
+
+/** Turns a token into an operand of the kind the spec letter asks for */
+bool_t assembler_parse_operand(assembler_p assembler, const assembler_token_t *token, char spec,
+                               unsigned int number, assembler_operand_t *operand) {
+    assembler_program_t *program = assembler->program;
+    int reg = assembler_parse_register(token);
+    if (reg >= 0 && (spec == 'R' || spec == 'B')) {
+        operand->type = ASSEMBLER_OPERAND_REGISTER;
+        operand->value = reg;
+        return TRUE;
+    }
+    if (spec == 'R') {
+        assembler_error(assembler, number, "expected a register, not %.*s", (int)token->length,
+                        token->text);
+        return FALSE;
+    }
+    if (spec == 'S') {
+        if (token->text[0] != '"') {
+            assembler_error(assembler, number, "expected a string");
+            return FALSE;
+        }
+        /* The string is copied into the pool without its quotes, then decoded in place */
+        operand->type = ASSEMBLER_OPERAND_STRING;
+        operand->value = assembler_pool_add(assembler, token->text + 1, token->length - 2);
+        char *string = program->pool + operand->value;
+        size_t from;
+        size_t to = 0;
+        for (from = 0; from < token->length - 2; from++) {
+            char c = string[from];
+            if (c == '\\') {
+                c = string[++from];
+                c = (c == 'n') ? '\n' : (c == 't') ? '\t' : (c == 'r') ? '\r' : c;
+                c = (c == '0') ? '\0' : c;
+            }
+            string[to++] = c;
+        }
+        string[to] = '\0';
+        return TRUE;
+    }
+    if (assembler_parse_number(token, &operand->value) == TRUE) {
+        operand->type = ASSEMBLER_OPERAND_NUMBER;
+        return TRUE;
+    }
+    if (spec == 'A' && reg < 0 && assembler_is_label(token) == TRUE) {
+        operand->type = ASSEMBLER_OPERAND_SYMBOL;
+        operand->value = assembler_intern(assembler, token->text, token->length);
+        return TRUE;
+    }
+    assembler_error(assembler, number, "expected %s, not %.*s",
+                    (spec == 'A')   ? "a label or number"
+                    : (spec == 'B') ? "a register or number"
+                                    : "a number",
+                    (int)token->length, token->text);
+    return FALSE;
+}
+
+/** Parses a register name */
+int assembler_parse_register(const assembler_token_t *token) {
+    if (token->length == 2 && (token->text[0] == 'R' || token->text[0] == 'r') &&
+        token->text[1] >= '0' && token->text[1] <= '7') {
+        return token->text[1] - '0';
+    }
+    return -1;
+}
+
+/** Parses a number. Decimal may have a # in front, hex an x or 0x, and either a minus sign */
+bool_t assembler_parse_number(const assembler_token_t *token, long *value) {
+    const char *text = token->text;
+    const char *end = text + token->length;
+    int base = 10;
+    if (text < end && *text == '#') {
+        text++;
+    } else if (text < end && (*text == 'x' || *text == 'X')) {
+        text++;
+        base = 16;
+    } else if (end - text > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+        text += 2;
+        base = 16;
+    }
+    bool_t negative = FALSE;
+    if (text < end && *text == '-') {
+        negative = TRUE;
+        text++;
+    }
+    if (text == end || end - text > 8) {
+        return FALSE;
+    }
+    long result = 0;
+    while (text < end) {
+        int digit;
+        if (*text >= '0' && *text <= '9') {
+            digit = *text - '0';
+        } else if (base == 16 && *text >= 'a' && *text <= 'f') {
+            digit = *text - 'a' + 10;
+        } else if (base == 16 && *text >= 'A' && *text <= 'F') {
+            digit = *text - 'A' + 10;
+        } else {
+            return FALSE;
+        }
+        result = result * base + digit;
+        text++;
+    }
+    *value = (negative == TRUE) ? -result : result;
+    return TRUE;
+}
+
+/** Returns whether the token can be a label */
+bool_t assembler_is_label(const assembler_token_t *token) {
+    long number;
+    if (!isalpha((unsigned char)token->text[0]) && token->text[0] != '_') {
+        return FALSE;
+    }
+    size_t i;
+    for (i = 1; i < token->length; i++) {
+        if (!isalnum((unsigned char)token->text[i]) && token->text[i] != '_') {
+            return FALSE;
+        }
+    }
+    return assembler_parse_register(token) < 0 &&
+           assembler_parse_number(token, &number) == FALSE && assembler_find_op(token) == NULL;
+}
+
+/** Finds a symbol by name, adding it if it isn't there yet. The table is doubled and every
+ * symbol rehashed once it is half full */
+int assembler_intern(assembler_p assembler, const char *name, size_t length) {
+    assembler_program_t *program = assembler->program;
+    size_t mask = program->table_capacity - 1;
+    size_t slot = assembler_hash(name, length) & mask;
+    while (program->table[slot] >= 0) {
+        assembler_symbol_t *symbol = &program->symbols[program->table[slot]];
+        const char *other = program->pool + symbol->name;
+        if (strncasecmp(other, name, length) == 0 && other[length] == '\0') {
+            return program->table[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    int index = program->symbol_count++;
+    assembler_symbol_t *symbol = &program->symbols[index];
+    symbol->name = assembler_pool_add(assembler, name, length);
+    symbol->address = 0;
+    symbol->is_defined = FALSE;
+    program->table[slot] = index;
+
+    if (program->symbol_count * 2 == program->table_capacity) {
+        program->table_capacity *= 2;
+        free(program->table);
+        program->table = malloc(sizeof(int) * program->table_capacity);
+        memset(program->table, -1, sizeof(int) * program->table_capacity);
+        program->symbols = realloc(program->symbols, sizeof(assembler_symbol_t) *
+                                                             program->table_capacity / 2);
+        mask = program->table_capacity - 1;
+        size_t i;
+        for (i = 0; i < program->symbol_count; i++) {
+            const char *other = program->pool + program->symbols[i].name;
+            slot = assembler_hash(other, strlen(other)) & mask;
+            while (program->table[slot] >= 0) {
+                slot = (slot + 1) & mask;
+            }
+            program->table[slot] = i;
+        }
+    }
+    return index;
+}
+
+/** Hashes a name without regard to case */
+unsigned long assembler_hash(const char *name, size_t length) {
+    unsigned long hash = 2166136261UL;
+    size_t i;
+    for (i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)toupper((unsigned char)name[i])) * 16777619UL;
+    }
+    return hash;
+}
+
+/** Hashes a line of source exactly as it is (FNV-1a) */
+unsigned long assembler_hash_line(const char *text, size_t length) {
+    unsigned long hash = 2166136261UL;
+    size_t i;
+    for (i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)text[i]) * 16777619UL;
+    }
+    return hash;
+}
+
+/** Copies bytes into the pool and NUL terminates them */
+size_t assembler_pool_add(assembler_p assembler, const char *text, size_t length) {
+    assembler_program_t *program = assembler->program;
+    while (program->pool_length + length + 1 > program->pool_capacity) {
+        program->pool_capacity *= 2;
+        program->pool = realloc(program->pool, program->pool_capacity);
+    }
+    size_t offset = program->pool_length;
+    memcpy(program->pool + offset, text, length);
+    program->pool[offset + length] = '\0';
+    program->pool_length += length + 1;
+    return offset;
+}
+
+/** Resolves an operand to the value it stands for */
+bool_t assembler_resolve(assembler_p assembler, const assembler_line_t *line, int operand,
+                         long *value) {
+    assembler_program_t *program = assembler->program;
+    const assembler_operand_t *o = &line->operands[operand];
+    if (o->type != ASSEMBLER_OPERAND_SYMBOL) {
+        *value = o->value;
+        return TRUE;
+    }
+    const assembler_symbol_t *symbol = &program->symbols[o->value];
+    if (symbol->is_defined == FALSE) {
+        assembler_error(assembler, line->number, "%s is not defined",
+                        program->pool + symbol->name);
+        *value = 0;
+        return FALSE;
+    }
+    *value = symbol->address;
+    return TRUE;
+}
+
+/** Resolves a PC-relative operand into the bits of its field */
+word_t assembler_offset(assembler_p assembler, const assembler_line_t *line, int operand,
+                        int bits) {
+    assembler_program_t *program = assembler->program;
+    long value;
+    if (assembler_resolve(assembler, line, operand, &value) == FALSE) {
+        return 0;
+    }
+    if (line->operands[operand].type == ASSEMBLER_OPERAND_NUMBER) {
+        return assembler_immediate(assembler, line, value, bits);
+    }
+    long offset = value - (line->address + 1);
+    long limit = 1L << (bits - 1);
+    if (offset < -limit || offset >= limit) {
+        const assembler_symbol_t *symbol = &program->symbols[line->operands[operand].value];
+        assembler_error(assembler, line->number, "%s is too far away",
+                        program->pool + symbol->name);
+        return 0;
+    }
+    return offset & ((1 << bits) - 1);
+}
+
+/** Checks a signed immediate fits in its field */
+word_t assembler_immediate(assembler_p assembler, const assembler_line_t *line, long value,
+                           int bits) {
+    if (value >= 0x8000 && value <= 0xFFFF) {
+        value -= 0x10000;
+    }
+    long limit = 1L << (bits - 1);
+    if (value < -limit || value >= limit) {
+        assembler_error(assembler, line->number, "#%ld doesn't fit in %d bits", value, bits);
+        return 0;
+    }
+    return value & ((1 << bits) - 1);
+}
+
+/** Records an error against a source line. Only the first ASSEMBLER_ERRORS_MAX are kept */
+void assembler_error(assembler_p assembler, unsigned int line, const char *format, ...) {
+    if (assembler->error_count < ASSEMBLER_ERRORS_MAX) {
+        assembler_error_t *error = &assembler->errors[assembler->error_count];
+        error->line = line;
+        va_list arguments;
+        va_start(arguments, format);
+        vsnprintf(error->message, ASSEMBLER_ERROR_SIZE, format, arguments);
+        va_end(arguments);
+    }
+    assembler->error_count++;
+}
+
+/** Writes one listing line, laid out the same way as the listings in hex/ */
+void assembler_write_listing_line(FILE *file, word_t address, word_t word, unsigned int number,
+                                  const char *label, const char *name, const char *operands) {
+    char binary[17];
+    int bit;
+    for (bit = 0; bit < 16; bit++) {
+        binary[bit] = (word & (0x8000 >> bit)) ? '1' : '0';
+    }
+    binary[16] = '\0';
+    fprintf(file, "(%04X) %04X  %s (%4u) %-16s%-6s%s\n", address, word, binary, number, label,
+            name, operands);
+}
+
+/** Writes the operands of an instruction the way the listing shows them: registers as Rn,
+ * labels by name, immediates and offsets in decimal and trap vectors in hex */
+void assembler_format_operands(assembler_p assembler, const assembler_line_t *line,
+                               char *text, size_t size) {
+    assembler_program_t *program = assembler->program;
+    text[0] = '\0';
+    if (line->op->format == ASSEMBLER_FORMAT_ALIAS) {
+        snprintf(text, size, "x%02X", line->op->base & 0xFF);
+        return;
+    }
+    size_t length = 0;
+    int i;
+    for (i = 0; i < line->operand_count && length < size; i++) {
+        const assembler_operand_t *operand = &line->operands[i];
+        const char *separator = (i == 0) ? "" : " ";
+        if (operand->type == ASSEMBLER_OPERAND_REGISTER) {
+            length +=
+                snprintf(text + length, size - length, "%sR%ld", separator, operand->value);
+        } else if (operand->type == ASSEMBLER_OPERAND_SYMBOL) {
+            length += snprintf(text + length, size - length, "%s%s", separator,
+                               program->pool + program->symbols[operand->value].name);
+        } else if (line->op->format == ASSEMBLER_FORMAT_TRAP) {
+            length += snprintf(text + length, size - length, "%sx%02lX", separator,
+                               operand->value & 0xFF);
+        } else {
+            length +=
+                snprintf(text + length, size - length, "%s#%ld", separator, operand->value);
+        }
+    }
+}
@@ -0,0 +1,82 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Assembler Module Header File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+
+#include "global.h"
+#include <stdio.h>
+
+/** "assemble <file.asm> [output]" assembles a file without running it, writing the program
+ * (as hex, or as an object file if the output name says so) and a listing next to it */
+#define ASSEMBLE_COMMAND "assemble"
+
+/** Files with this extension are assembled when they are loaded */
+#define ASSEMBLER_EXTENSION ".asm"
+#define ASSEMBLER_LISTING_EXTENSION ".lst"
+
+/** Only this many errors are kept; assembling goes on to count the rest */
+#define ASSEMBLER_ERRORS_MAX 20
+
+typedef struct assembler_t *assembler_p;
+
+/** Allocates an assembler with nothing assembled */
+assembler_p assembler_create();
+
+/** Deallocates the assembler */
+void assembler_destroy(assembler_p);
+
+/** Assembles the source text in two passes: the first lays out every line and fills in the
+ * symbol table, the second encodes each word. Takes the whole ISA, the stack opcode as PUSH and
+ * POP, the trap aliases and .ORIG/.FILL/.BLKW/.STRINGZ/.END.
+ *
+ * An assembler that already holds a program treats the source as an edit of it: a line with
+ * the same text at the same address, whose labels still point where they did, keeps its words
+ * without being encoded again. Returns FALSE if there were any errors, in which case the last
+ * program that assembled is kept */
+bool_t assembler_assemble(assembler_p, const char *source, size_t length);
+
+/** Gets the program from the last assembly: where it goes and the words that go there */
+word_t assembler_get_origin(assembler_p);
+const word_t *assembler_get_words(assembler_p);
+size_t assembler_get_count(assembler_p);
+
+/** Gets the addresses of the words the last assembly changed from the program before it, in
+ * address order. Words only the program before had aren't included. Empty after the first
+ * assembly, since there was nothing to compare with */
+const word_t *assembler_get_changes(assembler_p, size_t *count);
+
+/** Looks up the address of a label. Labels are matched without regard to case */
+bool_t assembler_lookup(assembler_p, const char *name, word_t *address);
+
+/** Writes the errors from the last assembly, one "<file>:<line>: <message>" per line */
+void assembler_write_errors(assembler_p, const char *file_name, FILE *);
+
+/** Writes a listing of the last assembly: for each word its address, value in hex and binary,
+ * source line number, label and instruction */
+void assembler_write_listing(assembler_p, FILE *);
+
+#endif
@@ -0,0 +1,578 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Batch Module File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#include "batch.h"
+#include "arena.h"
+#include "lc3.h"
+#include "loader.h"
+#include "lockstep.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/** How many characters of a job's note the results file keeps */
+#define BATCH_NOTE_SIZE 64
+
+/** One line of the manifest, and what became of it */
+typedef struct batch_job_t {
+    char program[FILENAME_SIZE];
+    char input[FILENAME_SIZE];
+    char expected[FILENAME_SIZE];
+
+    int status;
+    unsigned long instructions;
+    long long time_ns;
+    char note[BATCH_NOTE_SIZE];
+} batch_job_t;
+
+/** The range of units a worker has left. The owner takes units from the head and thieves take
+ * from the tail, both under the lock, which is only contended when a worker runs dry. Each
+ * deque gets its own cache line so workers taking units don't slow each other down */
+typedef struct batch_deque_t {
+    _Alignas(64) pthread_mutex_t lock;
+    int head;
+    int tail;
+} batch_deque_t;
+
+/** Console buffers for the job a worker is running. Input is read from memory, output is
+ * collected in a buffer that grows as needed and is kept from one job to the next */
+typedef struct batch_console_t {
+    char *input;
+    size_t input_length;
+    size_t input_position;
+    bool_t input_exhausted;
+
+    char *output;
+    size_t output_length;
+    size_t output_capacity;
+} batch_console_t;
+
+typedef struct batch_t *batch_p;
+
+/** A worker thread with an LC3 and console for each lane it runs. Without lockstep a worker
+ * only uses the first */
+typedef struct batch_worker_t {
+    batch_p batch;
+    int index;
+    pthread_t thread;
+    lc3_p lc3s[LOCKSTEP_LANES];
+    batch_console_t consoles[LOCKSTEP_LANES];
+} batch_worker_t;
+
+/** Everything the workers share. Work is handed out in units: one job each normally, or the
+ * jobs of one lockstep group. Unit i is made of the jobs listed in unit_jobs from
+ * unit_starts[i] up to unit_starts[i + 1] */
+typedef struct batch_t {
+    batch_job_t *jobs;
+    int job_count;
+    engine_t engine;
+    bool_t lockstep;
+    int lanes;
+
+    int *unit_jobs;
+    int *unit_starts;
+    int unit_count;
+
+    int worker_count;
+    batch_worker_t *workers;
+    batch_deque_t *deques;
+    arena_p arena;
+} batch_t;
+
+/** Reads the manifest into an array of jobs. Returns NULL if the manifest couldn't be read */
+batch_job_t *batch_read_manifest(char *manifest_name, int *job_count);
+
+/** Copies one of a manifest line's paths into the job. Returns FALSE, with the job marked as
+ * an error, if the path doesn't fit */
+bool_t batch_copy_path(batch_job_t *, char *destination, const char *path, const char *what);
+
+/** Splits the jobs into units. With lockstep, jobs running the same program are grouped in
+ * manifest order, up to one per lane */
+void batch_make_units(batch_p);
+
+/** A worker thread's main loop */
+void *batch_worker_main(void *);
+
+/** Takes the next unit for the worker, stealing one if its own deque is empty. Returns FALSE
+ * once there are no units left anywhere */
+bool_t batch_take_unit(batch_worker_t *, int *unit);
+
+/** Moves the back half of another worker's units into the worker's own deque. Returns
+ * whether there was anything to steal */
+bool_t batch_steal(batch_worker_t *);
+
+/** Runs the jobs of one unit on the worker's LC3s and records their outcomes */
+void batch_run_unit(batch_worker_t *, int unit);
+
+/** Loads a job's program and input into an LC3. Returns FALSE, with the job marked as an
+ * error, if either couldn't be read */
+bool_t batch_start_job(batch_job_t *, lc3_p, batch_console_t *);
+
+/** Records the outcome of a job once its LC3 has stopped */
+void batch_finish_job(batch_job_t *, lc3_p, batch_console_t *);
+
+/** Reads a whole file into a new buffer. Returns FALSE if it couldn't be read */
+bool_t batch_read_file(char *file_name, char **data, size_t *length);
+
+/** Console routines for batch jobs */
+int batch_get_char(void *);
+void batch_put_char(void *, char);
+
+/** Writes the results of every job, in manifest order */
+bool_t batch_write_results(batch_p, char *results_name, long long time_ns);
+
+/** Names a job status for the results file */
+const char *batch_status_name(int status);
+
+/** Runs every job in the manifest and writes one combined results file */
+int batch_run(char *manifest_name, char *results_name, engine_t engine, int threads,
+              bool_t lockstep) {
+    batch_t batch;
+    batch.jobs = batch_read_manifest(manifest_name, &batch.job_count);
+    if (batch.jobs == NULL) {
+        fprintf(stderr, "Could not read batch manifest: %s\n", manifest_name);
+        return EXIT_FAILURE;
+    }
+    batch.lockstep = lockstep;
+    batch.lanes = (lockstep == TRUE) ? LOCKSTEP_LANES : 1;
+    batch_make_units(&batch);
+    if (threads <= 0) {
+        threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (threads > batch.unit_count) {
+        threads = batch.unit_count;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+    batch.engine = engine;
+    batch.worker_count = threads;
+    batch.workers = calloc(threads, sizeof(batch_worker_t));
+    batch.deques =
+        aligned_alloc(ARENA_ALIGNMENT, ARENA_ROUND_UP(threads * sizeof(batch_deque_t)));
+    batch.arena = arena_create(lc3_size(), threads * batch.lanes);
+    if (batch.workers == NULL || batch.deques == NULL || batch.arena == NULL) {
+        fprintf(stderr, "Could not allocate %d batch workers\n", threads);
+        exit(EXIT_FAILURE);
+    }
+
+    /** Deal the units out in contiguous runs; stealing evens things out from there */
+    long long start = get_time_ns();
+    int i;
+    int lane;
+    for (i = 0; i < threads; i++) {
+        batch_deque_t *deque = &batch.deques[i];
+        pthread_mutex_init(&deque->lock, NULL);
+        deque->head = (int)((long long)batch.unit_count * i / threads);
+        deque->tail = (int)((long long)batch.unit_count * (i + 1) / threads);
+
+        batch_worker_t *worker = &batch.workers[i];
+        worker->batch = &batch;
+        worker->index = i;
+        for (lane = 0; lane < batch.lanes; lane++) {
+            worker->lc3s[lane] = lc3_create_in_arena(batch.arena);
+        }
+    }
+    for (i = 0; i < threads; i++) {
+        pthread_create(&batch.workers[i].thread, NULL, batch_worker_main, &batch.workers[i]);
+    }
+    for (i = 0; i < threads; i++) {
+        pthread_join(batch.workers[i].thread, NULL);
+    }
+    long long time_ns = get_time_ns() - start;
+
+    bool_t written = batch_write_results(&batch, results_name, time_ns);
+
+    int passed = 0;
+    for (i = 0; i < batch.job_count; i++) {
+        if (batch.jobs[i].status == BATCH_PASS) {
+            passed++;
+        }
+    }
+    printf("%d of %d jobs passed in %.3f s on %d threads\n", passed, batch.job_count,
+           time_ns / 1e9, threads);
+
+    for (i = 0; i < threads; i++) {
+        for (lane = 0; lane < batch.lanes; lane++) {
+            lc3_destroy(batch.workers[i].lc3s[lane]);
+            free(batch.workers[i].consoles[lane].output);
+        }
+        pthread_mutex_destroy(&batch.deques[i].lock);
+    }
+    arena_destroy(batch.arena);
+    free(batch.deques);
+    free(batch.workers);
+    free(batch.unit_starts);
+    free(batch.unit_jobs);
+    free(batch.jobs);
+
+    if (written == FALSE) {
+        fprintf(stderr, "Could not write batch results: %s\n", results_name);
+        return EXIT_FAILURE;
+    }
+    return (passed == batch.job_count) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/** Reads the manifest into an array of jobs. Returns NULL if the manifest couldn't be read */
+batch_job_t *batch_read_manifest(char *manifest_name, int *job_count) {
+    FILE *file = fopen(manifest_name, "r");
+    if (file == NULL) {
+        return NULL;
+    }
+    int capacity = 16;
+    batch_job_t *jobs = malloc(capacity * sizeof(batch_job_t));
+    *job_count = 0;
+
+    /** Whole lines, however long, so a long one can't spill over into a job of its own */
+    char *line = NULL;
+    size_t line_capacity = 0;
+    while (getline(&line, &line_capacity, file) != -1) {
+        char *program = strtok(line, " \t\r\n");
+        if (program == NULL || program[0] == '#') {
+            continue;
+        }
+        char *input = strtok(NULL, " \t\r\n");
+        char *expected = (input == NULL) ? NULL : strtok(NULL, " \t\r\n");
+
+        if (*job_count == capacity) {
+            capacity *= 2;
+            jobs = realloc(jobs, capacity * sizeof(batch_job_t));
+        }
+        batch_job_t *job = &jobs[(*job_count)++];
+        memset(job, 0, sizeof(batch_job_t));
+        /** A path that doesn't fit is reported rather than cut short, which could run some
+         * other file. Its job is never started */
+        if (batch_copy_path(job, job->program, program, "program") == TRUE &&
+            batch_copy_path(job, job->input, (input == NULL) ? BATCH_NO_FILE : input,
+                            "input") == TRUE) {
+            batch_copy_path(job, job->expected, (expected == NULL) ? BATCH_NO_FILE : expected,
+                            "expected output");
+        }
+    }
+    free(line);
+    fclose(file);
+    return jobs;
+}
+
+/** Copies one of a manifest line's paths into the job */
+bool_t batch_copy_path(batch_job_t *job, char *destination, const char *path,
+                       const char *what) {
+    if (strlen(path) < FILENAME_SIZE) {
+        strcpy(destination, path);
+        return TRUE;
+    }
+    /* The results file still needs something to name the job by */
+    if (destination == job->program) {
+        snprintf(job->program, FILENAME_SIZE, "%.*s...", FILENAME_SIZE - 4, path);
+    }
+    job->status = BATCH_ERROR;
+    snprintf(job->note, BATCH_NOTE_SIZE, "%s path longer than %d characters", what,
+             FILENAME_SIZE - 1);
+    return FALSE;
+}
+
+/** Splits the jobs into units, grouping jobs that run the same program when in lockstep */
+void batch_make_units(batch_p batch) {
+    batch->unit_jobs = malloc((batch->job_count + 1) * sizeof(int));
+    batch->unit_starts = malloc((batch->job_count + 1) * sizeof(int));
+    bool_t *grouped = calloc(batch->job_count + 1, sizeof(bool_t));
+    batch->unit_count = 0;
+    int next = 0;
+    int i;
+    int j;
+    for (i = 0; i < batch->job_count; i++) {
+        if (grouped[i] == TRUE) {
+            continue;
+        }
+        batch->unit_starts[batch->unit_count++] = next;
+        int size = 0;
+        for (j = i; j < batch->job_count && size < batch->lanes; j++) {
+            if (grouped[j] == FALSE &&
+                strcmp(batch->jobs[j].program, batch->jobs[i].program) == 0) {
+                grouped[j] = TRUE;
+                batch->unit_jobs[next++] = j;
+                size++;
+            }
+        }
+    }
+    batch->unit_starts[batch->unit_count] = next;
+    free(grouped);
+}
+
+/** A worker thread's main loop */
+void *batch_worker_main(void *context) {
+    batch_worker_t *worker = context;
+    int unit;
+    while (batch_take_unit(worker, &unit) == TRUE) {
+        batch_run_unit(worker, unit);
+    }
+    return NULL;
+}
+
+/** Takes the next unit for the worker, stealing if its own deque is empty */
+bool_t batch_take_unit(batch_worker_t *worker, int *unit) {
+    batch_deque_t *deque = &worker->batch->deques[worker->index];
+    do {
+        pthread_mutex_lock(&deque->lock);
+        bool_t found = (deque->head < deque->tail) ? TRUE : FALSE;
+        if (found == TRUE) {
+            *unit = deque->head++;
+        }
+        pthread_mutex_unlock(&deque->lock);
+        if (found == TRUE) {
+            return TRUE;
+        }
+    } while (batch_steal(worker) == TRUE);
+    return FALSE;
+}
+/** Moves the back half of another worker's units into the worker's own deque, starting with
+ * the next worker along so thieves spread out over their victims */
+bool_t batch_steal(batch_worker_t *worker) {
+    batch_p batch = worker->batch;
+    int i;
+    for (i = 1; i < batch->worker_count; i++) {
+        batch_deque_t *victim = &batch->deques[(worker->index + i) % batch->worker_count];
+        pthread_mutex_lock(&victim->lock);
+        int remaining = victim->tail - victim->head;
+        int head = victim->tail - (remaining + 1) / 2;
+        int tail = victim->tail;
+        if (remaining > 0) {
+            victim->tail = head;
+        }
+        pthread_mutex_unlock(&victim->lock);
+        if (remaining > 0) {
+            batch_deque_t *deque = &batch->deques[worker->index];
+            pthread_mutex_lock(&deque->lock);
+            deque->head = head;
+            deque->tail = tail;
+            pthread_mutex_unlock(&deque->lock);
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/** Runs the jobs of one unit on the worker's LC3s, one lane per job, and records their
+ * outcomes. Jobs in a lockstep group all get the time the whole group took */
+void batch_run_unit(batch_worker_t *worker, int unit) {
+    batch_p batch = worker->batch;
+    long long start = get_time_ns();
+    batch_job_t *jobs[LOCKSTEP_LANES];
+    lc3_p lanes[LOCKSTEP_LANES];
+    console_t consoles[LOCKSTEP_LANES];
+    console_p lane_consoles[LOCKSTEP_LANES];
+    unsigned long instructions[LOCKSTEP_LANES];
+    int lane_count = 0;
+    int i;
+    for (i = batch->unit_starts[unit]; i < batch->unit_starts[unit + 1]; i++) {
+        batch_job_t *job = &batch->jobs[batch->unit_jobs[i]];
+        lc3_p lc3 = worker->lc3s[lane_count];
+        batch_console_t *console = &worker->consoles[lane_count];
+        lc3_reset(lc3);
+        if (batch_start_job(job, lc3, console) == TRUE) {
+            jobs[lane_count] = job;
+            lanes[lane_count] = lc3;
+            consoles[lane_count] = (console_t){.get_char = batch_get_char,
+                                               .poll_char = NULL,
+                                               .put_char = batch_put_char,
+                                               .context = console,
+                                               .instructions = 0};
+            lane_consoles[lane_count] = &consoles[lane_count];
+            instructions[lane_count] = 0;
+            lane_count++;
+        }
+    }
+    if (lane_count == 0) {
+        return;
+    }
+
+    if (batch->lockstep == TRUE) {
+        lockstep_run(lanes, lane_consoles, lane_count, BATCH_INSTRUCTION_LIMIT, instructions);
+    } else {
+        /** Headless jobs use the fast engine unless told otherwise, as in --headless */
+        engine_t engine = (batch->engine == ENGINE_DEFAULT) ? ENGINE_FAST : batch->engine;
+        while (lc3_is_halted(lanes[0]) == FALSE && instructions[0] < BATCH_INSTRUCTION_LIMIT) {
+            instructions[0] += execute(lanes[0], lane_consoles[0], engine,
+                                       BATCH_INSTRUCTION_LIMIT - instructions[0]);
+        }
+    }
+
+    long long time_ns = get_time_ns() - start;
+    for (i = 0; i < lane_count; i++) {
+        jobs[i]->instructions = instructions[i];
+        jobs[i]->time_ns = time_ns;
+        batch_finish_job(jobs[i], lanes[i], lane_consoles[i]->context);
+    }
+}
+
+/** Loads a job's program and input into an LC3 */
+bool_t batch_start_job(batch_job_t *job, lc3_p lc3, batch_console_t *console) {
+    /** Jobs start out as BATCH_PASS, so one already marked an error had a bad manifest line */
+    if (job->status == BATCH_ERROR) {
+        return FALSE;
+    }
+    console->output_length = 0;
+    console->input = NULL;
+    console->input_length = 0;
+    console->input_position = 0;
+    console->input_exhausted = FALSE;
+
+    loader_result_t loaded = loader_load(lc3, job->program);
+    if (loaded != LOADER_OK) {
+        job->status = BATCH_ERROR;
+        snprintf(job->note, BATCH_NOTE_SIZE, "program: %s", loader_describe(loaded));
+        return FALSE;
+    }
+    if (strcmp(job->input, BATCH_NO_FILE) != 0 &&
+        batch_read_file(job->input, &console->input, &console->input_length) == FALSE) {
+        job->status = BATCH_ERROR;
+        snprintf(job->note, BATCH_NOTE_SIZE, "input not found");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/** Records the outcome of a job once its LC3 has stopped, comparing the output it collected
+ * against the expected output */
+void batch_finish_job(batch_job_t *job, lc3_p lc3, batch_console_t *console) {
+    free(console->input);
+
+    if (lc3_is_halted(lc3) == FALSE) {
+        job->status = BATCH_TIMEOUT;
+        snprintf(job->note, BATCH_NOTE_SIZE, "no HALT after %lu instructions",
+                 BATCH_INSTRUCTION_LIMIT);
+    } else if (strcmp(job->expected, BATCH_NO_FILE) == 0) {
+        job->status = BATCH_PASS;
+    } else {
+        char *expected;
+        size_t expected_length;
+        if (batch_read_file(job->expected, &expected, &expected_length) == FALSE) {
+            job->status = BATCH_ERROR;
+            snprintf(job->note, BATCH_NOTE_SIZE, "expected output not found");
+        } else {
+            size_t i = 0;
+            while (i < expected_length && i < console->output_length &&
+                   expected[i] == console->output[i]) {
+                i++;
+            }
+            if (i == expected_length && i == console->output_length) {
+                job->status = BATCH_PASS;
+            } else {
+                job->status = BATCH_FAIL;
+                snprintf(job->note, BATCH_NOTE_SIZE, "output differs at byte %zu", i);
+            }
+            free(expected);
+        }
+    }
+    if (job->status == BATCH_PASS && console->input_exhausted == TRUE) {
+        snprintf(job->note, BATCH_NOTE_SIZE, "halted at end of input");
+    }
+}
+
+/** Reads a whole file into a new buffer. Returns FALSE if it couldn't be read */
+bool_t batch_read_file(char *file_name, char **data, size_t *length) {
+    FILE *file = fopen(file_name, "rb");
+    if (file == NULL) {
+        return FALSE;
+    }
+    size_t capacity = 256;
+    *data = malloc(capacity);
+    *length = 0;
+    size_t count;
+    while ((count = fread(*data + *length, 1, capacity - *length, file)) > 0) {
+        *length += count;
+        if (*length == capacity) {
+            capacity *= 2;
+            *data = realloc(*data, capacity);
+        }
+    }
+    fclose(file);
+    return TRUE;
+}
+
+/** Reads a character of console input from the job's input file */
+int batch_get_char(void *context) {
+    batch_console_t *console = context;
+    if (console->input_position == console->input_length) {
+        console->input_exhausted = TRUE;
+        return EOF;
+    }
+    return (unsigned char)console->input[console->input_position++];
+}
+
+/** Collects a character of console output to compare once the job halts */
+void batch_put_char(void *context, char c) {
+    batch_console_t *console = context;
+    if (console->output_length == console->output_capacity) {
+        console->output_capacity =
+            (console->output_capacity == 0) ? 256 : console->output_capacity * 2;
+        console->output = realloc(console->output, console->output_capacity);
+    }
+    console->output[console->output_length++] = c;
+}
+
+/** Writes the results of every job, in manifest order, followed by a summary line */
+bool_t batch_write_results(batch_p batch, char *results_name, long long time_ns) {
+    FILE *file = fopen(results_name, "w");
+    if (file == NULL) {
+        return FALSE;
+    }
+    int counts[BATCH_ERROR + 1] = {0};
+    unsigned long instructions = 0;
+    int i;
+    for (i = 0; i < batch->job_count; i++) {
+        batch_job_t *job = &batch->jobs[i];
+        fprintf(file, "%-8s %12lu %10.3f ms  %s", batch_status_name(job->status),
+                job->instructions, job->time_ns / 1e6, job->program);
+        if (job->note[0] != '\0') {
+            fprintf(file, "  (%s)", job->note);
+        }
+        fprintf(file, "\n");
+        counts[job->status]++;
+        instructions += job->instructions;
+    }
+    fprintf(file, "# %d jobs: %d passed, %d failed, %d timed out, %d errors; %lu instructions "
+                  "in %.3f s on %d threads\n",
+            batch->job_count, counts[BATCH_PASS], counts[BATCH_FAIL], counts[BATCH_TIMEOUT],
+            counts[BATCH_ERROR], instructions, time_ns / 1e9, batch->worker_count);
+    fclose(file);
+    return TRUE;
+}
+
+/** Names a job status for the results file */
+const char *batch_status_name(int status) {
+    switch (status) {
+    case BATCH_PASS:
+        return "PASS";
+    case BATCH_FAIL:
+        return "FAIL";
+    case BATCH_TIMEOUT:
+        return "TIMEOUT";
+    default:
+        return "ERROR";
+    }
+}
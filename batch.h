@@ -0,0 +1,66 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Batch Module Header File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "global.h"
+#include "slc3.h"
+
+/** Command line word that selects batch mode, the flag for the number of workers and the flag
+ * that runs jobs with the same program together in lockstep */
+#define BATCH_COMMAND "batch"
+#define THREADS_FLAG "--threads="
+#define LOCKSTEP_FLAG "--lockstep"
+
+/** Where the results go if no results file is named */
+#define BATCH_RESULTS_DEFAULT "batch_results.txt"
+
+/** Stands in the manifest for a job with no input or no expected output */
+#define BATCH_NO_FILE "-"
+
+/** A job that hasn't halted after this many instructions is recorded as timed out, so one
+ * runaway program can't hold up the whole batch */
+#define BATCH_INSTRUCTION_LIMIT 100000000UL
+
+/** Job outcomes */
+#define BATCH_PASS 0    /* Halted, and the output matched (or there was nothing to match) */
+#define BATCH_FAIL 1    /* Halted, but the output didn't match */
+#define BATCH_TIMEOUT 2 /* Ran out of instructions before halting */
+#define BATCH_ERROR 3   /* The program, input or expected output couldn't be read */
+
+/** Runs every job in the manifest and writes one combined results file. Each manifest line
+ * names a hex program, a file to feed GETC and a file the console output must match, with
+ * BATCH_NO_FILE for either of the last two; blank lines and lines starting with # are skipped.
+ * The jobs are spread over the given number of worker threads (one per core if 0), each
+ * with an LC3 of its own that is reset between jobs. With lockstep set, jobs that run the same
+ * program are grouped up to LOCKSTEP_LANES at a time and each group runs on lockstep_run
+ * instead of the selected engine. Returns the process exit status, which is only EXIT_SUCCESS
+ * if every job passed */
+int batch_run(char *manifest_name, char *results_name, engine_t engine, int threads,
+              bool_t lockstep);
+
+#endif
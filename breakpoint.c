@@ -0,0 +1,335 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Breakpoint Module File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#include "breakpoint.h"
+#include "lc3.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Tests, sets and clears the bit for an address in a bitmap */
+#define BREAKPOINT_TEST(bitmap, address)                                                      \
+    (((bitmap)[(address) / BREAKPOINT_BITS] >> ((address) % BREAKPOINT_BITS)) & 1)
+#define BREAKPOINT_SET(bitmap, address)                                                       \
+    ((bitmap)[(address) / BREAKPOINT_BITS] |= 1ULL << ((address) % BREAKPOINT_BITS))
+#define BREAKPOINT_CLEAR(bitmap, address)                                                     \
+    ((bitmap)[(address) / BREAKPOINT_BITS] &= ~(1ULL << ((address) % BREAKPOINT_BITS)))
+
+typedef struct breakpoints_t {
+    unsigned long long execute[BREAKPOINT_WORDS];
+    unsigned long long read[BREAKPOINT_WORDS];
+    unsigned long long write[BREAKPOINT_WORDS];
+    /** Breakpoints and watched words set, so breakpoints_armed doesn't scan the bitmaps */
+    int breakpoint_count;
+    int watch_count;
+
+    /** Conditions of the conditional breakpoints. Only looked up when the PC lands on a set
+     * bit, so a short list is fine */
+    word_t condition_addresses[BREAKPOINT_CONDITIONS_MAX];
+    breakpoint_condition_t conditions[BREAKPOINT_CONDITIONS_MAX];
+    int condition_count;
+
+    bool_t is_resuming;
+    word_t resume_pc;
+    int hit;
+} breakpoints_t;
+
+/** Finds the condition for a breakpoint. Returns its index, or -1 if it has none */
+int breakpoints_find_condition(breakpoints_p, word_t address);
+
+/** Returns whether a condition holds for the given registers and memory */
+bool_t breakpoints_condition_holds(const breakpoint_condition_t *, memory_p,
+                                   const word_t *registers);
+
+/** Gets the value of one side of a condition */
+word_t breakpoints_operand_value(const breakpoint_operand_t *, memory_p,
+                                 const word_t *registers);
+
+/** Returns whether the instruction reads or writes a watched word */
+bool_t breakpoints_touches_watch(breakpoints_p, memory_p, const decoded_t *, word_t pc,
+                                 const word_t *registers);
+
+/** Parses one side of a condition. Returns the text after it, or NULL if it doesn't parse */
+const char *breakpoint_parse_operand(const char *, breakpoint_operand_t *);
+
+/** Allocates an empty set of breakpoints and watchpoints */
+breakpoints_p breakpoints_create() { return calloc(1, sizeof(breakpoints_t)); }
+
+/** Deallocates the breakpoints */
+void breakpoints_destroy(breakpoints_p breakpoints) { free(breakpoints); }
+
+/** Returns whether any breakpoint or watchpoint is set */
+bool_t breakpoints_armed(breakpoints_p breakpoints) {
+    return breakpoints->breakpoint_count > 0 || breakpoints->watch_count > 0;
+}
+
+/** Sets or unsets the breakpoint at the address */
+void breakpoints_set(breakpoints_p breakpoints, word_t address, bool_t is_set) {
+    int index = breakpoints_find_condition(breakpoints, address);
+    if (index >= 0) {
+        breakpoints->condition_count--;
+        breakpoints->condition_addresses[index] =
+            breakpoints->condition_addresses[breakpoints->condition_count];
+        breakpoints->conditions[index] = breakpoints->conditions[breakpoints->condition_count];
+    }
+    if (BREAKPOINT_TEST(breakpoints->execute, address) == is_set) {
+        return;
+    }
+    if (is_set == TRUE) {
+        BREAKPOINT_SET(breakpoints->execute, address);
+        breakpoints->breakpoint_count++;
+    } else {
+        BREAKPOINT_CLEAR(breakpoints->execute, address);
+        breakpoints->breakpoint_count--;
+    }
+}
+
+/** Sets a breakpoint at the address that only stops when the condition holds */
+bool_t breakpoints_set_condition(breakpoints_p breakpoints, word_t address,
+                                 const breakpoint_condition_t *condition) {
+    int index = breakpoints_find_condition(breakpoints, address);
+    if (index < 0) {
+        if (breakpoints->condition_count == BREAKPOINT_CONDITIONS_MAX) {
+            return FALSE;
+        }
+        breakpoints_set(breakpoints, address, TRUE);
+        index = breakpoints->condition_count++;
+        breakpoints->condition_addresses[index] = address;
+    }
+    breakpoints->conditions[index] = *condition;
+    return TRUE;
+}
+
+/** Watches the word at the address for the given kinds of access */
+void breakpoints_set_watch(breakpoints_p breakpoints, word_t address, int kinds) {
+    bool_t was_watched = BREAKPOINT_TEST(breakpoints->read, address) ||
+                         BREAKPOINT_TEST(breakpoints->write, address);
+    BREAKPOINT_CLEAR(breakpoints->read, address);
+    BREAKPOINT_CLEAR(breakpoints->write, address);
+    if (kinds & BREAKPOINT_READ) {
+        BREAKPOINT_SET(breakpoints->read, address);
+    }
+    if (kinds & BREAKPOINT_WRITE) {
+        BREAKPOINT_SET(breakpoints->write, address);
+    }
+    breakpoints->watch_count += (kinds != 0) - was_watched;
+}
+
+/** Returns whether there is a breakpoint at the address */
+bool_t breakpoints_is_set(breakpoints_p breakpoints, word_t address) {
+    return BREAKPOINT_TEST(breakpoints->execute, address);
+}
+
+/** Lets the instruction at pc run past its breakpoint the next time it's checked */
+void breakpoints_resume(breakpoints_p breakpoints, word_t pc) {
+    breakpoints->is_resuming = TRUE;
+    breakpoints->resume_pc = pc;
+    breakpoints->hit = BREAKPOINT_NONE;
+}
+
+/** Checks the instruction at pc before it runs. The breakpoint bit is tested first since it's
+ * the common case; the condition and the instruction's memory accesses are only worked out
+ * when there is something there to find */
+int breakpoints_check(breakpoints_p breakpoints, memory_p memory, word_t pc,
+                      const word_t *registers) {
+    bool_t is_resuming = breakpoints->is_resuming && breakpoints->resume_pc == pc;
+    breakpoints->is_resuming = FALSE;
+    if (is_resuming == FALSE && BREAKPOINT_TEST(breakpoints->execute, pc)) {
+        int index = breakpoints_find_condition(breakpoints, pc);
+        if (index < 0 ||
+            breakpoints_condition_holds(&breakpoints->conditions[index], memory, registers)) {
+            breakpoints->hit = BREAKPOINT_BEFORE;
+            return BREAKPOINT_BEFORE;
+        }
+    }
+    if (breakpoints->watch_count > 0 &&
+        breakpoints_touches_watch(breakpoints, memory, memory_get_decoded(memory, pc), pc,
+                                  registers)) {
+        breakpoints->hit = BREAKPOINT_AFTER;
+        return BREAKPOINT_AFTER;
+    }
+    return BREAKPOINT_NONE;
+}
+
+/** Gets what the last hit was */
+int breakpoints_get_hit(breakpoints_p breakpoints) { return breakpoints->hit; }
+
+/** Parses a condition of the form "<operand> <comparison> <operand>" */
+bool_t breakpoint_parse_condition(const char *text, breakpoint_condition_t *condition) {
+    /** Two-character comparisons come first so "<=" isn't read as "<" */
+    static const char *comparisons[BREAKPOINT_COMPARISONS] = {"==", "!=", "<=", ">=", "<", ">"};
+    static const int codes[BREAKPOINT_COMPARISONS] = {
+        BREAKPOINT_EQUAL,         BREAKPOINT_NOT_EQUAL, BREAKPOINT_LESS_EQUAL,
+        BREAKPOINT_GREATER_EQUAL, BREAKPOINT_LESS,      BREAKPOINT_GREATER};
+    text = breakpoint_parse_operand(text, &condition->left);
+    if (text == NULL) {
+        return FALSE;
+    }
+    while (isspace((unsigned char)*text)) {
+        text++;
+    }
+    int i;
+    for (i = 0; i < BREAKPOINT_COMPARISONS; i++) {
+        if (strncmp(text, comparisons[i], strlen(comparisons[i])) == 0) {
+            break;
+        }
+    }
+    if (i == BREAKPOINT_COMPARISONS) {
+        return FALSE;
+    }
+    condition->comparison = codes[i];
+    text = breakpoint_parse_operand(text + strlen(comparisons[i]), &condition->right);
+    if (text == NULL) {
+        return FALSE;
+    }
+    while (isspace((unsigned char)*text)) {
+        text++;
+    }
+    return *text == '\0';
+}
+
+/** Finds the condition for a breakpoint */
+int breakpoints_find_condition(breakpoints_p breakpoints, word_t address) {
+    int i;
+    for (i = 0; i < breakpoints->condition_count; i++) {
+        if (breakpoints->condition_addresses[i] == address) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/** Returns whether a condition holds for the given registers and memory */
+bool_t breakpoints_condition_holds(const breakpoint_condition_t *condition, memory_p memory,
+                                   const word_t *registers) {
+    short left = (short)breakpoints_operand_value(&condition->left, memory, registers);
+    short right = (short)breakpoints_operand_value(&condition->right, memory, registers);
+    switch (condition->comparison) {
+    case BREAKPOINT_EQUAL:
+        return left == right;
+    case BREAKPOINT_NOT_EQUAL:
+        return left != right;
+    case BREAKPOINT_LESS:
+        return left < right;
+    case BREAKPOINT_LESS_EQUAL:
+        return left <= right;
+    case BREAKPOINT_GREATER:
+        return left > right;
+    default:
+        return left >= right;
+    }
+}
+
+/** Gets the value of one side of a condition */
+word_t breakpoints_operand_value(const breakpoint_operand_t *operand, memory_p memory,
+                                 const word_t *registers) {
+    word_t value = operand->is_register ? registers[operand->value] : operand->value;
+    return operand->is_indirect ? memory_peek(memory, value) : value;
+}
+
+/** Returns whether the instruction reads or writes a watched word. Works out the same
+ * addresses the engines use: pc is the address of the instruction itself, not the
+ * incremented PC its offsets are relative to. The fetch of the instruction doesn't count as a
+ * read, and neither does PUTS reading the string */
+bool_t breakpoints_touches_watch(breakpoints_p breakpoints, memory_p memory,
+                                 const decoded_t *d, word_t pc, const word_t *registers) {
+    word_t next_pc = pc + 1;
+    word_t address;
+    switch (d->opcode) {
+    case OPCODE_LD:
+        return BREAKPOINT_TEST(breakpoints->read, (word_t)(next_pc + d->pc_offset_9));
+    case OPCODE_LDR:
+        return BREAKPOINT_TEST(breakpoints->read, (word_t)(registers[d->sr1] + d->pc_offset_6));
+    case OPCODE_LDI:
+        address = next_pc + d->pc_offset_9;
+        if (BREAKPOINT_TEST(breakpoints->read, address)) {
+            return TRUE;
+        }
+        return BREAKPOINT_TEST(breakpoints->read, memory_peek(memory, address));
+    case OPCODE_ST:
+        return BREAKPOINT_TEST(breakpoints->write, (word_t)(next_pc + d->pc_offset_9));
+    case OPCODE_STR:
+        return BREAKPOINT_TEST(breakpoints->write,
+                               (word_t)(registers[d->sr1] + d->pc_offset_6));
+    case OPCODE_STI:
+        address = next_pc + d->pc_offset_9;
+        if (BREAKPOINT_TEST(breakpoints->read, address)) {
+            return TRUE;
+        }
+        return BREAKPOINT_TEST(breakpoints->write, memory_peek(memory, address));
+    case OPCODE_STACK:
+        /** A push or pop that fails on a full or empty stack doesn't touch memory */
+        address = registers[R6];
+        if (d->imm_mode == STACK_PUSH) {
+            return address >= STACK_MAX &&
+                   BREAKPOINT_TEST(breakpoints->write, (word_t)(address - 1));
+        }
+        return address <= STACK_LAST && BREAKPOINT_TEST(breakpoints->read, address);
+    default:
+        return FALSE;
+    }
+}
+
+/** Parses one side of a condition */
+const char *breakpoint_parse_operand(const char *text, breakpoint_operand_t *operand) {
+    char *end;
+    while (isspace((unsigned char)*text)) {
+        text++;
+    }
+    operand->is_indirect = (*text == '[');
+    if (operand->is_indirect) {
+        text++;
+        while (isspace((unsigned char)*text)) {
+            text++;
+        }
+    }
+    operand->is_register = FALSE;
+    if ((*text == 'R' || *text == 'r') && text[1] >= '0' && text[1] < '0' + REGISTER_SIZE) {
+        operand->is_register = TRUE;
+        operand->value = text[1] - '0';
+        end = (char *)text + 2;
+    } else if (*text == 'x' || *text == 'X') {
+        operand->value = (word_t)strtol(text + 1, &end, 16);
+        end = (end == text + 1) ? NULL : end;
+    } else {
+        const char *digits = (*text == '#') ? text + 1 : text;
+        operand->value = (word_t)strtol(digits, &end, 10);
+        end = (end == digits) ? NULL : end;
+    }
+    if (end == NULL) {
+        return NULL;
+    }
+    if (operand->is_indirect) {
+        while (isspace((unsigned char)*end)) {
+            end++;
+        }
+        if (*end != ']') {
+            return NULL;
+        }
+        end++;
+    }
+    return end;
+}
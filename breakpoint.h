@@ -0,0 +1,121 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Breakpoint Module Header File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#ifndef BREAKPOINT_H
+#define BREAKPOINT_H
+
+#include "global.h"
+#include "memory.h"
+
+/** Addresses are kept as bitmaps, one bit per word of memory */
+#define BREAKPOINT_BITS 64
+#define BREAKPOINT_WORDS (MEMORY_SIZE / BREAKPOINT_BITS)
+
+/** How many conditional breakpoints can be set at once */
+#define BREAKPOINT_CONDITIONS_MAX 64
+
+/** Kinds of access a watchpoint stops on. They can be combined */
+#define BREAKPOINT_READ 1
+#define BREAKPOINT_WRITE 2
+
+/** What breakpoints_check found */
+#define BREAKPOINT_NONE 0
+#define BREAKPOINT_BEFORE 1 /* A breakpoint: stop before the instruction runs */
+#define BREAKPOINT_AFTER 2  /* The instruction touches a watched word: stop once it has run */
+
+/** Comparisons a condition can make. Both sides are compared as signed 16-bit values */
+#define BREAKPOINT_EQUAL 0
+#define BREAKPOINT_NOT_EQUAL 1
+#define BREAKPOINT_LESS 2
+#define BREAKPOINT_LESS_EQUAL 3
+#define BREAKPOINT_GREATER 4
+#define BREAKPOINT_GREATER_EQUAL 5
+#define BREAKPOINT_COMPARISONS 6
+
+/** One side of a condition: a register, a constant, or the word in memory at the address
+ * either of those gives */
+typedef struct breakpoint_operand_t {
+    bool_t is_register;
+    bool_t is_indirect;
+    /** The register number or the constant */
+    word_t value;
+} breakpoint_operand_t;
+
+/** A comparison that must hold for a conditional breakpoint to stop, like "R0 == x0041" or
+ * "[R6] < #0" */
+typedef struct breakpoint_condition_t {
+    breakpoint_operand_t left;
+    breakpoint_operand_t right;
+    int comparison;
+} breakpoint_condition_t;
+
+typedef struct breakpoints_t *breakpoints_p;
+
+/** Allocates an empty set of breakpoints and watchpoints */
+breakpoints_p breakpoints_create();
+
+/** Deallocates the breakpoints */
+void breakpoints_destroy(breakpoints_p);
+
+/** Returns whether any breakpoint or watchpoint is set. Engines only need to check when one
+ * is */
+bool_t breakpoints_armed(breakpoints_p);
+
+/** Sets or unsets the breakpoint at the address. Unsetting also drops its condition */
+void breakpoints_set(breakpoints_p, word_t address, bool_t is_set);
+
+/** Sets a breakpoint at the address that only stops when the condition holds. Returns FALSE
+ * if there's no room for another condition */
+bool_t breakpoints_set_condition(breakpoints_p, word_t address, const breakpoint_condition_t *);
+
+/** Watches the word at the address for the given kinds of access, or stops watching it if
+ * kinds is 0 */
+void breakpoints_set_watch(breakpoints_p, word_t address, int kinds);
+
+/** Returns whether there is a breakpoint at the address, conditional or not */
+bool_t breakpoints_is_set(breakpoints_p, word_t address);
+
+/** Lets the instruction at pc run past its breakpoint the next time it's checked, so a run or
+ * step can carry on from where a breakpoint stopped it. Also forgets the last hit */
+void breakpoints_resume(breakpoints_p, word_t pc);
+
+/** Checks the instruction at pc before it runs, given the registers and CC it will run with.
+ * Returns BREAKPOINT_BEFORE if a breakpoint (whose condition holds) is set there,
+ * BREAKPOINT_AFTER if it reads or writes a watched word, and otherwise BREAKPOINT_NONE. A hit
+ * is remembered until the next breakpoints_resume */
+int breakpoints_check(breakpoints_p, memory_p, word_t pc, const word_t *registers);
+
+/** Gets what the last hit was, or BREAKPOINT_NONE if there hasn't been one since the last
+ * breakpoints_resume */
+int breakpoints_get_hit(breakpoints_p);
+
+/** Parses a condition of the form "<operand> <comparison> <operand>". An operand is a register
+ * (R0 to R7), a number (x3000 in hex, #-1 or 12 in decimal) or either of those in square
+ * brackets for the word in memory there. The comparison is one of == != < <= > >=. Returns
+ * FALSE if the text doesn't parse */
+bool_t breakpoint_parse_condition(const char *, breakpoint_condition_t *);
+
+#endif
@@ -0,0 +1,531 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Core Module File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#include "core.h"
+#include "breakpoint.h"
+#include "device.h"
+#include "history.h"
+#include "loader.h"
+#include "replay.h"
+#include "savestate.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/** How long the core thread sleeps when it has nothing to do, and how long either side waits
+ * before checking a full or empty queue again */
+#define CORE_IDLE_NS 1000000
+
+/** Set on the middle snapshot index when it holds a snapshot the UI hasn't picked up yet */
+#define CORE_SNAPSHOT_FRESH 4
+
+/** Single producer, single consumer ring of messages. The producer only writes the tail and
+ * the consumer only writes the head, so neither needs a lock. They sit on their own cache
+ * lines so the two threads don't fight over one */
+typedef struct core_queue_t {
+    core_message_t messages[CORE_QUEUE_SIZE];
+    _Alignas(64) atomic_size_t head;
+    _Alignas(64) atomic_size_t tail;
+} core_queue_t;
+
+typedef struct core_t {
+    lc3_p lc3;
+    engine_t engine;
+    console_t console;
+    /** The console the engines are given: the core's own, or the recorder wrapped around it */
+    console_p io;
+    replay_p recorder;
+    pthread_t thread;
+    atomic_bool quit;
+
+    /** UI to core, and core to UI */
+    core_queue_t commands;
+    core_queue_t events;
+    /** Steps, runs and step backs that came in while GETC was waiting. They run once it has
+     * its character, and only count as handled then. Only the core thread touches it */
+    core_queue_t deferred;
+    atomic_ulong commands_sent;
+    atomic_ulong commands_handled;
+    /** How the last CORE_LOAD went. Written before the command is counted as handled */
+    loader_result_t load_result;
+    /** Whether the last CORE_SAVE_STATE was written, likewise */
+    bool_t save_result;
+
+    /** Published snapshots, as a triple buffer. The core owns the back buffer and the UI owns
+     * the front one; publishing swaps the back buffer with the middle one, and the UI swaps the
+     * middle one to the front when it is marked fresh. Nobody ever copies a whole snapshot:
+     * each buffer is brought up to date in place, one written page at a time */
+    lc3_snapshot_t snapshots[3];
+    atomic_int middle;
+    int back;
+    int front;
+    atomic_ulong generation;
+
+    /** State only the core thread touches */
+    bool_t running;
+    long long next_frame;
+    breakpoints_p breakpoints;
+    /** Instructions that can be stepped back through, or NULL if history is off */
+    history_p history;
+    /** The assembler that built the loaded program, and the file it came from, if it was
+     * assembled. Loading the same file again patches the program instead of restarting it */
+    assembler_p assembler;
+    char assembly_name[FILENAME_SIZE];
+    /** The keyboard and display registers. Keys come from the UI as CORE_INPUT, and the UI
+     * is told once the program starts reading them */
+    devices_p devices;
+    bool_t keyboard_reported;
+} core_t, *core_p;
+
+/** The core thread's main loop */
+void *core_main(void *);
+
+/** Carries out a command on the core thread */
+void core_handle(core_p, const core_message_t *);
+
+/** Loads an assembly file, or patches the running program if it is the one already loaded */
+void core_load_assembly(core_p, const char *file_name);
+
+/** Executes up to count instructions, recording each one in the history first if it's on */
+void core_execute(core_p, unsigned long count);
+
+/** Has the engines check the breakpoints if any are set, and skip the checks if not */
+void core_arm_breakpoints(core_p);
+
+/** Takes the instruction count back by the number of instructions just undone, forgetting
+ * any input recorded after that point */
+void core_rewind(core_p, unsigned long undone);
+
+/** Ends a step or run and tells the UI why */
+void core_stop(core_p, int reason);
+
+/** Brings the back snapshot buffer up to date and publishes it */
+void core_publish(core_p);
+
+/** Queues an event for the UI. Waits for room if the queue is full */
+void core_send_event(core_p, int type, word_t address, word_t data);
+
+/** Console routines the core hands to the engines */
+int core_console_get(void *);
+void core_console_put(void *, char);
+
+/** Ring buffer operations */
+bool_t core_queue_push(core_queue_t *, const core_message_t *);
+bool_t core_queue_pop(core_queue_t *, core_message_t *);
+
+/** Sleeps for CORE_IDLE_NS */
+void core_idle();
+
+/** Allocates a core and starts its thread */
+core_p core_create(lc3_p lc3, engine_t engine, unsigned long history_window,
+                   replay_p recorder) {
+    core_p core = calloc(1, sizeof(core_t));
+    if (history_window > 0) {
+        core->history = history_create(history_window);
+    }
+    core->front = 0;
+    core->back = 1;
+    atomic_init(&core->middle, 2);
+    core->lc3 = lc3;
+    core->engine = engine;
+    core->console.get_char = core_console_get;
+    core->console.poll_char = NULL;
+    core->console.put_char = core_console_put;
+    core->console.context = core;
+    core->io = (recorder != NULL) ? replay_attach(recorder, &core->console) : &core->console;
+    core->recorder = recorder;
+    core->breakpoints = breakpoints_create();
+    core->assembler = assembler_create();
+    core->devices = devices_create(lc3, core->io, FALSE);
+    core_publish(core);
+    pthread_create(&core->thread, NULL, core_main, core);
+    return core;
+}
+
+/** Stops the core thread and deallocates the core */
+void core_destroy(core_p core) {
+    atomic_store(&core->quit, TRUE);
+    pthread_join(core->thread, NULL);
+    if (core->history != NULL) {
+        history_destroy(core->history);
+    }
+    lc3_set_breakpoints(core->lc3, NULL);
+    breakpoints_destroy(core->breakpoints);
+    assembler_destroy(core->assembler);
+    devices_destroy(core->devices);
+    free(core);
+}
+
+/** Queues a command for the core thread */
+void core_send(core_p core, int type, word_t address, word_t data, const char *file_name) {
+    core_message_t command;
+    command.type = type;
+    command.address = address;
+    command.data = data;
+    command.file_name[0] = '\0';
+    if (file_name != NULL) {
+        strncpy(command.file_name, file_name, FILENAME_SIZE - 1);
+        command.file_name[FILENAME_SIZE - 1] = '\0';
+    }
+    while (core_queue_push(&core->commands, &command) == FALSE) {
+        core_idle();
+    }
+    atomic_fetch_add(&core->commands_sent, 1);
+}
+
+/** Waits until the core has handled every command sent so far */
+void core_flush(core_p core) {
+    while (atomic_load(&core->commands_handled) != atomic_load(&core->commands_sent)) {
+        core_idle();
+    }
+}
+
+/** Gets how the last load went */
+loader_result_t core_get_load_result(core_p core) { return core->load_result; }
+
+/** Gets whether the last save worked */
+bool_t core_get_save_result(core_p core) { return core->save_result; }
+
+/** Takes the next event from the core */
+bool_t core_next_event(core_p core, core_message_t *event) {
+    return core_queue_pop(&core->events, event);
+}
+
+/** Gets the number of snapshots published so far */
+unsigned long core_get_generation(core_p core) {
+    return atomic_load_explicit(&core->generation, memory_order_acquire);
+}
+
+/** Gets the most recently published snapshot, swapping it to the front if it is newer than
+ * the one already there */
+const lc3_snapshot_t *core_get_snapshot(core_p core) {
+    if (atomic_load_explicit(&core->middle, memory_order_relaxed) & CORE_SNAPSHOT_FRESH) {
+        int middle = atomic_exchange_explicit(&core->middle, core->front, memory_order_acq_rel);
+        core->front = middle & ~CORE_SNAPSHOT_FRESH;
+    }
+    return &core->snapshots[core->front];
+}
+
+/** The core thread's main loop. Commands are handled as they arrive; in between, a run
+ * executes in slices and is published RUN_FRAME_RATE times a second */
+void *core_main(void *context) {
+    core_p core = context;
+    core_message_t command;
+    while (atomic_load(&core->quit) == FALSE) {
+        if (core_queue_pop(&core->deferred, &command) == TRUE ||
+            core_queue_pop(&core->commands, &command) == TRUE) {
+            core_handle(core, &command);
+            atomic_fetch_add(&core->commands_handled, 1);
+            continue;
+        }
+        if (core->running == FALSE) {
+            core_idle();
+            continue;
+        }
+        core_execute(core, RUN_SLICE);
+        if (core->keyboard_reported == FALSE && devices_keyboard_used(core->devices) == TRUE) {
+            core->keyboard_reported = TRUE;
+            core_send_event(core, CORE_EVENT_KEYBOARD, 0, 0);
+        }
+        if (lc3_is_halted(core->lc3) == TRUE) {
+            core_stop(core, CORE_STOP_HALT);
+        } else if (breakpoints_get_hit(core->breakpoints) == BREAKPOINT_BEFORE) {
+            core_stop(core, CORE_STOP_BREAKPOINT);
+        } else if (breakpoints_get_hit(core->breakpoints) == BREAKPOINT_AFTER) {
+            core_stop(core, CORE_STOP_WATCHPOINT);
+        } else if (core->running == FALSE) {
+            /* Paused while GETC was waiting for input */
+            core_stop(core, CORE_STOP_PAUSE);
+        } else if (get_time_ns() >= core->next_frame) {
+            core_publish(core);
+            core->next_frame = get_time_ns() + 1000000000LL / RUN_FRAME_RATE;
+        }
+    }
+    return NULL;
+}
+
+/** Carries out a command on the core thread */
+void core_handle(core_p core, const core_message_t *command) {
+    breakpoint_condition_t condition;
+    switch (command->type) {
+    case CORE_STEP:
+        if (core->running == FALSE && lc3_is_halted(core->lc3) == FALSE) {
+            breakpoints_resume(core->breakpoints, lc3_get_pc(core->lc3));
+            core_execute(core, 1);
+            core_stop(core, lc3_is_halted(core->lc3) ? CORE_STOP_HALT : CORE_STOP_STEP);
+        }
+        return;
+    case CORE_STEP_BACK:
+        if (core->running == FALSE) {
+            bool_t stepped = (core->history != NULL) &&
+                             history_step_back(core->history, core->lc3) == TRUE;
+            if (stepped == TRUE) {
+                core_rewind(core, 1);
+            }
+            core_stop(core, stepped ? CORE_STOP_STEP : CORE_STOP_NO_HISTORY);
+        }
+        return;
+    case CORE_REVERSE:
+        if (core->running == FALSE && core->history != NULL) {
+            unsigned long long position = history_get_position(core->history);
+            bool_t hit = history_reverse(core->history, core->lc3, core->breakpoints);
+            core_rewind(core, position - history_get_position(core->history));
+            core_stop(core, hit ? CORE_STOP_BREAKPOINT : CORE_STOP_NO_HISTORY);
+        } else if (core->running == FALSE) {
+            core_stop(core, CORE_STOP_NO_HISTORY);
+        }
+        return;
+    case CORE_RUN:
+        if (lc3_is_halted(core->lc3) == FALSE) {
+            /* Carry on past the breakpoint that stopped the last run, if any */
+            breakpoints_resume(core->breakpoints, lc3_get_pc(core->lc3));
+            core->running = TRUE;
+            core->next_frame = get_time_ns() + 1000000000LL / RUN_FRAME_RATE;
+        }
+        return;
+    case CORE_PAUSE:
+        if (core->running == TRUE) {
+            core_stop(core, CORE_STOP_PAUSE);
+        }
+        return;
+    case CORE_SET_MEMORY:
+        lc3_set_memory(core->lc3, command->address, command->data);
+        if (core->history != NULL) {
+            history_clear(core->history);
+        }
+        break;
+    case CORE_SET_BREAKPOINT:
+        breakpoints_set(core->breakpoints, command->address, command->data != 0);
+        core_arm_breakpoints(core);
+        return;
+    case CORE_SET_CONDITION:
+        if (breakpoint_parse_condition(command->file_name, &condition) == TRUE) {
+            breakpoints_set_condition(core->breakpoints, command->address, &condition);
+        }
+        core_arm_breakpoints(core);
+        return;
+    case CORE_SET_WATCHPOINT:
+        breakpoints_set_watch(core->breakpoints, command->address, command->data);
+        core_arm_breakpoints(core);
+        return;
+    case CORE_SET_ENGINE:
+        core->engine = command->data;
+        return;
+    case CORE_SAVE_STATE:
+        core->save_result = savestate_save(core->lc3, command->file_name);
+        return;
+    case CORE_LOAD:
+        if (loader_has_extension(command->file_name, ASSEMBLER_EXTENSION) == TRUE) {
+            core_load_assembly(core, command->file_name);
+            break;
+        }
+        core->load_result = loader_load(core->lc3, command->file_name);
+        if (core->load_result == LOADER_OK) {
+            core->assembly_name[0] = '\0';
+            if (core->history != NULL) {
+                history_clear(core->history);
+            }
+            /* A new program starts a new recording */
+            core_rewind(core, core->io->instructions);
+        }
+        break;
+    case CORE_INPUT:
+        /* GETC takes its answers itself, so this was typed while the program ran */
+        devices_push_key(core->devices, (char)command->data);
+        return;
+    default:
+        return;
+    }
+    core_publish(core);
+}
+
+/** Loads an assembly file. A patch is treated like a memory edit, which the history can't
+ * step back over, and a fresh load like any other load */
+void core_load_assembly(core_p core, const char *file_name) {
+    bool_t patch = (strcmp(file_name, core->assembly_name) == 0) ? TRUE : FALSE;
+    core->load_result =
+        loader_load_assembly(core->lc3, core->assembler, file_name, patch, NULL);
+    if (core->load_result != LOADER_OK) {
+        return;
+    }
+    if (core->history != NULL) {
+        history_clear(core->history);
+    }
+    if (patch == FALSE) {
+        core_rewind(core, core->io->instructions);
+        strcpy(core->assembly_name, file_name);
+    }
+}
+
+/** Executes up to count instructions. With history on they go one at a time, since each
+ * needs recording before it runs */
+void core_execute(core_p core, unsigned long count) {
+    if (core->history == NULL) {
+        execute(core->lc3, core->io, core->engine, count);
+        return;
+    }
+    while (count > 0 && lc3_is_halted(core->lc3) == FALSE) {
+        /* An interrupt is taken before recording, so the entry is for the instruction that
+         * really runs next. Like a memory edit, entering the service routine can't be
+         * undone */
+        lc3_interrupt(core->lc3);
+        history_record(core->history, core->lc3);
+        if (execute(core->lc3, core->io, core->engine, 1) == 0) {
+            /* Stopped by a breakpoint before it ran, so there's nothing to undo. Stepping
+             * back over the entry puts back exactly what is already there */
+            history_step_back(core->history, core->lc3);
+            return;
+        }
+        count--;
+        if (breakpoints_get_hit(core->breakpoints) != BREAKPOINT_NONE) {
+            return;
+        }
+    }
+}
+
+/** Has the engines check the breakpoints if any are set, and skip the checks if not */
+void core_arm_breakpoints(core_p core) {
+    bool_t armed = breakpoints_armed(core->breakpoints);
+    lc3_set_breakpoints(core->lc3, armed ? core->breakpoints : NULL);
+}
+
+/** Takes the instruction count back by the number of instructions just undone. A recording
+ * drops whatever was typed after that point, since it will be asked for again */
+void core_rewind(core_p core, unsigned long undone) {
+    unsigned long instructions = core->io->instructions - undone;
+    if (core->recorder != NULL) {
+        replay_rewind(core->recorder, instructions);
+    }
+    core->io->instructions = instructions;
+}
+
+/** Ends a step or run and tells the UI why */
+void core_stop(core_p core, int reason) {
+    core->running = FALSE;
+    core_publish(core);
+    core_send_event(core, CORE_EVENT_STOPPED, lc3_get_pc(core->lc3), reason);
+}
+
+/** Brings the back snapshot buffer up to date and publishes it */
+void core_publish(core_p core) {
+    lc3_update_snapshot(core->lc3, &core->snapshots[core->back]);
+    int middle = atomic_exchange_explicit(&core->middle, core->back | CORE_SNAPSHOT_FRESH,
+                                          memory_order_acq_rel);
+    core->back = middle & ~CORE_SNAPSHOT_FRESH;
+    atomic_fetch_add_explicit(&core->generation, 1, memory_order_release);
+}
+
+/** Queues an event for the UI. Gives up if the core is being shut down, since the UI may have
+ * stopped reading */
+void core_send_event(core_p core, int type, word_t address, word_t data) {
+    core_message_t event;
+    event.type = type;
+    event.address = address;
+    event.data = data;
+    event.file_name[0] = '\0';
+    while (core_queue_push(&core->events, &event) == FALSE) {
+        if (atomic_load(&core->quit) == TRUE) {
+            return;
+        }
+        core_idle();
+    }
+}
+
+/** GETC on the core thread. Asks the UI for a character and waits for the answer. A pause
+ * that arrives in the meantime stops the run once the character comes in. Commands that would
+ * run the program are held until then, and a load is refused since the UI may be waiting on
+ * it while this waits on the UI */
+int core_console_get(void *context) {
+    core_p core = context;
+    core_message_t command;
+    core_publish(core);
+    core_send_event(core, CORE_EVENT_INPUT, 0, 0);
+    while (atomic_load(&core->quit) == FALSE) {
+        if (core_queue_pop(&core->commands, &command) == FALSE) {
+            core_idle();
+            continue;
+        }
+        if (command.type == CORE_STEP || command.type == CORE_RUN ||
+            command.type == CORE_STEP_BACK || command.type == CORE_REVERSE) {
+            if (core_queue_push(&core->deferred, &command) == FALSE) {
+                /* More than a queue's worth of them: say so rather than lose it quietly */
+                core_send_event(core, CORE_EVENT_STOPPED, lc3_get_pc(core->lc3),
+                                CORE_STOP_BUSY);
+                atomic_fetch_add(&core->commands_handled, 1);
+            }
+            continue;
+        }
+        if (command.type == CORE_LOAD) {
+            core->load_result = LOADER_BUSY;
+        } else if (command.type == CORE_PAUSE) {
+            core->running = FALSE;
+        } else if (command.type != CORE_INPUT) {
+            core_handle(core, &command);
+        }
+        atomic_fetch_add(&core->commands_handled, 1);
+        if (command.type == CORE_INPUT) {
+            return (char)command.data;
+        }
+    }
+    return '\0';
+}
+
+/** OUT and PUTS on the core thread. The character goes to the UI as an event */
+void core_console_put(void *context, char c) {
+    core_send_event(context, CORE_EVENT_OUTPUT, 0, (unsigned char)c);
+}
+
+/** Adds a message to the tail of the queue. Returns FALSE if the queue is full */
+bool_t core_queue_push(core_queue_t *queue, const core_message_t *message) {
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    if (tail - head == CORE_QUEUE_SIZE) {
+        return FALSE;
+    }
+    queue->messages[tail % CORE_QUEUE_SIZE] = *message;
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return TRUE;
+}
+
+/** Removes a message from the head of the queue. Returns FALSE if the queue is empty */
+bool_t core_queue_pop(core_queue_t *queue, core_message_t *message) {
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    if (head == tail) {
+        return FALSE;
+    }
+    *message = queue->messages[head % CORE_QUEUE_SIZE];
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    return TRUE;
+}
+
+/** Sleeps for CORE_IDLE_NS */
+void core_idle() {
+    struct timespec delay = {0, CORE_IDLE_NS};
+    nanosleep(&delay, NULL);
+}
@@ -0,0 +1,113 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Core Module Header File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#ifndef CORE_H
+#define CORE_H
+
+#include "global.h"
+#include "lc3.h"
+#include "loader.h"
+#include "replay.h"
+#include "slc3.h"
+
+/** Commands the UI sends to the core */
+#define CORE_STEP 0            /* Execute one instruction */
+#define CORE_RUN 1             /* Run until HALT, a breakpoint or CORE_PAUSE */
+#define CORE_PAUSE 2           /* Stop a run */
+#define CORE_SET_MEMORY 3      /* Write data to address */
+#define CORE_SET_BREAKPOINT 4  /* Set (data != 0) or unset the breakpoint at address */
+#define CORE_SET_ENGINE 5      /* Switch to the engine in data */
+#define CORE_INPUT 6           /* The character in data answers a CORE_EVENT_INPUT, or is
+                                * typed on the keyboard device if GETC isn't waiting */
+#define CORE_LOAD 7            /* Load the program named in file_name, or patch it if it is
+                                * the assembly file already loaded */
+#define CORE_STEP_BACK 8       /* Undo the last instruction */
+#define CORE_REVERSE 9         /* Go back to the last breakpoint, or as far as history goes */
+#define CORE_SET_CONDITION 10  /* Break at address when the condition in file_name holds */
+#define CORE_SET_WATCHPOINT 11 /* Watch address for the access kinds in data */
+#define CORE_SAVE_STATE 12     /* Save the whole LC3 to the file named in file_name */
+
+/** Events the core sends back to the UI */
+#define CORE_EVENT_OUTPUT 0  /* Console output, the character is in data */
+#define CORE_EVENT_INPUT 1   /* GETC is waiting for a CORE_INPUT */
+#define CORE_EVENT_STOPPED 2 /* A step or run finished; the reason is in data, the PC in address */
+#define CORE_EVENT_KEYBOARD 3 /* The program has started using the keyboard device */
+
+/** Why a step or run finished */
+#define CORE_STOP_STEP 0
+#define CORE_STOP_HALT 1
+#define CORE_STOP_BREAKPOINT 2
+#define CORE_STOP_PAUSE 3
+#define CORE_STOP_NO_HISTORY 4 /* A step back or reverse ran out of history */
+#define CORE_STOP_WATCHPOINT 5 /* The last instruction read or wrote a watched word */
+#define CORE_STOP_BUSY 6       /* A step or run was dropped while GETC waited for input */
+
+/** Capacity of each message queue */
+#define CORE_QUEUE_SIZE 256
+
+typedef struct core_message_t {
+    int type;
+    word_t address;
+    word_t data;
+    char file_name[FILENAME_SIZE];
+} core_message_t;
+
+typedef struct core_t *core_p;
+
+/** Allocates a core for the LC3 and starts running it on its own thread. From here on only
+ * the core thread touches the LC3; everyone else goes through commands and snapshots. The core
+ * remembers the last history_window instructions so they can be stepped back through, or none
+ * if it is 0. If a recorder is given, every character GETC reads is logged to it; the
+ * recorder stays the caller's and must outlive the core */
+core_p core_create(lc3_p, engine_t, unsigned long history_window, replay_p recorder);
+
+/** Stops the core thread and deallocates the core. The LC3 is left to the caller */
+void core_destroy(core_p);
+
+/** Queues a command for the core thread. Waits for room if the queue is full */
+void core_send(core_p, int type, word_t address, word_t data, const char *file_name);
+
+/** Waits until the core has handled every command sent so far and published the result */
+void core_flush(core_p);
+
+/** Gets how the last CORE_LOAD went. Only meaningful after a core_flush */
+loader_result_t core_get_load_result(core_p);
+
+/** Gets whether the last CORE_SAVE_STATE was written. Only meaningful after a core_flush */
+bool_t core_get_save_result(core_p);
+
+/** Takes the next event from the core. Returns FALSE if there isn't one */
+bool_t core_next_event(core_p, core_message_t *);
+
+/** Gets the number of snapshots the core has published so far. Cheap enough to poll */
+unsigned long core_get_generation(core_p);
+
+/** Gets the most recently published snapshot without copying it. Never blocks the core thread.
+ * The snapshot stays valid and unchanged until the next call, and must only be read from the
+ * thread that made it */
+const lc3_snapshot_t *core_get_snapshot(core_p);
+
+#endif
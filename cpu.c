@@ -50,12 +50,18 @@ void initialize_cpu(cpu_p);
 void set_cc(cpu_p, word_t);
 
 /** Creates a CPU object, initializes it, and returns the pointer */
-cpu_p cpu_create() {
-    cpu_p cpu = calloc(1, sizeof(cpu_t));
+cpu_p cpu_create() { return cpu_create_at(calloc(1, sizeof(cpu_t))); }
+
+/** Initializes a CPU object in storage supplied by the caller */
+cpu_p cpu_create_at(void *storage) {
+    cpu_p cpu = storage;
     initialize_cpu(cpu);
     return cpu;
 }
 
+/** Gets the number of bytes a CPU object needs */
+size_t cpu_size() { return sizeof(cpu_t); }
+
 /** Reinitializes the CPU object without reallocation */
 void cpu_reset(cpu_p cpu) { initialize_cpu(cpu); }
 
@@ -85,6 +91,15 @@ void cpu_set_register(cpu_p cpu, reg_addr_t reg, word_t data) {
     set_cc(cpu, data);
 }
 
+/** Returns the register file itself. Writes made this way do not update the CC */
+word_t *cpu_get_registers(cpu_p cpu) { return cpu->registers; }
+
+/** Gets the whole 3 bit CC */
+cc_t cpu_get_cc(cpu_p cpu) { return cpu->cc; }
+
+/** Sets the whole 3 bit CC */
+void cpu_set_cc(cpu_p cpu, cc_t cc) { cpu->cc = cc; }
+
 /** Fetches the high order bit of the CC representing negative */
 bool_t cpu_get_cc_n(cpu_p cpu) {
     /** No masking needed */
@@ -140,7 +155,7 @@ void initialize_cpu(cpu_p cpu) {
     }
     cpu->cc = 0;
     cpu->ir = 0;
-    cpu->pc = MEMORY_ADDRESS_MIN;
+    cpu->pc = USER_SPACE_START;
     cpu->mar = 0;
     cpu->mdr = 0;
 }
@@ -34,6 +34,13 @@ typedef struct cpu_t *cpu_p;
 /** Allocates and initializes a new cpu module */
 cpu_p cpu_create();
 
+/** Initializes a new cpu module in zeroed storage of at least cpu_size() bytes supplied by the
+ * caller. A cpu created this way is released along with its storage, not with cpu_destroy */
+cpu_p cpu_create_at(void *storage);
+
+/** Gets the number of bytes a cpu module needs */
+size_t cpu_size();
+
 /** Reinitializes the cpu module without reallocation */
 void cpu_reset(cpu_p);
 
@@ -49,6 +56,14 @@ word_t cpu_get_register(cpu_p, reg_addr_t reg);
 /** Sets the specified register to the given data and sets the CC */
 void cpu_set_register(cpu_p, reg_addr_t reg, word_t data);
 
+/** Returns the register file itself so an execution engine can read and write registers
+ * without a call per access. Writes made this way do not update the CC */
+word_t *cpu_get_registers(cpu_p);
+
+/** Gets/sets the whole 3 bit CC (N in the high order bit, P in the low order bit) */
+cc_t cpu_get_cc(cpu_p);
+void cpu_set_cc(cpu_p, cc_t cc);
+
 /** Fetches the high order bit of the CC representing negative */
 bool_t cpu_get_cc_n(cpu_p);
 
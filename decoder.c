@@ -0,0 +1,73 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Decoder Module File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#include "decoder.h"
+#include "global.h"
+#include "lc3.h"
+
+/** Sign extends the low order bits of the IR. The mask selects the field, the sign bit is the
+ * field's high order bit and the negative mask fills in the rest of the word */
+word_t sext(word_t, word_t mask, word_t sign_bit, word_t negative_mask);
+
+/** Mnemonics indexed by opcode */
+static const char *opcode_names[OPCODE_COUNT] = {
+    "BR", "ADD", "LD", "ST", "JSR", "AND", "LDR", "STR",
+    "RTI", "NOT", "LDI", "STI", "JMP", "STACK", "LEA", "TRAP"};
+
+/** Extracts every field of the instruction word into the decoded struct */
+void decoder_decode(word_t ir, decoded_t *decoded) {
+    decoded->ir = ir;
+    /** No masking needed */
+    decoded->opcode = (opcode_t)(ir >> BITSHIFT_OPCODE);
+    decoded->dr = (reg_addr_t)((ir & MASK_DR) >> BITSHIFT_DR);
+    decoded->sr1 = (reg_addr_t)((ir & MASK_SR1) >> BITSHIFT_SR1);
+    decoded->sr2 = (reg_addr_t)(ir & MASK_SR2); /* No shift needed */
+    decoded->imm_mode = (bool_t)((ir & MASK_BIT5) >> BITSHIFT_BIT5);
+    decoded->jsr_imm_mode = (bool_t)((ir & MASK_BIT11) >> BITSHIFT_BIT11);
+    decoded->nzp = (cc_t)((ir & MASK_NZP) >> BITSHIFT_NZP);
+    decoded->trap_vector = (trap_vector_t)(ir & MASK_TRAPVECT8);
+    decoded->imm_5 = (imm_5_t)sext(ir, MASK_IMMED5, BIT_IMMED5, MASK_NEGATIVE_IMMED5);
+    decoded->pc_offset_6 =
+        (pc_offset_6_t)sext(ir, MASK_PCOFFSET6, BIT_PCOFFSET6, MASK_NEGATIVE_PCOFFSET6);
+    decoded->pc_offset_9 =
+        (pc_offset_9_t)sext(ir, MASK_PCOFFSET9, BIT_PCOFFSET9, MASK_NEGATIVE_PCOFFSET9);
+    decoded->pc_offset_11 =
+        (pc_offset_11_t)sext(ir, MASK_PCOFFSET11, BIT_PCOFFSET11, MASK_NEGATIVE_PCOFFSET11);
+}
+
+/** Gets the mnemonic of an opcode */
+const char *decoder_opcode_name(opcode_t opcode) {
+    return opcode_names[opcode & (OPCODE_COUNT - 1)];
+}
+
+/** Sign extends the low order bits of the IR */
+word_t sext(word_t ir, word_t mask, word_t sign_bit, word_t negative_mask) {
+    word_t field = ir & mask;
+    if (field & sign_bit) {
+        field |= negative_mask;
+    }
+    return field;
+}
@@ -0,0 +1,61 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Decoder Module Header File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#ifndef DECODER_H
+#define DECODER_H
+
+#include "global.h"
+
+/** The opcode field is four bits wide */
+#define OPCODE_COUNT 16
+
+/** An instruction word with every field extracted and every offset already sign-extended. The
+ * memory module keeps one of these next to each word so the fields only need to be pulled out
+ * of the IR once, no matter how many times the instruction is executed */
+typedef struct decoded_t decoded_t;
+struct decoded_t {
+    word_t ir;
+    opcode_t opcode;
+    reg_addr_t dr; /* Also the source register for ST, STI, STR and the stack push */
+    reg_addr_t sr1; /* Also the base register for JMP, JSRR, LDR and STR */
+    reg_addr_t sr2;
+    bool_t imm_mode;
+    bool_t jsr_imm_mode;
+    cc_t nzp;
+    trap_vector_t trap_vector;
+    imm_5_t imm_5;
+    pc_offset_6_t pc_offset_6;
+    pc_offset_9_t pc_offset_9;
+    pc_offset_11_t pc_offset_11;
+};
+
+/** Extracts every field of the instruction word into the decoded struct */
+void decoder_decode(word_t ir, decoded_t *decoded);
+
+/** Gets the mnemonic of an opcode. JMP and RET share an opcode and are both named JMP */
+const char *decoder_opcode_name(opcode_t);
+
+#endif
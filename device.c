@@ -0,0 +1,372 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Device Module File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#include "device.h"
+#include "memory.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/** How long the input thread waits on the console before checking whether it should stop */
+#define DEVICE_POLL_MS 100
+
+typedef struct devices_t {
+    lc3_p lc3;
+    console_p console;
+    bool_t read_ahead;
+
+    /** Keys typed but not yet read by the program, as a ring. Guarded by the lock, since the
+     * input thread fills it. Arrived is signalled when a key comes in or the input ends, and
+     * taken when a key is read and there is room again */
+    pthread_mutex_t lock;
+    pthread_cond_t arrived;
+    pthread_cond_t taken;
+    char keys[DEVICE_KEYBOARD_BUFFER];
+    size_t head;
+    size_t count;
+    bool_t input_ended;
+
+    /** Set the first time the program touches the keyboard, which starts the input thread.
+     * Quit tells the thread to stop, and is guarded by the lock */
+    bool_t keyboard_used;
+    bool_t thread_started;
+    bool_t quit;
+    pthread_t thread;
+
+    /** Without the input thread, the instruction count the console was last sampled at */
+    bool_t sampled;
+    unsigned long sampled_at;
+} devices_t, *devices_p;
+
+/** Checks whether keys come in by sampling the console rather than from the input thread */
+bool_t devices_sampling(devices_p);
+
+/** Without the input thread, brings in a key the console has ready if the program has touched
+ * the keyboard and isn't holding one already. Only done once at each multiple of DEVICE_SLICE
+ * instructions, which every engine stops at, so a recording and its replay bring every key in
+ * at the same instruction */
+void devices_sample(devices_p);
+
+/** Called while the program sits on DEVICE_IDLE_LOOP. If the keyboard interrupt is enabled
+ * and no key is waiting, waits up to DEVICE_IDLE_NS for one. The input thread's keys end the
+ * wait as they come; otherwise keys are only sampled or pushed in between instructions, so
+ * the wait is kept to multiples of DEVICE_SLICE instructions, or the FSM, which comes round
+ * every instruction, would hold them up. Halts the LC3 if the input has ended, since nothing
+ * else could wake it */
+void devices_wait(devices_p);
+
+/** Memory handlers for the device registers */
+word_t devices_read(void *, word_t address, word_t *stored);
+void devices_write(void *, word_t address, word_t data, word_t *stored);
+
+/** Notes that the program has touched the keyboard, starting the input thread if it reads
+ * ahead */
+void devices_use_keyboard(devices_p);
+
+/** Takes the next key if there is one, or returns EOF. Called with the lock held */
+int devices_take_key(devices_p);
+
+/** Adds a key if there is room for it. Called with the lock held */
+void devices_add_key(devices_p, char);
+
+/** The input thread. Reads the console into the keyboard until the input ends or it is told to
+ * quit */
+void *devices_read_ahead(void *);
+
+/** Maps the registers and attaches the devices to the LC3 */
+devices_p devices_create(lc3_p lc3, console_p console, bool_t read_ahead) {
+    devices_p devices = calloc(1, sizeof(devices_t));
+    devices->lc3 = lc3;
+    devices->console = console;
+    devices->read_ahead = read_ahead;
+    pthread_mutex_init(&devices->lock, NULL);
+    pthread_cond_init(&devices->arrived, NULL);
+    pthread_cond_init(&devices->taken, NULL);
+    memory_map_device(lc3->memory, DEVICE_KBSR, DEVICE_DDR, devices_read, devices_write,
+                      devices);
+    lc3_set_devices(lc3, devices);
+    return devices;
+}
+
+/** Stops the input thread and detaches the devices. The thread only ever waits on the console
+ * for DEVICE_POLL_MS at a time, so it sees the quit flag soon after it is set */
+void devices_destroy(devices_p devices) {
+    if (devices->thread_started == TRUE) {
+        pthread_mutex_lock(&devices->lock);
+        devices->quit = TRUE;
+        pthread_cond_broadcast(&devices->taken);
+        pthread_mutex_unlock(&devices->lock);
+        pthread_join(devices->thread, NULL);
+    }
+    lc3_set_devices(devices->lc3, NULL);
+    memory_unmap_device(devices->lc3->memory, devices);
+    pthread_cond_destroy(&devices->taken);
+    pthread_cond_destroy(&devices->arrived);
+    pthread_mutex_destroy(&devices->lock);
+    free(devices);
+}
+
+/** Gets the interrupt the devices are requesting. Only the keyboard interrupts, when its
+ * interrupt is enabled and a key is ready */
+word_t devices_poll_interrupt(devices_p devices) {
+    if ((memory_peek(devices->lc3->memory, DEVICE_KBSR) & DEVICE_INTERRUPT_ENABLE) == 0) {
+        return 0;
+    }
+    pthread_mutex_lock(&devices->lock);
+    bool_t ready = (devices->count > 0) ? TRUE : FALSE;
+    pthread_mutex_unlock(&devices->lock);
+    if (ready == FALSE) {
+        return 0;
+    }
+    return (DEVICE_KEYBOARD_PRIORITY << BITSHIFT_PRIORITY) | DEVICE_KEYBOARD_VECTOR;
+}
+
+/** Gets a character for GETC */
+int devices_get_char(devices_p devices) {
+    pthread_mutex_lock(&devices->lock);
+    while (devices->count == 0 && devices->thread_started == TRUE &&
+           devices->input_ended == FALSE) {
+        pthread_cond_wait(&devices->arrived, &devices->lock);
+    }
+    int c = devices_take_key(devices);
+    bool_t owned = devices->thread_started;
+    pthread_mutex_unlock(&devices->lock);
+    if (c != EOF || owned == TRUE) {
+        return c;
+    }
+    return devices->console->get_char(devices->console->context);
+}
+
+/** Hands the keyboard a key typed while the program runs */
+void devices_push_key(devices_p devices, char c) {
+    pthread_mutex_lock(&devices->lock);
+    devices_add_key(devices, c);
+    pthread_mutex_unlock(&devices->lock);
+}
+
+/** Checks whether the program has touched the keyboard registers */
+bool_t devices_keyboard_used(devices_p devices) { return devices->keyboard_used; }
+
+/** Gives the devices their turn between two instructions */
+bool_t devices_service(devices_p devices) {
+    lc3_p lc3 = devices->lc3;
+    devices_sample(devices);
+    if (lc3_interrupt(lc3) == TRUE) {
+        return TRUE;
+    }
+    if (memory_peek(lc3->memory, lc3_get_pc(lc3)) == DEVICE_IDLE_LOOP) {
+        devices_wait(devices);
+    }
+    return FALSE;
+}
+
+/** Waits a little for a key while the program idles with the keyboard interrupt enabled */
+void devices_wait(devices_p devices) {
+    if ((memory_peek(devices->lc3->memory, DEVICE_KBSR) & DEVICE_INTERRUPT_ENABLE) == 0) {
+        return;
+    }
+    struct timespec until;
+    clock_gettime(CLOCK_REALTIME, &until);
+    until.tv_nsec += DEVICE_IDLE_NS;
+    if (until.tv_nsec >= 1000000000L) {
+        until.tv_sec++;
+        until.tv_nsec -= 1000000000L;
+    }
+    console_p console = devices->console;
+    pthread_mutex_lock(&devices->lock);
+    if (devices->count == 0 && devices->input_ended == FALSE &&
+        (devices->thread_started == TRUE || console->instructions % DEVICE_SLICE == 0)) {
+        if (devices_sampling(devices) == TRUE) {
+            /* A key only comes in when the console is sampled, so this just waits for one
+             * and leaves it for devices_sample to take next time */
+            console->poll_char(console->context, DEVICE_IDLE_NS / 1000000);
+        } else {
+            pthread_cond_timedwait(&devices->arrived, &devices->lock, &until);
+        }
+    }
+    if (devices->count == 0 && devices->input_ended == TRUE) {
+        devices->lc3->is_halted = TRUE;
+    }
+    pthread_mutex_unlock(&devices->lock);
+}
+
+/** Checks whether keys come in by sampling the console */
+bool_t devices_sampling(devices_p devices) {
+    return (devices->read_ahead == FALSE && devices->console->poll_char != NULL) ? TRUE
+                                                                                 : FALSE;
+}
+
+/** Brings in a key the console has ready at a sampling point */
+void devices_sample(devices_p devices) {
+    console_p console = devices->console;
+    if (devices->keyboard_used == FALSE || devices_sampling(devices) == FALSE ||
+        console->instructions % DEVICE_SLICE != 0 ||
+        (devices->sampled == TRUE && devices->sampled_at == console->instructions)) {
+        return;
+    }
+    devices->sampled = TRUE;
+    devices->sampled_at = console->instructions;
+    if (devices->count > 0 || devices->input_ended == TRUE ||
+        console->poll_char(console->context, 0) == FALSE) {
+        return;
+    }
+    int c = console->get_char(console->context);
+    pthread_mutex_lock(&devices->lock);
+    if (c == EOF) {
+        devices->input_ended = TRUE;
+    } else {
+        devices_add_key(devices, (char)c);
+    }
+    pthread_mutex_unlock(&devices->lock);
+}
+
+/** Reads a device register. The status registers keep their interrupt enable bit in the
+ * stored word and add the ready bit; reading the keyboard's data register takes the next key
+ * and keeps it stored until the one after. A program polling the keyboard once the input has
+ * ended is halted, the same as GETC, since it would otherwise poll forever */
+word_t devices_read(void *context, word_t address, word_t *stored) {
+    devices_p devices = context;
+    bool_t ready;
+    int c;
+    switch (address) {
+    case DEVICE_KBSR:
+        devices_use_keyboard(devices);
+        pthread_mutex_lock(&devices->lock);
+        ready = (devices->count > 0) ? TRUE : FALSE;
+        if (ready == FALSE && devices->input_ended == TRUE) {
+            devices->lc3->is_halted = TRUE;
+        }
+        pthread_mutex_unlock(&devices->lock);
+        return (*stored & DEVICE_INTERRUPT_ENABLE) | (ready ? DEVICE_READY : 0);
+    case DEVICE_KBDR:
+        devices_use_keyboard(devices);
+        pthread_mutex_lock(&devices->lock);
+        c = devices_take_key(devices);
+        pthread_mutex_unlock(&devices->lock);
+        if (c != EOF) {
+            *stored = (unsigned char)c;
+        }
+        return *stored;
+    case DEVICE_DSR:
+        /** Output is written out at once, so the display is always ready */
+        return (*stored & DEVICE_INTERRUPT_ENABLE) | DEVICE_READY;
+    default:
+        return *stored;
+    }
+}
+
+/** Writes a device register. Only the interrupt enable bit of a status register can be
+ * written, and a character written to the display's data register goes to the console. The
+ * words in between the registers behave as plain memory */
+void devices_write(void *context, word_t address, word_t data, word_t *stored) {
+    devices_p devices = context;
+    switch (address) {
+    case DEVICE_KBSR:
+        devices_use_keyboard(devices);
+        *stored = data & DEVICE_INTERRUPT_ENABLE;
+        return;
+    case DEVICE_DSR:
+        *stored = data & DEVICE_INTERRUPT_ENABLE;
+        return;
+    case DEVICE_DDR:
+        *stored = data;
+        devices->console->put_char(devices->console->context, (char)data);
+        return;
+    case DEVICE_KBDR:
+        /** Read only */
+        return;
+    default:
+        *stored = data;
+    }
+}
+
+/** Notes that the program has touched the keyboard */
+void devices_use_keyboard(devices_p devices) {
+    if (devices->keyboard_used == TRUE) {
+        return;
+    }
+    devices->keyboard_used = TRUE;
+    if (devices->read_ahead == TRUE) {
+        pthread_mutex_lock(&devices->lock);
+        devices->thread_started = TRUE;
+        pthread_mutex_unlock(&devices->lock);
+        pthread_create(&devices->thread, NULL, devices_read_ahead, devices);
+    }
+}
+
+/** Takes the next key, waking the input thread if it was waiting for room */
+int devices_take_key(devices_p devices) {
+    if (devices->count == 0) {
+        return EOF;
+    }
+    char c = devices->keys[devices->head];
+    devices->head = (devices->head + 1) % DEVICE_KEYBOARD_BUFFER;
+    devices->count--;
+    pthread_cond_signal(&devices->taken);
+    return (unsigned char)c;
+}
+
+/** Adds a key, waking anything waiting for one */
+void devices_add_key(devices_p devices, char c) {
+    if (devices->count < DEVICE_KEYBOARD_BUFFER) {
+        devices->keys[(devices->head + devices->count) % DEVICE_KEYBOARD_BUFFER] = c;
+        devices->count++;
+        pthread_cond_broadcast(&devices->arrived);
+    }
+}
+
+/** The input thread. Only reads once the console has something, so it never blocks where it
+ * can't see the quit flag, and waits for room when the program has fallen behind so no input
+ * is lost */
+void *devices_read_ahead(void *context) {
+    devices_p devices = context;
+    console_p console = devices->console;
+    bool_t quit = FALSE;
+    while (quit == FALSE) {
+        if (console->poll_char(console->context, DEVICE_POLL_MS) == FALSE) {
+            pthread_mutex_lock(&devices->lock);
+            quit = devices->quit;
+            pthread_mutex_unlock(&devices->lock);
+            continue;
+        }
+        int c = console->get_char(console->context);
+        pthread_mutex_lock(&devices->lock);
+        while (c != EOF && devices->count == DEVICE_KEYBOARD_BUFFER &&
+               devices->quit == FALSE) {
+            pthread_cond_wait(&devices->taken, &devices->lock);
+        }
+        if (c == EOF) {
+            devices->input_ended = TRUE;
+            pthread_cond_broadcast(&devices->arrived);
+        } else {
+            devices_add_key(devices, (char)c);
+        }
+        quit = (c == EOF) ? TRUE : devices->quit;
+        pthread_mutex_unlock(&devices->lock);
+    }
+    return NULL;
+}
@@ -0,0 +1,103 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Device Module Header File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#ifndef DEVICE_H
+#define DEVICE_H
+
+#include "global.h"
+#include "lc3.h"
+#include "slc3.h"
+
+/** Memory-mapped device registers. The keyboard's status and data registers, then the
+ * display's */
+#define DEVICE_KBSR 0xFE00
+#define DEVICE_KBDR 0xFE02
+#define DEVICE_DSR 0xFE04
+#define DEVICE_DDR 0xFE06
+
+/** Status register bits. The program sets the interrupt enable bit; the ready bit is the
+ * device's */
+#define DEVICE_READY 0x8000
+#define DEVICE_INTERRUPT_ENABLE 0x4000
+
+/** The keyboard interrupts through vector x80 at priority 4 */
+#define DEVICE_KEYBOARD_VECTOR 0x80
+#define DEVICE_KEYBOARD_PRIORITY 4
+
+/** Keys held for the program before it reads them */
+#define DEVICE_KEYBOARD_BUFFER 4096
+
+/** With devices attached, the fast and JIT engines run up to the next multiple of this many
+ * instructions at a time and look for an interrupt in between. Without the input thread,
+ * those multiples are also where the console is sampled for keys */
+#define DEVICE_SLICE 4096
+
+/** BRnzp #-1. A program sitting on one with the keyboard interrupt enabled is waiting for a
+ * key, so rather than spinning the host waits up to DEVICE_IDLE_NS for one to arrive */
+#define DEVICE_IDLE_LOOP 0x0FFF
+#define DEVICE_IDLE_NS 1000000
+
+typedef struct devices_t *devices_p;
+
+/** Maps the keyboard and display registers into the LC3's memory and attaches the devices
+ * to it so their interrupts are taken. Display output goes to the console. With read_ahead,
+ * the first time the program touches the keyboard an input thread starts reading the
+ * console into the keyboard, so the program can poll or wait for keys without ever blocking.
+ * Reading ahead needs a console that can be polled. Without it, a console that can be polled
+ * is sampled for a key at fixed instruction counts, so that where each key arrives depends
+ * on the program alone and a recording replays exactly; keys also arrive through
+ * devices_push_key. The console belongs to the caller and must outlive the devices */
+devices_p devices_create(lc3_p, console_p, bool_t read_ahead);
+
+/** Stops the input thread, unmaps the registers and detaches the devices from the LC3 */
+void devices_destroy(devices_p);
+
+/** Gets the interrupt the devices are requesting: the priority in bits 10-8, where the PSR
+ * keeps it, and the vector in the low byte. Returns 0 if there isn't one */
+word_t devices_poll_interrupt(devices_p);
+
+/** Gets a character for GETC. Once the input thread has started it owns the console's input,
+ * so GETC takes keys from the keyboard too, waiting for the next one. Otherwise a key already
+ * pushed is taken first and the console is asked if there is none. Returns EOF once there is
+ * no more input */
+int devices_get_char(devices_p);
+
+/** Hands the keyboard a key typed while the program runs. Dropped if the keyboard is full */
+void devices_push_key(devices_p, char);
+
+/** Checks whether the program has touched the keyboard registers yet */
+bool_t devices_keyboard_used(devices_p);
+
+/** Gives the devices their turn between two instructions. The engines call it before the
+ * fetch, the FSM before every instruction and the others before every slice: the console is
+ * sampled if it is time to, the interrupt the devices request is taken, and otherwise a
+ * program sitting on DEVICE_IDLE_LOOP with the keyboard interrupt enabled may wait up to
+ * DEVICE_IDLE_NS for a key. Without the input thread it only waits at multiples of
+ * DEVICE_SLICE instructions, where keys are sampled. The LC3 is halted if the input has ended
+ * by then, since nothing else could wake it. Returns whether an interrupt was taken */
+bool_t devices_service(devices_p);
+
+#endif
@@ -0,0 +1,264 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Disassembler Module File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#include "disasm.h"
+#include "decoder.h"
+#include "lc3.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Where the fields of a listing line start: "(3000) E00C  1110000000001100 (  12) START ..."
+ * has the address in parentheses, then the label and the mnemonic in fixed columns */
+#define DISASM_LISTING_LABEL 37
+#define DISASM_LISTING_MNEMONIC (DISASM_LISTING_LABEL + 16)
+#define DISASM_LISTING_LINE_SIZE 256
+
+#define DISASM_INITIAL_SYMBOLS 64
+
+typedef struct disasm_entry_t {
+    word_t word;
+    bool_t is_valid;
+    char text[DISASM_TEXT_SIZE];
+} disasm_entry_t;
+
+typedef struct disasm_symbol_t {
+    word_t address;
+    char name[DISASM_LABEL_SIZE];
+} disasm_symbol_t;
+
+typedef struct disasm_t {
+    /** Cached text for each word, a page at a time, allocated the first time a word in the
+     * page is asked for. The display only looks at a window of memory, so most stay NULL */
+    disasm_entry_t *pages[MEMORY_PAGE_COUNT];
+    /** Labels in address order */
+    disasm_symbol_t *symbols;
+    size_t symbol_count;
+    size_t symbol_capacity;
+} disasm_t, *disasm_p;
+
+/** Frees every cached page */
+void disasm_clear_cache(disasm_p);
+
+/** Writes the text of a word as an instruction */
+void disasm_format(disasm_p, word_t address, word_t word, char *text);
+
+/** Writes a PC-relative target by label, or as an address if it has none */
+void disasm_format_target(disasm_p, word_t target, char *text, size_t size);
+
+/** Finds the symbol at the address, or returns NULL */
+const disasm_symbol_t *disasm_find(disasm_p, word_t address);
+
+/** Orders symbols by address for qsort */
+int disasm_compare_symbols(const void *, const void *);
+
+/** Allocates a disassembler with no symbols and nothing cached */
+disasm_p disasm_create() {
+    disasm_p disasm = calloc(1, sizeof(disasm_t));
+    disasm->symbol_capacity = DISASM_INITIAL_SYMBOLS;
+    disasm->symbols = malloc(sizeof(disasm_symbol_t) * disasm->symbol_capacity);
+    return disasm;
+}
+
+/** Deallocates the disassembler */
+void disasm_destroy(disasm_p disasm) {
+    disasm_clear_cache(disasm);
+    free(disasm->symbols);
+    free(disasm);
+}
+
+/** Reads the labels from a listing. Only lines with a label in the label column count, and the
+ * .ORIG line is skipped since the address it shows is 0000 rather than where its label is */
+bool_t disasm_load_symbols(disasm_p disasm, const char *listing_name) {
+    disasm_clear_symbols(disasm);
+    FILE *file = fopen(listing_name, "r");
+    if (file == NULL) {
+        return FALSE;
+    }
+    char line[DISASM_LISTING_LINE_SIZE];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        unsigned int address;
+        if (strlen(line) <= DISASM_LISTING_MNEMONIC || sscanf(line, "(%4x)", &address) != 1 ||
+            line[DISASM_LISTING_LABEL] == ' ' ||
+            strncmp(line + DISASM_LISTING_MNEMONIC, ".ORIG", strlen(".ORIG")) == 0) {
+            continue;
+        }
+        if (disasm->symbol_count == disasm->symbol_capacity) {
+            disasm->symbol_capacity *= 2;
+            disasm->symbols =
+                realloc(disasm->symbols, sizeof(disasm_symbol_t) * disasm->symbol_capacity);
+        }
+        disasm_symbol_t *symbol = &disasm->symbols[disasm->symbol_count++];
+        symbol->address = address;
+        size_t length = strcspn(line + DISASM_LISTING_LABEL, " \t\r\n");
+        if (length >= DISASM_LABEL_SIZE) {
+            length = DISASM_LABEL_SIZE - 1;
+        }
+        memcpy(symbol->name, line + DISASM_LISTING_LABEL, length);
+        symbol->name[length] = '\0';
+    }
+    fclose(file);
+    qsort(disasm->symbols, disasm->symbol_count, sizeof(disasm_symbol_t),
+          disasm_compare_symbols);
+    return TRUE;
+}
+
+/** Forgets the symbols and empties the cache */
+void disasm_clear_symbols(disasm_p disasm) {
+    disasm->symbol_count = 0;
+    disasm_clear_cache(disasm);
+}
+
+/** Gets the text of the word at the address, from the cache if the word hasn't changed */
+const char *disasm_get(disasm_p disasm, word_t address, word_t word) {
+    disasm_entry_t *page = disasm->pages[address / MEMORY_PAGE_SIZE];
+    if (page == NULL) {
+        page = calloc(MEMORY_PAGE_SIZE, sizeof(disasm_entry_t));
+        disasm->pages[address / MEMORY_PAGE_SIZE] = page;
+    }
+    disasm_entry_t *entry = &page[address % MEMORY_PAGE_SIZE];
+    if (entry->is_valid == FALSE || entry->word != word) {
+        disasm_format(disasm, address, word, entry->text);
+        entry->word = word;
+        entry->is_valid = TRUE;
+    }
+    return entry->text;
+}
+
+/** Gets the label at the address */
+const char *disasm_get_label(disasm_p disasm, word_t address) {
+    const disasm_symbol_t *symbol = disasm_find(disasm, address);
+    return (symbol == NULL) ? NULL : symbol->name;
+}
+
+/** Frees every cached page */
+void disasm_clear_cache(disasm_p disasm) {
+    int page;
+    for (page = 0; page < MEMORY_PAGE_COUNT; page++) {
+        free(disasm->pages[page]);
+        disasm->pages[page] = NULL;
+    }
+}
+
+/** Writes the text of a word as an instruction, the way it would be written in assembly. Words
+ * that are really data come out as whatever instruction they happen to encode */
+void disasm_format(disasm_p disasm, word_t address, word_t word, char *text) {
+    static const char *trap_names[] = {"GETC", "OUT", "PUTS", "IN", "PUTSP", "HALT"};
+    /* Labels are cut short enough that any instruction with one still fits */
+    char target[DISASM_LABEL_SIZE];
+    decoded_t d;
+    decoder_decode(word, &d);
+    const char *name = decoder_opcode_name(d.opcode);
+    switch (d.opcode) {
+    case OPCODE_ADD:
+    case OPCODE_AND:
+        if (d.imm_mode == TRUE) {
+            snprintf(text, DISASM_TEXT_SIZE, "%s R%d, R%d, #%d", name, d.dr, d.sr1, d.imm_5);
+        } else {
+            snprintf(text, DISASM_TEXT_SIZE, "%s R%d, R%d, R%d", name, d.dr, d.sr1, d.sr2);
+        }
+        break;
+    case OPCODE_NOT:
+        snprintf(text, DISASM_TEXT_SIZE, "NOT R%d, R%d", d.dr, d.sr1);
+        break;
+    case OPCODE_BR:
+        if (d.nzp == 0) {
+            snprintf(text, DISASM_TEXT_SIZE, "NOP");
+            break;
+        }
+        disasm_format_target(disasm, address + 1 + d.pc_offset_9, target, sizeof(target));
+        snprintf(text, DISASM_TEXT_SIZE, "BR%s%s%s %s", (d.nzp & 4) ? "n" : "",
+                 (d.nzp & 2) ? "z" : "", (d.nzp & 1) ? "p" : "", target);
+        break;
+    case OPCODE_JMP:
+        if (d.sr1 == 7) {
+            snprintf(text, DISASM_TEXT_SIZE, "RET");
+        } else {
+            snprintf(text, DISASM_TEXT_SIZE, "JMP R%d", d.sr1);
+        }
+        break;
+    case OPCODE_JSR:
+        if (d.jsr_imm_mode == TRUE) {
+            disasm_format_target(disasm, address + 1 + d.pc_offset_11, target, sizeof(target));
+            snprintf(text, DISASM_TEXT_SIZE, "JSR %s", target);
+        } else {
+            snprintf(text, DISASM_TEXT_SIZE, "JSRR R%d", d.sr1);
+        }
+        break;
+    case OPCODE_LD:
+    case OPCODE_LDI:
+    case OPCODE_LEA:
+    case OPCODE_ST:
+    case OPCODE_STI:
+        disasm_format_target(disasm, address + 1 + d.pc_offset_9, target, sizeof(target));
+        snprintf(text, DISASM_TEXT_SIZE, "%s R%d, %s", name, d.dr, target);
+        break;
+    case OPCODE_LDR:
+    case OPCODE_STR:
+        snprintf(text, DISASM_TEXT_SIZE, "%s R%d, R%d, #%d", name, d.dr, d.sr1, d.pc_offset_6);
+        break;
+    case OPCODE_TRAP:
+        if (d.trap_vector >= 0x20 && d.trap_vector <= 0x25) {
+            snprintf(text, DISASM_TEXT_SIZE, "%s", trap_names[d.trap_vector - 0x20]);
+        } else {
+            snprintf(text, DISASM_TEXT_SIZE, "TRAP x%02X", d.trap_vector);
+        }
+        break;
+    case OPCODE_STACK:
+        /* Bit 5 tells a pop from a push */
+        snprintf(text, DISASM_TEXT_SIZE, "%s R%d", (d.imm_mode == TRUE) ? "POP" : "PUSH",
+                 d.dr);
+        break;
+    default:
+        snprintf(text, DISASM_TEXT_SIZE, "%s", name);
+        break;
+    }
+}
+
+/** Writes a PC-relative target by label, or as an address if it has none */
+void disasm_format_target(disasm_p disasm, word_t target, char *text, size_t size) {
+    const disasm_symbol_t *symbol = disasm_find(disasm, target);
+    if (symbol != NULL) {
+        snprintf(text, size, "%s", symbol->name);
+    } else {
+        snprintf(text, size, "x%04X", target);
+    }
+}
+
+/** Finds the symbol at the address by binary search */
+const disasm_symbol_t *disasm_find(disasm_p disasm, word_t address) {
+    disasm_symbol_t key;
+    key.address = address;
+    return bsearch(&key, disasm->symbols, disasm->symbol_count, sizeof(disasm_symbol_t),
+                   disasm_compare_symbols);
+}
+
+/** Orders symbols by address */
+int disasm_compare_symbols(const void *a, const void *b) {
+    const disasm_symbol_t *first = a;
+    const disasm_symbol_t *second = b;
+    return (int)first->address - (int)second->address;
+}
@@ -0,0 +1,62 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Disassembler Module Header File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#ifndef DISASM_H
+#define DISASM_H
+
+#include "global.h"
+
+/** Room for the text of one instruction, like "LDR R1, R2, #-32" or "BRnzp SOME_LABEL" */
+#define DISASM_TEXT_SIZE 32
+
+/** Labels longer than this are cut short */
+#define DISASM_LABEL_SIZE 24
+
+typedef struct disasm_t *disasm_p;
+
+/** Allocates a disassembler with no symbols and nothing cached */
+disasm_p disasm_create();
+
+/** Deallocates the disassembler */
+void disasm_destroy(disasm_p);
+
+/** Reads the labels from a listing in the format assembler_write_listing writes (and the
+ * standard LC-3 assembler too), replacing any read before, and empties the cache since targets
+ * may now be shown by name. Returns FALSE, leaving no symbols, if the file can't be read */
+bool_t disasm_load_symbols(disasm_p, const char *listing_name);
+
+/** Forgets the symbols and empties the cache */
+void disasm_clear_symbols(disasm_p);
+
+/** Gets the text of the word at the address as an instruction, with PC-relative targets shown
+ * by label when there is one. The text is cached with the word, so it is only worked out again
+ * once the word at the address changes. It stays valid until the next call for that address */
+const char *disasm_get(disasm_p, word_t address, word_t word);
+
+/** Gets the label at the address, or NULL if there isn't one */
+const char *disasm_get_label(disasm_p, word_t address);
+
+#endif
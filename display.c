@@ -25,7 +25,11 @@
  */
 
 #include "display.h"
+#include "assembler.h"
+#include "breakpoint.h"
+#include "disasm.h"
 #include "global.h"
+#include "loader.h"
 #include "slc3.h"
 #include <curses.h>
 #include <menu.h>
@@ -43,7 +47,8 @@
 
 #define REG_PANEL_WIDTH 36
 #define REG_PANEL_HEIGHT 12
-#define MEM_PANEL_WIDTH 30
+#define MEM_PANEL_WIDTH 62
+#define MEM_PANEL_NARROW_WIDTH 30
 #define MEM_PANEL_HEIGHT 22
 #define CPU_PANEL_WIDTH 36
 #define CPU_PANEL_HEIGHT 12
@@ -53,38 +58,72 @@
 #define OUTPUT_CONSOLE_LINES 3
 #define OUTPUT_CONSOLE_COLS 64
 
+/** The smallest terminal the panels fit in, with the narrow memory panel */
+#define DISPLAY_MIN_COLS (CPU_PANEL_WIDTH + 8 + MEM_PANEL_NARROW_WIDTH)
+#define DISPLAY_MIN_LINES \
+    (MEM_PANEL_HEIGHT + 2 * IO_PANEL_HEIGHT + OUTPUT_CONSOLE_LINES + HEIGHT_PADDING + 2)
+
 #define CPU_ELEMENTS_COUNT 10
 
 static const char MSG_CPU_HALTED[] = "CPU halted :*)";
 static const char MSG_LOAD[] = "1) Enter a program to load >> ";
 static const char MSG_LOADED[] = "1) Loaded %s";
-static const char MSG_FILE_NOT_LOADED[] = "1) File not found. Enter a new filename >> ";
+static const char MSG_FILE_NOT_LOADED[] = "1) %s. Enter a new filename >> ";
+static const char MSG_FILE_BUSY[] = "1) Not loaded: the program is waiting for input";
 static const char MSG_SAVE[] = "2) Enter save file name >> ";
 static const char MSG_SAVED[] = "2) Saved memory to file %s";
 static const char MSG_FILE_NOT_SAVED[] = "2) Error saving to file. Enter save file name >> ";
 static const char MSG_STEP[] = "3) Stepped";
 static const char MSG_STEP_NO_FILE[] = "3) No file loaded yet!";
-static const char MSG_RUNNING_CODE[] = "4) Running code";
+static const char MSG_RUNNING_CODE[] = "4) Running code. Press any key to pause";
+static const char MSG_RUNNING_KEYBOARD[] =
+    "4) Running code. Keys go to the program, Esc pauses";
+static const char MSG_RUN_PAUSED[] = "4) Paused at %s. Step or run to continue >> ";
 static const char MSG_RUN_NO_FILE[] = "4) No file loaded yet!";
 static const char MSG_DISPLAY_MEM[] = "5) Enter the hex address to jump to >> ";
 static const char MSG_EDIT_MEM_ADDR[] = "6) Enter the hex address to edit >> ";
 static const char MSG_EDIT_MEM_DATA[] = "6) Enter the hex data to push to %s >> ";
 static const char MSG_EDIT_MEM_SUCCESS[] = "6) Sucessfully edited memory %s";
+static const char MSG_ENGINE[] = "7) Execution engine: %s";
 static const char MSG_SET_UNSET_BRKPT[] = "8) Enter the hex address to set/unset breakpoint >> ";
 static const char MSG_SET_UNSET_BRKPT_CONFIRM[] = "8) Breakpoint was %s";
 static const char MSG_BRKPT_HIT[] = "4) Breakpoint hit at %s. Step or run to continue >> ";
 static const char MSG_SET_UNSET_BRKPT_NO_FILE[] = "8) No file loaded yet!";
 static const char MSG_CPU_HALTED_STEP[] = "3) Cannot step: CPU halted";
 static const char MSG_CPU_HALTED_RUN[] = "4) Cannot run: CPU halted";
+static const char MSG_STEP_BACK[] = "b) Stepped back";
+static const char MSG_REVERSE[] = "r) Running backwards to the last breakpoint";
+static const char MSG_HISTORY_START[] = "b) No history before %s. Step or run to continue >> ";
+static const char MSG_CORE_BUSY[] = "3) Waiting for input at %s, a step or run was dropped";
+static const char MSG_WATCH_ADDR[] = "w) Enter the hex address to watch >> ";
+static const char MSG_WATCH_KIND[] = "w) Watch %s for r)eads, w)rites or rw (blank to stop) >> ";
+static const char MSG_WATCH_CONFIRM[] = "w) %s";
+static const char MSG_WATCH_HIT[] = "4) Watched memory accessed, stopped at %s >> ";
+static const char MSG_CONDITION_ADDR[] = "c) Enter the hex address to break at >> ";
+static const char MSG_CONDITION[] = "c) Break at %s when (like R0 == x41 or [R6] < #0) >> ";
+static const char MSG_CONDITION_CONFIRM[] = "c) Conditional breakpoint set at %s";
+static const char MSG_CONDITION_ERROR[] = "c) Could not read the condition %s";
+static const char MSG_TERMINAL_TOO_SMALL[] =
+    "The Display needs a terminal of at least %d by %d, this one is %d by %d";
+
+/** The memory panel lists a window of this many words rather than the whole address space. The
+ * window is moved, a page at a time, to follow the PC or whichever address the user asks for */
+#define MEM_WINDOW_SIZE 512
+
+/** Widths of the label and instruction columns the memory panel shows after each word. Every
+ * memory item is padded to the same width, so redrawing one in place never leaves any of the
+ * last text behind */
+#define MEM_LABEL_WIDTH 12
+#define MEM_INSTRUCTION_WIDTH 23
 
 typedef struct menu_string_t {
     char label[31];
-    char description[31];
+    char description[48];
 } menu_string_t;
 
 typedef struct display_t {
     menu_string_t reg_strings[REGISTER_SIZE + 1];
-    menu_string_t mem_strings[MEMORY_SIZE + 1];
+    menu_string_t mem_strings[MEM_WINDOW_SIZE + 1];
     menu_string_t cpu_strings[CPU_ELEMENTS_COUNT + 1];
 
     WINDOW *menu_windows[3];
@@ -99,10 +138,42 @@ typedef struct display_t {
     char console_content[OUTPUT_CONSOLE_LINES][OUTPUT_CONSOLE_COLS];
     unsigned char console_line_ptr;
     unsigned char console_col_ptr;
+    /** Only used to draw the markers in the memory panel; the core keeps the real ones */
     bool breakpoints[MEMORY_SIZE];
+    unsigned char watchpoints[MEMORY_SIZE];
+    word_t breakpoint_address;
+    /** Set by w) and c) along with breakpoint_address */
+    int watch_kinds;
+    char condition[STRING_SIZE];
+    /** First address shown in the memory panel */
+    word_t mem_window_start;
+
+    /** Sub windows the menus are drawn into, kept across rebuilds */
+    WINDOW *menu_subs[3];
+    /** Set when the windows were recreated and the menus must be rebuilt on the next update */
+    bool_t rebuild_needed;
+    /** Width of the widest item name and description in each menu */
+    int name_widths[3];
+    int description_widths[3];
+    /** Items whose text changed in the frame being drawn, and items highlighted last frame */
+    int changed_items[3][MEM_WINDOW_SIZE];
+    int changed_counts[3];
+    int lit_items[3][MEM_WINDOW_SIZE];
+    int lit_counts[3];
+    /** Memory generation and PC the panels were last drawn from */
+    unsigned long shown_generation;
+    word_t shown_pc;
+    /** Disassembles the memory panel. Only called for words in pages that were written, and
+     * keeps the text of each word until it changes */
+    disasm_p disasm;
+    /** The memory panel is MEM_PANEL_WIDTH wide if the terminal has room for it. Otherwise it
+     * is MEM_PANEL_NARROW_WIDTH wide and leaves out the label and instruction columns */
+    int mem_panel_width;
 } display_t, *display_p;
 
-void initialize_display(display_p);
+/** Creates the windows. Returns FALSE, with none left behind, if the terminal is too small */
+bool_t initialize_display(display_p);
+void delete_windows(display_p);
 void initialize_display_data(display_p);
 int free_display(display_p);
 void print_message(const char *, char *);
@@ -112,11 +183,30 @@ void print_title(WINDOW *, int, char *, chtype);
 void draw_io_window(WINDOW *, char *);
 void print_window_titles();
 void display_save_file_name(char *output_file_name, int size);
+bool_t move_mem_window(display_p, word_t);
+void select_mem_address(display_p, const lc3_snapshot_t *, word_t);
+void rebuild_display(display_p, const lc3_snapshot_t *, word_t);
+menu_string_t *get_menu_strings(display_p, int);
+void set_description(display_p, int, int, const char *);
+void fill_descriptions(display_p, const lc3_snapshot_t *);
+void fill_mem_description(display_p, const lc3_snapshot_t *, int);
+void draw_description(display_p, int, int, bool_t);
+void draw_changes(display_p);
+void measure_menu(display_p, int);
 
 /** Allocates and initializes the Display */
 display_p display_create() {
     display_p disp = calloc(1, sizeof(display_t));
-    initialize_display(disp);
+    disp->disasm = disasm_create();
+    if (initialize_display(disp) == FALSE) {
+        endwin();
+        fprintf(stderr, MSG_TERMINAL_TOO_SMALL, DISPLAY_MIN_COLS, DISPLAY_MIN_LINES, COLS,
+                LINES);
+        fprintf(stderr, "\n");
+        disasm_destroy(disp->disasm);
+        free(disp);
+        return NULL;
+    }
     initialize_display_data(disp);
     return disp;
 }
@@ -127,19 +217,30 @@ int display_destroy(display_p disp) {
     free_display(disp);
     int i;
     for (i = 0; i < 3; i++) {
+        delwin(disp->menu_subs[i]);
         delwin(disp->menu_windows[i]);
     }
+    disasm_destroy(disp->disasm);
     return endwin();
 }
 
-/** Reset the display by reallocation */
+/** Reset the display by reallocation. A terminal resized below the minimum shows how big it
+ * has to be until it is resized again */
 void display_reset(display_p disp) {
-    initialize_display(disp);
+    while (initialize_display(disp) == FALSE) {
+        clear();
+        mvprintw(0, 0, MSG_TERMINAL_TOO_SMALL, DISPLAY_MIN_COLS, DISPLAY_MIN_LINES, COLS,
+                 LINES);
+        refresh();
+        while (getch() != KEY_RESIZE) {
+        }
+        clear();
+    }
 }
 
 /** Initializes the debug monitor with variables needed throughout the execution
  * of the LC-3 simulator. */
-void initialize_display(display_p disp) {
+bool_t initialize_display(display_p disp) {
 
     /* Initialize ncurses */
     initscr();
@@ -151,23 +252,79 @@ void initialize_display(display_p disp) {
     init_pair(2, COLOR_CYAN, COLOR_BLACK);
     init_pair(3, COLOR_YELLOW, COLOR_BLACK);
 
+    /* Windows may be made larger than the screen, so the size is checked up front */
+    if (COLS < DISPLAY_MIN_COLS || LINES < DISPLAY_MIN_LINES) {
+        return FALSE;
+    }
+    disp->mem_panel_width = (COLS >= CPU_PANEL_WIDTH + 8 + MEM_PANEL_WIDTH)
+                                ? MEM_PANEL_WIDTH
+                                : MEM_PANEL_NARROW_WIDTH;
+    int io_width = disp->mem_panel_width + REG_PANEL_WIDTH + 4;
+
     /* Create the window instances to be associated with the menus */
     disp->menu_windows[INDEX_REG] =
         newwin(REG_PANEL_HEIGHT, REG_PANEL_WIDTH, HEIGHT_PADDING, 4);
     disp->menu_windows[INDEX_MEM] =
-        newwin(MEM_PANEL_HEIGHT, MEM_PANEL_WIDTH, HEIGHT_PADDING, CPU_PANEL_WIDTH + 8);
+        newwin(MEM_PANEL_HEIGHT, disp->mem_panel_width, HEIGHT_PADDING, CPU_PANEL_WIDTH + 8);
     disp->menu_windows[INDEX_CPU] =
         newwin(CPU_PANEL_HEIGHT, CPU_PANEL_WIDTH, REG_PANEL_HEIGHT + HEIGHT_PADDING, 4);
+
+    /* The menus are drawn into sub windows inside the panels, below the titles */
+    disp->menu_subs[INDEX_REG] = derwin(disp->menu_windows[INDEX_REG], REG_PANEL_HEIGHT - 4,
+                                        REG_PANEL_WIDTH - 4, 3, 1);
+    disp->menu_subs[INDEX_MEM] = derwin(disp->menu_windows[INDEX_MEM], MEM_PANEL_HEIGHT - 4,
+                                        disp->mem_panel_width - 4, 3, 1);
+    disp->menu_subs[INDEX_CPU] = derwin(disp->menu_windows[INDEX_CPU], CPU_PANEL_HEIGHT - 4,
+                                        CPU_PANEL_WIDTH - 4, 3, 1);
+    /* New windows need the menus rebuilt and posted to them */
+    disp->rebuild_needed = TRUE;
     
     /** Initialize the Input window */
-    disp->input_window = newwin(IO_PANEL_HEIGHT, MEM_PANEL_WIDTH + REG_PANEL_WIDTH + 4,
-                                MEM_PANEL_HEIGHT + HEIGHT_PADDING + 3, 4);
-    draw_io_window(disp->input_window, "Input");
+    disp->input_window =
+        newwin(IO_PANEL_HEIGHT, io_width, MEM_PANEL_HEIGHT + HEIGHT_PADDING + 3, 4);
     /** Initialize the output window */
-    disp->output_window = newwin(IO_PANEL_HEIGHT + OUTPUT_CONSOLE_LINES - 1,
-                                 MEM_PANEL_WIDTH + REG_PANEL_WIDTH + 4,
-                                 MEM_PANEL_HEIGHT + IO_PANEL_HEIGHT + HEIGHT_PADDING + 3, 4);
+    disp->output_window =
+        newwin(IO_PANEL_HEIGHT + OUTPUT_CONSOLE_LINES - 1, io_width,
+               MEM_PANEL_HEIGHT + IO_PANEL_HEIGHT + HEIGHT_PADDING + 3, 4);
+
+    /* Or they can fail to allocate */
+    int i;
+    for (i = 0; i < 3; i++) {
+        if (disp->menu_windows[i] == NULL || disp->menu_subs[i] == NULL) {
+            delete_windows(disp);
+            return FALSE;
+        }
+    }
+    if (disp->input_window == NULL || disp->output_window == NULL) {
+        delete_windows(disp);
+        return FALSE;
+    }
+    draw_io_window(disp->input_window, "Input");
     draw_io_window(disp->output_window, "Output");
+    return TRUE;
+}
+
+/** Deletes whichever of the windows were created */
+void delete_windows(display_p disp) {
+    int i;
+    for (i = 0; i < 3; i++) {
+        if (disp->menu_subs[i] != NULL) {
+            delwin(disp->menu_subs[i]);
+            disp->menu_subs[i] = NULL;
+        }
+        if (disp->menu_windows[i] != NULL) {
+            delwin(disp->menu_windows[i]);
+            disp->menu_windows[i] = NULL;
+        }
+    }
+    if (disp->input_window != NULL) {
+        delwin(disp->input_window);
+        disp->input_window = NULL;
+    }
+    if (disp->output_window != NULL) {
+        delwin(disp->output_window);
+        disp->output_window = NULL;
+    }
 }
 
 void initialize_display_data(display_p disp) {
@@ -179,6 +336,7 @@ void initialize_display_data(display_p disp) {
     int i;
     for (i = 0; i < MEMORY_SIZE; i++) {
         disp->breakpoints[i] = false;
+        disp->watchpoints[i] = 0;
     }
 
     /** Initialize output console content */
@@ -188,7 +346,8 @@ void initialize_display_data(display_p disp) {
 
     /* Stores the size of each array */
     disp->item_counts[INDEX_REG] = REGISTER_SIZE;
-    disp->item_counts[INDEX_MEM] = MEMORY_SIZE;
+    disp->item_counts[INDEX_MEM] = MEM_WINDOW_SIZE;
+    disp->mem_window_start = USER_SPACE_START;
     disp->item_counts[INDEX_CPU] = CPU_ELEMENTS_COUNT;
 
     disp->saved_menu_index[INDEX_REG] = 0;
@@ -223,8 +382,66 @@ int free_display(display_p disp) {
 
 /** Returns whether the specified address has a breakpoint set */
 bool_t display_has_breakpoint(display_p disp, word_t address) {
-    int bp_index = get_index_from_address(address);
-    return disp->breakpoints[bp_index];
+    return disp->breakpoints[address];
+}
+
+/** Gets the address of the breakpoint that was just set or unset */
+word_t display_get_breakpoint_address(display_p disp) { return disp->breakpoint_address; }
+
+/** Gets the kinds of access the watchpoint that was just set or cleared watches for */
+int display_get_watch_kinds(display_p disp) { return disp->watch_kinds; }
+
+/** Gets the condition of the conditional breakpoint that was just set */
+const char *display_get_condition(display_p disp) { return disp->condition; }
+
+/** Waits up to the timeout for a keypress. The key is consumed */
+int display_poll_key(display_p disp, int timeout) {
+    WINDOW *window = disp->menu_windows[disp->active_window];
+    wtimeout(window, timeout);
+    int c = wgetch(window);
+    wtimeout(window, -1);
+    return (c == ERR) ? DISPLAY_NO_KEY : c;
+}
+
+/** Let the user know keys typed during a run go to the program */
+void display_keyboard_attached() { print_message(MSG_RUNNING_KEYBOARD, NULL); }
+
+/** Let the user know the LC3 halted */
+void display_halted() { print_message(MSG_CPU_HALTED, NULL); }
+
+/** Let the user know a breakpoint was hit */
+void display_breakpoint_hit(word_t pc) {
+    char address[6];
+    sprintf(address, "x%04X", pc);
+    print_message(MSG_BRKPT_HIT, address);
+}
+
+/** Let the user know a watched word was read or written just before the specified PC */
+void display_watchpoint_hit(word_t pc) {
+    char address[6];
+    sprintf(address, "x%04X", pc);
+    print_message(MSG_WATCH_HIT, address);
+}
+
+/** Let the user know Run was paused by a keypress */
+void display_run_paused(word_t pc) {
+    char address[6];
+    sprintf(address, "x%04X", pc);
+    print_message(MSG_RUN_PAUSED, address);
+}
+
+/** Let the user know there is no history left to go back through */
+void display_history_start(word_t pc) {
+    char address[6];
+    sprintf(address, "x%04X", pc);
+    print_message(MSG_HISTORY_START, address);
+}
+
+/** Let the user know a step or run was dropped while GETC waited */
+void display_core_busy(word_t pc) {
+    char address[6];
+    sprintf(address, "x%04X", pc);
+    print_message(MSG_CORE_BUSY, address);
 }
 
 /** Prints a message pertaining to a user operation. It could be a prompt if the
@@ -341,9 +558,11 @@ void display_save_file_name(char *output_file_name, int size) {
 }
 
 /** Reprompt for a file name since the last one was an error */
-void display_get_file_error(char *input_file_name, int size) {
-    print_message(MSG_FILE_NOT_LOADED, NULL);
-    move(MEM_PANEL_HEIGHT + HEIGHT_PADDING + 1, strlen(MSG_FILE_NOT_LOADED) + 4);
+void display_get_file_error(const char *reason, char *input_file_name, int size) {
+    print_message(MSG_FILE_NOT_LOADED, (char *)reason);
+    /* The message is the format with its %s replaced by the reason */
+    int length = strlen(MSG_FILE_NOT_LOADED) - strlen("%s") + strlen(reason);
+    move(MEM_PANEL_HEIGHT + HEIGHT_PADDING + 1, length + 4);
     echo();
     getnstr(input_file_name, size);
     noecho();
@@ -363,6 +582,19 @@ void display_get_file_success(char *input_file_name) {
     print_message(MSG_LOADED, input_file_name);
 }
 
+/** Let the user know nothing was loaded since GETC was waiting */
+void display_get_file_busy() { print_message(MSG_FILE_BUSY, NULL); }
+
+/** Reads the labels from the listing beside the program, the program's name ending in .lst
+ * instead. The memory panel is rebuilt since any of its text might now use them */
+void display_load_symbols(display_p disp, const char *program_name) {
+    char listing_name[FILENAME_SIZE];
+    loader_replace_extension(program_name, ASSEMBLER_LISTING_EXTENSION, listing_name,
+                             sizeof(listing_name));
+    disasm_load_symbols(disp->disasm, listing_name);
+    disp->rebuild_needed = TRUE;
+}
+
 /** Let the user know their file was successfully saved. */
 void display_save_file_success(char *input_file_name) {
     print_message(MSG_SAVED, input_file_name);
@@ -393,12 +625,40 @@ void display_edit_mem_get_data(char *data_input, char *address_input) {
     noecho();
 }
 
-void display_edit_mem_success(display_p disp, char *address_input, word_t address) {
+/** Let the user know which execution engine is now selected */
+void display_engine_selected(char *engine_name) { print_message(MSG_ENGINE, engine_name); }
+
+void display_edit_mem_success(display_p disp, const lc3_snapshot_t *lc3_snapshot,
+                              char *address_input, word_t address) {
     /** Print the success message */
     print_message(MSG_EDIT_MEM_SUCCESS, address_input);
     /** Set the memory menu index to show the user the new data */
-    int index = get_index_from_address(address);
-    set_current_item(disp->menus[INDEX_MEM], disp->menu_list_items[INDEX_MEM][index]);
+    select_mem_address(disp, lc3_snapshot, address);
+}
+
+/** Moves the memory panel's window so that it covers the address. Returns whether the window
+ * moved, in which case the memory menu needs rebuilding */
+bool_t move_mem_window(display_p disp, word_t address) {
+    if (address >= disp->mem_window_start &&
+        address < disp->mem_window_start + MEM_WINDOW_SIZE) {
+        return FALSE;
+    }
+    /* Start the window on the page holding the address, but don't run past xFFFF */
+    unsigned int start = address - address % MEMORY_PAGE_SIZE;
+    if (start + MEM_WINDOW_SIZE > MEMORY_SIZE) {
+        start = MEMORY_SIZE - MEM_WINDOW_SIZE;
+    }
+    disp->mem_window_start = start;
+    return TRUE;
+}
+
+/** Selects the address in the memory panel, moving the window there first if needed */
+void select_mem_address(display_p disp, const lc3_snapshot_t *lc3_snapshot, word_t address) {
+    if (move_mem_window(disp, address) == TRUE) {
+        rebuild_display(disp, lc3_snapshot, address);
+    }
+    set_current_item(disp->menus[INDEX_MEM],
+                     disp->menu_list_items[INDEX_MEM][address - disp->mem_window_start]);
     wrefresh(disp->menu_windows[INDEX_MEM]);
 }
 
@@ -413,7 +673,7 @@ void print_window_titles(display_p disp) {
     print_title(disp->menu_windows[INDEX_MEM], 1, "Memory",
                 (disp->active_window == INDEX_MEM) ? COLOR_PAIR(2) : COLOR_PAIR(1));
     mvwaddch(disp->menu_windows[INDEX_MEM], 2, 0, ACS_LTEE);
-    mvwhline(disp->menu_windows[INDEX_MEM], 2, 1, ACS_HLINE, 38);
+    mvwhline(disp->menu_windows[INDEX_MEM], 2, 1, ACS_HLINE, disp->mem_panel_width - 2);
 
     print_title(disp->menu_windows[INDEX_CPU], 1, "CPU Registers",
                 (disp->active_window == INDEX_CPU) ? COLOR_PAIR(2) : COLOR_PAIR(1));
@@ -479,21 +739,203 @@ void restore_menu_indicies(display_p disp) {
     }
 }
 
-/** Updates the Ncurses window each time this function is called. The arrays
- * containing menu data are all rebuilt, the menus are reinstantiated,
- * positioned, and posted to the windows. */
-void display_update(display_p disp, const lc3_snapshot_t lc3_snapshot) {
+/** Updates the Ncurses window each time this function is called. The menus are only rebuilt
+ * when the memory window has to move; otherwise just the items whose text changed since the
+ * last frame are rewritten in place and highlighted, and a frame with no changes draws nothing.
+ * Memory is only compared on pages the snapshot says were written since the last frame */
+void display_update(display_p disp, const lc3_snapshot_t *lc3_snapshot) {
+    word_t pc = lc3_snapshot->cpu_snapshot.pc;
     /* Set selected item in memory to be current PC */
-    size_t pc_index = get_index_from_address(lc3_snapshot.cpu_snapshot.pc);
-    set_current_item(disp->menus[INDEX_MEM], disp->menu_list_items[INDEX_MEM][pc_index]); 
+    if (move_mem_window(disp, pc) == TRUE || disp->rebuild_needed == TRUE) {
+        rebuild_display(disp, lc3_snapshot, pc);
+        return;
+    }
+
+    fill_descriptions(disp, lc3_snapshot);
+    const memory_snapshot_t *memory = &lc3_snapshot->memory_snapshot;
+    if (memory->generation != disp->shown_generation) {
+        int page = disp->mem_window_start / MEMORY_PAGE_SIZE;
+        int last_page = page + MEM_WINDOW_SIZE / MEMORY_PAGE_SIZE;
+        for (; page < last_page; page++) {
+            if (memory->page_generations[page] > disp->shown_generation) {
+                int i = page * MEMORY_PAGE_SIZE - disp->mem_window_start;
+                int end = i + MEMORY_PAGE_SIZE;
+                for (; i < end; i++) {
+                    fill_mem_description(disp, lc3_snapshot, i);
+                }
+            }
+        }
+        disp->shown_generation = memory->generation;
+    }
+
+    if (pc != disp->shown_pc) {
+        set_current_item(disp->menus[INDEX_MEM],
+                         disp->menu_list_items[INDEX_MEM][pc - disp->mem_window_start]);
+        wrefresh(disp->menu_windows[INDEX_MEM]);
+        disp->shown_pc = pc;
+    }
+    draw_changes(disp);
+} /** display_update end */
+
+/** Returns the strings backing the items of the specified menu */
+menu_string_t *get_menu_strings(display_p disp, int menu) {
+    switch (menu) {
+    case INDEX_REG:
+        return disp->reg_strings;
+    case INDEX_MEM:
+        return disp->mem_strings;
+    default:
+        return disp->cpu_strings;
+    }
+}
+
+/** Sets the description of a menu item, remembering the item if its text changed */
+void set_description(display_p disp, int menu, int item, const char *text) {
+    char *description = get_menu_strings(disp, menu)[item].description;
+    if (strcmp(description, text) != 0) {
+        strcpy(description, text);
+        disp->changed_items[menu][disp->changed_counts[menu]++] = item;
+    }
+}
+
+/** Fills in the descriptions of the register and CPU items from the snapshot */
+void fill_descriptions(display_p disp, const lc3_snapshot_t *lc3_snapshot) {
+    const cpu_snapshot_t *cpu = &lc3_snapshot->cpu_snapshot;
+    char text[sizeof(((menu_string_t *)NULL)->description)];
+    int i;
+    for (i = 0; i < disp->item_counts[INDEX_REG]; ++i) {
+        sprintf(text, "x%04X", cpu->registers[i]);
+        set_description(disp, INDEX_REG, i, text);
+    }
+
+    word_t words[] = {cpu->pc,  cpu->ir,  lc3_snapshot->alu_snapshot.a,
+                      lc3_snapshot->alu_snapshot.b, cpu->mar, cpu->mdr};
+    for (i = 0; i < 6; i++) {
+        sprintf(text, "x%04X", words[i]);
+        set_description(disp, INDEX_CPU, i, text);
+    }
+    sprintf(text, "%d", cpu->cc_n);
+    set_description(disp, INDEX_CPU, 6, text);
+    /* Inserting a blank one so the CC stuff looks better */
+    set_description(disp, INDEX_CPU, 7, " ");
+    sprintf(text, "%d", cpu->cc_z);
+    set_description(disp, INDEX_CPU, 8, text);
+    sprintf(text, "%d", cpu->cc_p);
+    set_description(disp, INDEX_CPU, 9, text);
+}
+
+/** Fills in the description of one item in the memory window from the snapshot */
+void fill_mem_description(display_p disp, const lc3_snapshot_t *lc3_snapshot, int item) {
+    char text[sizeof(((menu_string_t *)NULL)->description)];
+    word_t address = disp->mem_window_start + item;
+    /* If this memory location has a breakpoint we will display a small square
+     * next to it. Watched words are marked [r] for reads, [w] for writes or [a] for both */
+    const char *marker = "   ";
+    if (disp->breakpoints[address]) {
+        marker = "[x]";
+    } else if (disp->watchpoints[address] == (BREAKPOINT_READ | BREAKPOINT_WRITE)) {
+        marker = "[a]";
+    } else if (disp->watchpoints[address] == BREAKPOINT_READ) {
+        marker = "[r]";
+    } else if (disp->watchpoints[address] == BREAKPOINT_WRITE) {
+        marker = "[w]";
+    }
+    word_t word = lc3_snapshot->memory_snapshot.data[address];
+    if (disp->mem_panel_width == MEM_PANEL_NARROW_WIDTH) {
+        sprintf(text, "x%04X %s", word, marker);
+        set_description(disp, INDEX_MEM, item, text);
+        return;
+    }
+    const char *label = disasm_get_label(disp->disasm, address);
+    sprintf(text, "x%04X %s %-*.*s %-*.*s", word, marker, MEM_LABEL_WIDTH, MEM_LABEL_WIDTH,
+            (label == NULL) ? "" : label, MEM_INSTRUCTION_WIDTH, MEM_INSTRUCTION_WIDTH,
+            disasm_get(disp->disasm, address, word));
+    set_description(disp, INDEX_MEM, item, text);
+}
+
+/** Rewrites the description of a menu item in place, if it's scrolled into view. The menu lays
+ * items out as mark, name, description spacing, description, in row-major order */
+void draw_description(display_p disp, int menu, int item, bool_t highlight) {
+    MENU *m = disp->menus[menu];
+    int rows, cols, spacing_description, spacing_rows, spacing_cols;
+    menu_format(m, &rows, &cols);
+    menu_spacing(m, &spacing_description, &spacing_rows, &spacing_cols);
+    int row = item / cols - top_row(m);
+    if (row < 0 || row >= rows) {
+        return;
+    }
+    int mark_width = strlen(menu_mark(m));
+    int item_width = mark_width + disp->name_widths[menu] + spacing_description +
+                     disp->description_widths[menu];
+    int x = (item % cols) * (item_width + spacing_cols) + mark_width + disp->name_widths[menu] +
+            spacing_description;
+
+    chtype attributes = (item_index(current_item(m)) == item) ? menu_fore(m) : menu_back(m);
+    if (highlight == TRUE) {
+        attributes |= COLOR_PAIR(3) | A_BOLD;
+    }
+    wattron(disp->menu_subs[menu], attributes);
+    mvwprintw(disp->menu_subs[menu], row * spacing_rows, x, "%-*s",
+              disp->description_widths[menu], get_menu_strings(disp, menu)[item].description);
+    wattroff(disp->menu_subs[menu], attributes);
+}
+
+/** Clears the highlights from the last frame and draws the items that changed in this one */
+void draw_changes(display_p disp) {
+    int menu, i;
+    bool_t drawn = FALSE;
+    for (menu = 0; menu < 3; menu++) {
+        if (disp->changed_counts[menu] == 0 && disp->lit_counts[menu] == 0) {
+            continue;
+        }
+        for (i = 0; i < disp->lit_counts[menu]; i++) {
+            draw_description(disp, menu, disp->lit_items[menu][i], FALSE);
+        }
+        for (i = 0; i < disp->changed_counts[menu]; i++) {
+            draw_description(disp, menu, disp->changed_items[menu][i], TRUE);
+        }
+        memcpy(disp->lit_items[menu], disp->changed_items[menu],
+               sizeof(int) * disp->changed_counts[menu]);
+        disp->lit_counts[menu] = disp->changed_counts[menu];
+        disp->changed_counts[menu] = 0;
+        wnoutrefresh(disp->menu_subs[menu]);
+        drawn = TRUE;
+    }
+    if (drawn == TRUE) {
+        doupdate();
+    }
+}
+
+/** Records how wide the widest item name and description of a menu are, which is how the menu
+ * sizes its columns */
+void measure_menu(display_p disp, int menu) {
+    menu_string_t *strings = get_menu_strings(disp, menu);
+    int i;
+    disp->name_widths[menu] = 0;
+    disp->description_widths[menu] = 0;
+    for (i = 0; i < disp->item_counts[menu]; i++) {
+        int name_width = strlen(strings[i].label);
+        int description_width = strlen(strings[i].description);
+        if (name_width > disp->name_widths[menu]) {
+            disp->name_widths[menu] = name_width;
+        }
+        if (description_width > disp->description_widths[menu]) {
+            disp->description_widths[menu] = description_width;
+        }
+    }
+}
+
+/** Rebuilds every menu from the snapshot, with the specified address selected in the memory
+ * panel. The address must be inside the memory window */
+void rebuild_display(display_p disp, const lc3_snapshot_t *lc3_snapshot, word_t selected) {
     save_menu_indicies(disp);
+    disp->saved_menu_index[INDEX_MEM] = selected - disp->mem_window_start;
     free_display(disp);
 
     int i;
+    fill_descriptions(disp, lc3_snapshot);
     for (i = 0; i < disp->item_counts[INDEX_REG]; ++i) {
         sprintf(disp->reg_strings[i].label, "R%d:", i);
-        sprintf(disp->reg_strings[i].description, "x%04X",
-                lc3_snapshot.cpu_snapshot.registers[i]);
         disp->menu_list_items[INDEX_REG][i] =
             new_item(disp->reg_strings[i].label, disp->reg_strings[i].description);
     }
@@ -501,18 +943,8 @@ void display_update(display_p disp, const lc3_snapshot_t lc3_snapshot) {
 
     /* Create the items for the memory */
     for (i = 0; i < disp->item_counts[INDEX_MEM]; ++i) {
-        sprintf(disp->mem_strings[i].label,
-                "x%04X:", lc3_snapshot.starting_address + i); /* So to start at x3000 */
-        /* If this memory location has a breakpoint we will display a small square
-         * next to it. */
-        if (disp->breakpoints[i]) {
-            sprintf(disp->mem_strings[i].description, "x%04X [x]",
-                    lc3_snapshot.memory_snapshot.data[i]);
-        } else {
-            sprintf(disp->mem_strings[i].description, "x%04X    ",
-                    lc3_snapshot.memory_snapshot.data[i]);
-        }
-
+        sprintf(disp->mem_strings[i].label, "x%04X:", disp->mem_window_start + i);
+        fill_mem_description(disp, lc3_snapshot, i);
         disp->menu_list_items[INDEX_MEM][i] =
             new_item(disp->mem_strings[i].label, disp->mem_strings[i].description);
     }
@@ -520,28 +952,15 @@ void display_update(display_p disp, const lc3_snapshot_t lc3_snapshot) {
 
     /* Create items for the CPU */
     sprintf(disp->cpu_strings[0].label, "PC:");
-    sprintf(disp->cpu_strings[0].description, "x%04X", lc3_snapshot.cpu_snapshot.pc);
     sprintf(disp->cpu_strings[1].label, "IR:");
-    sprintf(disp->cpu_strings[1].description, "x%04X", lc3_snapshot.cpu_snapshot.ir);
     sprintf(disp->cpu_strings[2].label, "ALU A:");
-    sprintf(disp->cpu_strings[2].description, "x%04X", lc3_snapshot.alu_snapshot.a);
     sprintf(disp->cpu_strings[3].label, "ALU B:");
-    sprintf(disp->cpu_strings[3].description, "x%04X", lc3_snapshot.alu_snapshot.b);
     sprintf(disp->cpu_strings[4].label, "MAR:");
-    sprintf(disp->cpu_strings[4].description, "x%04X", lc3_snapshot.cpu_snapshot.mar);
     sprintf(disp->cpu_strings[5].label, "MDR:");
-    sprintf(disp->cpu_strings[5].description, "x%04X", lc3_snapshot.cpu_snapshot.mdr);
     sprintf(disp->cpu_strings[6].label, "CC N:");
-    sprintf(disp->cpu_strings[6].description, "%d", lc3_snapshot.cpu_snapshot.cc_n);
-    
-    /* Inserting a blank one so the CC stuff looks better */
     sprintf(disp->cpu_strings[7].label, " ");
-
-    sprintf(disp->cpu_strings[7].description, " ");
     sprintf(disp->cpu_strings[8].label, "CC Z:");
-    sprintf(disp->cpu_strings[8].description, "%d", lc3_snapshot.cpu_snapshot.cc_z);
     sprintf(disp->cpu_strings[9].label, "CC P:");
-    sprintf(disp->cpu_strings[9].description, "%d", lc3_snapshot.cpu_snapshot.cc_p);
 
     for (i = 0; i < CPU_ELEMENTS_COUNT; i++) {
         disp->menu_list_items[INDEX_CPU][i] =
@@ -549,6 +968,16 @@ void display_update(display_p disp, const lc3_snapshot_t lc3_snapshot) {
     }
     disp->menu_list_items[INDEX_CPU][i] = new_item((char *)NULL, (char *)NULL);
 
+    /* Everything is drawn fresh, so nothing is left to highlight */
+    for (i = 0; i < 3; i++) {
+        measure_menu(disp, i);
+        disp->changed_counts[i] = 0;
+        disp->lit_counts[i] = 0;
+    }
+    disp->shown_generation = lc3_snapshot->memory_snapshot.generation;
+    disp->shown_pc = lc3_snapshot->cpu_snapshot.pc;
+    disp->rebuild_needed = FALSE;
+
     /* Create menu instances from the lists */
     for (i = 0; i < 3; i++) {
         disp->menus[i] = new_menu((ITEM **)(disp->menu_list_items[i]));
@@ -565,20 +994,15 @@ void display_update(display_p disp, const lc3_snapshot_t lc3_snapshot) {
 
     /* The the menu sub ??? and its foprint_messrmat menu_format is number of rows, columns
      * for the list's visible contents and scrolls the rest of the list. */
-    set_menu_sub(disp->menus[INDEX_REG],
-                 derwin(disp->menu_windows[INDEX_REG], REG_PANEL_HEIGHT - 4,
-                        REG_PANEL_WIDTH - 4, 3, 1));
+    set_menu_sub(disp->menus[INDEX_REG], disp->menu_subs[INDEX_REG]);
     set_menu_format(disp->menus[INDEX_REG], REG_PANEL_HEIGHT - 4, 1);
 
     /* Memory... */
-    set_menu_sub(disp->menus[INDEX_MEM],
-                 derwin(disp->menu_windows[INDEX_MEM], MEM_PANEL_HEIGHT - 4,
-                        MEM_PANEL_WIDTH - 4, 3, 1));
+    set_menu_sub(disp->menus[INDEX_MEM], disp->menu_subs[INDEX_MEM]);
     set_menu_format(disp->menus[INDEX_MEM], MEM_PANEL_HEIGHT - 4, 1);
 
     /* CPU... */
-    set_menu_sub(disp->menus[INDEX_CPU], derwin(disp->menu_windows[INDEX_CPU], CPU_PANEL_HEIGHT - 4,
-                                          CPU_PANEL_WIDTH - 4, 3, 1));
+    set_menu_sub(disp->menus[INDEX_CPU], disp->menu_subs[INDEX_CPU]);
     set_menu_format(disp->menus[INDEX_CPU], MEM_PANEL_HEIGHT - 4, 2);
 
     /* Set menu mark to the string " * " */
@@ -598,42 +1022,37 @@ void display_update(display_p disp, const lc3_snapshot_t lc3_snapshot) {
     attron(COLOR_PAIR(2));
     mvprintw(0, 4, "Welcome to the LC-3 Simulator Simulator!");
     mvprintw(MEM_PANEL_HEIGHT + 2, 4,
-             "1) Load, 2) Save, 3) Step, 4) Run, 5) Show Mem, 6) Edit 8) Set Brkpt 9) Exit");
-    mvprintw(LINES - 2, 0, "Use Tab (\\t) to switch active panels");
-    mvprintw(LINES - 1, 0, "Arrow Keys to navigate (9 to Exit)");
+             "1) Load 2) Save 3) Step 4) Run 5) Show Mem 6) Edit 7) Engine 8) Brkpt 9) Exit");
+    mvprintw(LINES - 2, 0, "Use Tab (\\t) to switch active panels, b) to step back and r) to "
+                           "run back to the last breakpoint");
+    mvprintw(LINES - 1, 0,
+             "Arrow Keys to navigate, w) to watch memory, c) to break on a condition (9 to Exit)");
     attroff(COLOR_PAIR(2));
 
     restore_menu_indicies(disp);
     refresh();
-} /** display_update end */
+}
 
 /** The main logic loop for the debug monitor. Listens for user keystrokes and
  * performs debugging operations */
-display_result_t display_loop(display_p disp, const lc3_snapshot_t lc3_snapshot) {
+display_result_t display_loop(display_p disp, const lc3_snapshot_t *lc3_snapshot) {
     /* Input vars used for 5) Show Mem, 6)Edit Mem, 8) Set/Unset breakpoint */
     char word_input_raw[6];
     word_t word_input;
+    /* Input and confirmation for w) Watch */
+    char kinds_input[4];
+    char confirm[32];
 
     /** This variable is used to return information about the user's selection
      * back to the LC-3. We load it with whether the current PC is a breakpoint. */
     display_result_t display_return = DISPLAY_NO_ACTION;
 
-    /** If the LC3 has halted show the nice halted message */
-    if (lc3_snapshot.is_halted) {
-        print_message(MSG_CPU_HALTED, NULL);
-    }
-
-    /** If the LC3 has encountered a breakpoint show the breakpoint hit message
-     * Todo: This will occur even if the user is already stepping through code which is unnecessary.
-     */
-    bool_t breakpoint = disp->breakpoints[get_index_from_address(lc3_snapshot.cpu_snapshot.pc)];
-    if (breakpoint == TRUE) {
-        /** We can reuse an existing char array to store this string */
-        sprintf(word_input_raw, "x%04X", lc3_snapshot.cpu_snapshot.pc);
-        print_message(MSG_BRKPT_HIT, word_input_raw);
-    }
-
+    /** Give up waiting after a frame so the simulator can draw whatever the LC3 did in the
+     * meantime. The halted and breakpoint messages are shown when the simulator reports them */
     int c;
+    for (c = 0; c < 3; c++) {
+        wtimeout(disp->menu_windows[c], 1000 / RUN_FRAME_RATE);
+    }
     /* If the user selected 9) to quit this while loop will exit */
     while ((c = wgetch(disp->menu_windows[disp->active_window])) != 57) {
         
@@ -657,10 +1076,10 @@ display_result_t display_loop(display_p disp, const lc3_snapshot_t lc3_snapshot)
             break;
         case 51:
             /* User selected 3) to step through code */
-            if (lc3_snapshot.file_loaded == FALSE) {
+            if (lc3_snapshot->file_loaded == FALSE) {
                 print_message(MSG_STEP_NO_FILE, NULL);
                 continue;
-            } else if (lc3_snapshot.is_halted) {
+            } else if (lc3_snapshot->is_halted) {
                 print_message(MSG_CPU_HALTED_STEP, NULL);
                 continue;
             } else {
@@ -670,10 +1089,10 @@ display_result_t display_loop(display_p disp, const lc3_snapshot_t lc3_snapshot)
             break;
         case 52:
             /* User selected 4) to run code */
-            if (lc3_snapshot.file_loaded == FALSE) {
+            if (lc3_snapshot->file_loaded == FALSE) {
                 print_message(MSG_RUN_NO_FILE, NULL);
                 continue;
-            } else if (lc3_snapshot.is_halted) {
+            } else if (lc3_snapshot->is_halted) {
                 print_message(MSG_CPU_HALTED_RUN, NULL);
                 continue;
             } else {
@@ -681,6 +1100,24 @@ display_result_t display_loop(display_p disp, const lc3_snapshot_t lc3_snapshot)
                 display_return = DISPLAY_RUN;
             }
             break;
+        case 'b':
+            /* User selected b) to step back through the history */
+            if (lc3_snapshot->file_loaded == FALSE) {
+                print_message(MSG_STEP_NO_FILE, NULL);
+                continue;
+            }
+            print_message(MSG_STEP_BACK, NULL);
+            display_return = DISPLAY_STEP_BACK;
+            break;
+        case 'r':
+            /* User selected r) to run backwards to the last breakpoint */
+            if (lc3_snapshot->file_loaded == FALSE) {
+                print_message(MSG_RUN_NO_FILE, NULL);
+                continue;
+            }
+            print_message(MSG_REVERSE, NULL);
+            display_return = DISPLAY_REVERSE;
+            break;
         case 53:
             /* User selected 5) to display a specific memory address */
             print_message(MSG_DISPLAY_MEM, NULL);
@@ -691,16 +1128,19 @@ display_result_t display_loop(display_p disp, const lc3_snapshot_t lc3_snapshot)
             getstr(word_input_raw);
             noecho();
             word_input = get_word_from_string(word_input_raw);
-            set_current_item(disp->menus[INDEX_MEM], disp->menu_list_items[INDEX_MEM][get_index_from_address(word_input)]);
-            wrefresh(disp->menu_windows[INDEX_MEM]);
+            select_mem_address(disp, lc3_snapshot, word_input);
             continue;
         case 54:
             /* User selected 6) to edit a memory location */
             display_return = DISPLAY_EDIT_MEM;
             break;
+        case 55:
+            /* User selected 7) to switch execution engines */
+            display_return = DISPLAY_ENGINE;
+            break;
         case 56:
             /* User selected 8) to set/unset a breakpoint */
-            if (lc3_snapshot.file_loaded == FALSE) {
+            if (lc3_snapshot->file_loaded == FALSE) {
                 print_message(MSG_SET_UNSET_BRKPT_NO_FILE, NULL);
                 continue;
             } else {
@@ -712,19 +1152,76 @@ display_result_t display_loop(display_p disp, const lc3_snapshot_t lc3_snapshot)
                 getstr(word_input_raw);
                 noecho();
                 word_input = get_word_from_string(word_input_raw);
-                disp->breakpoints[get_index_from_address(word_input)] =
-                    !disp->breakpoints[get_index_from_address(word_input)];
+                disp->breakpoints[word_input] = !disp->breakpoints[word_input];
+                disp->breakpoint_address = word_input;
                 /** Reuse the existing char array. It's just big enough for the string
                  * "unset\0". */
-                sprintf(word_input_raw, disp->breakpoints[get_index_from_address(word_input)]
+                sprintf(word_input_raw, disp->breakpoints[word_input]
                                             ? "set"
                                             : "unset");
                 print_message(MSG_SET_UNSET_BRKPT_CONFIRM, word_input_raw);
-                display_update(disp, lc3_snapshot);
-                set_current_item(disp->menus[INDEX_MEM], disp->menu_list_items[INDEX_MEM][get_index_from_address(word_input)]);
-                wrefresh(disp->menu_windows[INDEX_MEM]);
+                move_mem_window(disp, word_input);
+                rebuild_display(disp, lc3_snapshot, word_input);
+                display_return = DISPLAY_BREAKPOINT;
             }
-            continue;
+            break;
+        case 'w':
+            /* User selected w) to watch a memory location for reads or writes */
+            if (lc3_snapshot->file_loaded == FALSE) {
+                print_message(MSG_SET_UNSET_BRKPT_NO_FILE, NULL);
+                continue;
+            }
+            print_message(MSG_WATCH_ADDR, NULL);
+            move(MEM_PANEL_HEIGHT + HEIGHT_PADDING + 1, strlen(MSG_WATCH_ADDR) + 4);
+            echo();
+            getnstr(word_input_raw, sizeof(word_input_raw) - 1);
+            word_input = get_word_from_string(word_input_raw);
+            sprintf(word_input_raw, "x%04X", word_input);
+            print_message(MSG_WATCH_KIND, word_input_raw);
+            move(MEM_PANEL_HEIGHT + HEIGHT_PADDING + 1,
+                 strlen(MSG_WATCH_KIND) + strlen(word_input_raw) + 2);
+            getnstr(kinds_input, sizeof(kinds_input) - 1);
+            noecho();
+            disp->watch_kinds = (strchr(kinds_input, 'r') ? BREAKPOINT_READ : 0) |
+                                (strchr(kinds_input, 'w') ? BREAKPOINT_WRITE : 0);
+            disp->watchpoints[word_input] = disp->watch_kinds;
+            disp->breakpoint_address = word_input;
+            sprintf(confirm, "%s %s", disp->watch_kinds ? "Watching" : "Stopped watching",
+                    word_input_raw);
+            print_message(MSG_WATCH_CONFIRM, confirm);
+            move_mem_window(disp, word_input);
+            rebuild_display(disp, lc3_snapshot, word_input);
+            display_return = DISPLAY_WATCHPOINT;
+            break;
+        case 'c':
+            /* User selected c) to set a breakpoint that only stops when a condition holds */
+            if (lc3_snapshot->file_loaded == FALSE) {
+                print_message(MSG_SET_UNSET_BRKPT_NO_FILE, NULL);
+                continue;
+            }
+            print_message(MSG_CONDITION_ADDR, NULL);
+            move(MEM_PANEL_HEIGHT + HEIGHT_PADDING + 1, strlen(MSG_CONDITION_ADDR) + 4);
+            echo();
+            getnstr(word_input_raw, sizeof(word_input_raw) - 1);
+            word_input = get_word_from_string(word_input_raw);
+            sprintf(word_input_raw, "x%04X", word_input);
+            print_message(MSG_CONDITION, word_input_raw);
+            move(MEM_PANEL_HEIGHT + HEIGHT_PADDING + 1,
+                 strlen(MSG_CONDITION) + strlen(word_input_raw) + 2);
+            getnstr(disp->condition, sizeof(disp->condition) - 1);
+            noecho();
+            breakpoint_condition_t condition;
+            if (breakpoint_parse_condition(disp->condition, &condition) == FALSE) {
+                print_message(MSG_CONDITION_ERROR, disp->condition);
+                continue;
+            }
+            disp->breakpoints[word_input] = true;
+            disp->breakpoint_address = word_input;
+            print_message(MSG_CONDITION_CONFIRM, word_input_raw);
+            move_mem_window(disp, word_input);
+            rebuild_display(disp, lc3_snapshot, word_input);
+            display_return = DISPLAY_CONDITION;
+            break;
         case KEY_DOWN:
             menu_driver(disp->menus[disp->active_window], REQ_DOWN_ITEM);
             //restore_menu_indicies(disp);
@@ -36,13 +36,20 @@
 #define DISPLAY_RUN 4
 #define DISPLAY_EDIT_MEM 5
 #define DISPLAY_NO_ACTION 6
+#define DISPLAY_ENGINE 7
+#define DISPLAY_BREAKPOINT 8
+#define DISPLAY_STEP_BACK 9
+#define DISPLAY_REVERSE 10
+#define DISPLAY_WATCHPOINT 11
+#define DISPLAY_CONDITION 12
 
 typedef int display_result_t;
 
 typedef struct display_t *display_p;
 typedef struct cpu_t *cpu_p;
 
-/** Allocates and initializes the Display */
+/** Allocates and initializes the Display. Returns NULL, after saying why, if the terminal is
+ * too small for it */
 display_p display_create();
 
 /** Reinitializes the display by distruction and reallocation */
@@ -50,10 +57,11 @@ void display_reset(display_p);
 
 /** Updates the display with the specified snapshot. Does not wait for the user to give a
  * command before returning control back to the LC3 simulator */
-void display_update(display_p, const lc3_snapshot_t);
+void display_update(display_p, const lc3_snapshot_t *);
 
-/** Main loop for the display. Waits for the user to select a command */
-display_result_t display_loop(display_p, const lc3_snapshot_t);
+/** Main loop for the display. Waits for the user to select a command, or returns
+ * DISPLAY_NO_ACTION if none is selected within a frame so the caller can draw new snapshots */
+display_result_t display_loop(display_p, const lc3_snapshot_t *);
 
 /** Deallocate the Display */
 int display_destroy(display_p);
@@ -64,12 +72,19 @@ char display_get_input(display_p);
 /** Prompt for a hex file name to load */
 void display_get_file_name(char *, int);
 
-/** Reprompt for another file name since the last one was an error or didn't exist */
-void display_get_file_error(char *, int);
+/** Reprompt for another file name since the last one couldn't be loaded, saying why */
+void display_get_file_error(const char *reason, char *, int);
 
 /** Let the user know their file input was accepted */
 void display_get_file_success(char *);
 
+/** Let the user know nothing was loaded because the program is waiting for input */
+void display_get_file_busy();
+
+/** Shows the labels from the program's listing (the same name ending in .lst) in the memory
+ * panel's disassembly, or none if it has no listing */
+void display_load_symbols(display_p, const char *program_name);
+
 /** Prompt for a hex file name to load */
 void display_save_file_name(char *, int);
 
@@ -86,7 +101,11 @@ void display_edit_mem_get_address(char *);
 void display_edit_mem_get_data(char *data_input, char *address_input);
 
 /** Let the user know they have successfully edited the memory and show them the memory location */
-void display_edit_mem_success(display_p, char *address_input, word_t address);
+void display_edit_mem_success(display_p, const lc3_snapshot_t *, char *address_input,
+                              word_t address);
+
+/** Let the user know which execution engine is now selected */
+void display_engine_selected(char *engine_name);
 
 /** Print a general display message (not console output) */
 void print_message(const char *message, char *arg);
@@ -97,4 +116,48 @@ void display_print_output(display_p, char);
 /** Returns whether the Display has a breakpoint set at the specified address */
 bool_t display_has_breakpoint(display_p, word_t);
 
+/** Gets the address of the breakpoint that was just set or unset, after display_loop returns
+ * DISPLAY_BREAKPOINT */
+word_t display_get_breakpoint_address(display_p);
+
+/** Gets the BREAKPOINT_READ/BREAKPOINT_WRITE kinds of access the watchpoint at the breakpoint
+ * address is now set to, after display_loop returns DISPLAY_WATCHPOINT. 0 means it was
+ * cleared */
+int display_get_watch_kinds(display_p);
+
+/** Gets the condition for the breakpoint at the breakpoint address, after display_loop returns
+ * DISPLAY_CONDITION. It has already been checked to parse */
+const char *display_get_condition(display_p);
+
+/** What display_poll_key returns if no key was pressed */
+#define DISPLAY_NO_KEY -1
+
+/** Pauses a run once keys go to the program (Esc) */
+#define DISPLAY_PAUSE_KEY 27
+
+/** Returns the key pressed within the timeout (in milliseconds), or DISPLAY_NO_KEY. Used to
+ * pause Run mode, and to type to a program reading the keyboard while it runs */
+int display_poll_key(display_p, int);
+
+/** Let the user know that keys typed during a run now go to the program */
+void display_keyboard_attached();
+
+/** Let the user know the LC3 halted */
+void display_halted();
+
+/** Let the user know a breakpoint was hit at the specified PC */
+void display_breakpoint_hit(word_t pc);
+
+/** Let the user know the instruction before the specified PC read or wrote a watched word */
+void display_watchpoint_hit(word_t pc);
+
+/** Let the user know Run was paused at the specified PC */
+void display_run_paused(word_t pc);
+
+/** Let the user know there is no history left to go back through from the specified PC */
+void display_history_start(word_t pc);
+
+/** Let the user know a step or run was dropped while GETC waited for input at the PC */
+void display_core_busy(word_t pc);
+
 #endif
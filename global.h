@@ -27,14 +27,22 @@
 #ifndef GLOBAL_H
 #define GLOBAL_H
 
+#include <stddef.h>
+
 /** Constants for representing boolean value */
 #define FALSE 0
 #define TRUE 1
 
-/** Configuration constants */
+/** Configuration constants. Memory covers the whole 16-bit address space and is allocated a
+ * page at a time as it gets written */
 #define REGISTER_SIZE 8
-#define MEMORY_SIZE 512
-#define MEMORY_ADDRESS_MIN 0x3000
+#define MEMORY_SIZE 0x10000
+#define MEMORY_ADDRESS_MIN 0x0000
+#define MEMORY_PAGE_SIZE 256
+#define MEMORY_PAGE_COUNT (MEMORY_SIZE / MEMORY_PAGE_SIZE)
+
+/** Where user programs start by default and where the PC points after a reset */
+#define USER_SPACE_START 0x3000
 
 /** Register address indicies */
 #define R0 0
@@ -46,6 +54,7 @@
 #define R6 6
 #define R7 7
 
+#define MASK_CC_N 4 /* 100 */
 #define MASK_CC_Z 2 /* 010 */
 #define MASK_CC_P 1 /* 001 */
 
@@ -87,10 +96,15 @@ struct alu_snapshot_t {
     word_t result;
 };
 
-/** Snapshot of the memory. See LC3 snapshot comment */
+/** Snapshot of the memory. See LC3 snapshot comment. At 64K words this is far too big to
+ * pass around by value, so it is only ever handed out by const pointer */
 typedef struct memory_snapshot_t memory_snapshot_t;
 struct memory_snapshot_t {
     word_t data[MEMORY_SIZE];
+    /** Counts every write to memory. A page whose generation is higher than the generation of
+     * an earlier snapshot has been written since that snapshot was taken */
+    unsigned long generation;
+    unsigned long page_generations[MEMORY_PAGE_COUNT];
 };
 
 /** The LC3 snapshot contains all the data for the LC3 at a specific moment in time. This
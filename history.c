@@ -0,0 +1,218 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  History Module File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#include "history.h"
+#include "cpu.h"
+#include "memory.h"
+#include <stdlib.h>
+
+/** The registers and flags an instruction can change */
+typedef struct history_state_t {
+    word_t pc;
+    word_t ir;
+    word_t registers[REGISTER_SIZE];
+    cc_t cc;
+    bool_t is_halted;
+    word_t psr;
+    word_t saved_ssp;
+    word_t saved_usp;
+} history_state_t;
+
+/** One instruction in the undo log: the state before it ran, and the word it overwrote */
+typedef struct history_entry_t {
+    history_state_t state;
+    bool_t writes_memory;
+    word_t write_address;
+    word_t old_data;
+} history_entry_t;
+
+/** The whole LC3 as it was before the instruction at position ran */
+typedef struct history_checkpoint_t {
+    bool_t is_valid;
+    unsigned long long position;
+    history_state_t state;
+    memory_snapshot_t memory;
+} history_checkpoint_t;
+
+/** The undo log is a ring of window entries. Position counts every instruction recorded so
+ * far; the last count of them are the ones still in the ring */
+typedef struct history_t {
+    history_entry_t *entries;
+    unsigned long window;
+    unsigned long count;
+    unsigned long long position;
+
+    /** A checkpoint is taken every interval instructions, into the slot for its position */
+    history_checkpoint_t *checkpoints;
+    unsigned long interval;
+} history_t;
+
+/** Copies the registers and flags out of/into the LC3 */
+void history_save_state(lc3_p, history_state_t *);
+void history_load_state(lc3_p, const history_state_t *);
+
+/** Allocates a history that remembers up to window instructions */
+history_p history_create(unsigned long window) {
+    history_p history = calloc(1, sizeof(history_t));
+    history->window = (window > 0) ? window : 1;
+    history->entries = calloc(history->window, sizeof(history_entry_t));
+    history->interval = (history->window + HISTORY_CHECKPOINTS - 1) / HISTORY_CHECKPOINTS;
+    history->checkpoints = calloc(HISTORY_CHECKPOINTS, sizeof(history_checkpoint_t));
+    return history;
+}
+
+/** Deallocates the history */
+void history_destroy(history_p history) {
+    free(history->checkpoints);
+    free(history->entries);
+    free(history);
+}
+
+/** Forgets everything recorded. The checkpoints' memory copies are kept so the next ones
+ * only need the pages that changed */
+void history_clear(history_p history) {
+    int i;
+    history->count = 0;
+    for (i = 0; i < HISTORY_CHECKPOINTS; i++) {
+        history->checkpoints[i].is_valid = FALSE;
+    }
+}
+
+/** Records what the next instruction is about to change */
+void history_record(history_p history, lc3_p lc3) {
+    if (history->position % history->interval == 0) {
+        unsigned long slot = (history->position / history->interval) % HISTORY_CHECKPOINTS;
+        history_checkpoint_t *checkpoint = &history->checkpoints[slot];
+        checkpoint->is_valid = TRUE;
+        checkpoint->position = history->position;
+        history_save_state(lc3, &checkpoint->state);
+        memory_update_snapshot(lc3->memory, &checkpoint->memory);
+    }
+
+    history_entry_t *entry = &history->entries[history->position % history->window];
+    history_save_state(lc3, &entry->state);
+    entry->writes_memory = lc3_get_store_address(lc3, &entry->write_address);
+    if (entry->writes_memory == TRUE) {
+        entry->old_data = memory_peek(lc3->memory, entry->write_address);
+    }
+    history->position++;
+    if (history->count < history->window) {
+        history->count++;
+    }
+}
+
+/** Undoes the last instruction recorded */
+bool_t history_step_back(history_p history, lc3_p lc3) {
+    if (history->count == 0) {
+        return FALSE;
+    }
+    history->position--;
+    history->count--;
+    history_entry_t *entry = &history->entries[history->position % history->window];
+    if (entry->writes_memory == TRUE) {
+        memory_poke(lc3->memory, entry->write_address, entry->old_data);
+    }
+    history_load_state(lc3, &entry->state);
+    return TRUE;
+}
+
+/** Goes back to the last time the PC was at a breakpoint. The undo log is searched first,
+ * which only reads it; then the LC3 jumps to the nearest checkpoint at or after that point and
+ * undoes the rest one instruction at a time */
+bool_t history_reverse(history_p history, lc3_p lc3, breakpoints_p breakpoints) {
+    unsigned long long oldest = history->position - history->count;
+    unsigned long long target = oldest;
+    bool_t hit = FALSE;
+    unsigned long long i;
+    for (i = history->position; i > oldest; i--) {
+        word_t pc = history->entries[(i - 1) % history->window].state.pc;
+        if (breakpoints_is_set(breakpoints, pc)) {
+            target = i - 1;
+            hit = TRUE;
+            break;
+        }
+    }
+
+    /** A checkpoint past the current position was taken before an earlier step back, so it
+     * belongs to a future that may not happen again */
+    history_checkpoint_t *nearest = NULL;
+    int j;
+    for (j = 0; j < HISTORY_CHECKPOINTS; j++) {
+        history_checkpoint_t *checkpoint = &history->checkpoints[j];
+        if (checkpoint->is_valid == TRUE && checkpoint->position >= target &&
+            checkpoint->position < history->position &&
+            (nearest == NULL || checkpoint->position < nearest->position)) {
+            nearest = checkpoint;
+        }
+    }
+    if (nearest != NULL) {
+        memory_restore_snapshot(lc3->memory, &nearest->memory);
+        history_load_state(lc3, &nearest->state);
+        history->count -= history->position - nearest->position;
+        history->position = nearest->position;
+    }
+    while (history->position > target) {
+        history_step_back(history, lc3);
+    }
+    return hit;
+}
+
+/** Gets how many instructions have been recorded, less those stepped back through */
+unsigned long long history_get_position(history_p history) { return history->position; }
+
+/** Copies the registers and flags out of the LC3 */
+void history_save_state(lc3_p lc3, history_state_t *state) {
+    int i;
+    word_t *registers = cpu_get_registers(lc3->cpu);
+    for (i = 0; i < REGISTER_SIZE; i++) {
+        state->registers[i] = registers[i];
+    }
+    state->pc = cpu_get_pc(lc3->cpu);
+    state->ir = cpu_get_ir(lc3->cpu);
+    state->cc = cpu_get_cc(lc3->cpu);
+    state->is_halted = lc3_is_halted(lc3);
+    state->psr = lc3->psr;
+    state->saved_ssp = lc3->saved_ssp;
+    state->saved_usp = lc3->saved_usp;
+}
+
+/** Copies the registers and flags into the LC3 */
+void history_load_state(lc3_p lc3, const history_state_t *state) {
+    int i;
+    word_t *registers = cpu_get_registers(lc3->cpu);
+    for (i = 0; i < REGISTER_SIZE; i++) {
+        registers[i] = state->registers[i];
+    }
+    cpu_set_pc(lc3->cpu, state->pc);
+    cpu_set_ir(lc3->cpu, state->ir);
+    cpu_set_cc(lc3->cpu, state->cc);
+    if (lc3_is_halted(lc3) != state->is_halted) {
+        lc3_toggle_halted(lc3);
+    }
+    lc3->psr = state->psr;
+    lc3->saved_ssp = state->saved_ssp;
+    lc3->saved_usp = state->saved_usp;
+}
@@ -0,0 +1,75 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  History Module Header File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include "breakpoint.h"
+#include "global.h"
+#include "lc3.h"
+
+/* Command line flag. Sets how many instructions can be stepped back through; 0 turns the
+ * history off */
+#define HISTORY_FLAG "--history="
+#define HISTORY_WINDOW_DEFAULT 100000
+
+/** How many full checkpoints are kept across the window. They are spread evenly, so going
+ * back any distance never has to undo more than a sixteenth of the window one instruction at a
+ * time */
+#define HISTORY_CHECKPOINTS 16
+
+typedef struct history_t *history_p;
+
+/** Allocates a history that remembers up to window instructions. Its memory use is fixed
+ * from here on: the undo log has an entry per instruction and each checkpoint holds a copy
+ * of the memory */
+history_p history_create(unsigned long window);
+
+/** Deallocates the history */
+void history_destroy(history_p);
+
+/** Forgets everything recorded. Needed whenever the LC3 changes other than by executing
+ * instructions, like when a file is loaded or memory is edited */
+void history_clear(history_p);
+
+/** Records what the next instruction is about to change so it can be undone. Must be called
+ * before each instruction. Once the window is full the oldest instruction is forgotten */
+void history_record(history_p, lc3_p);
+
+/** Undoes the last instruction recorded. Takes the same time no matter how far back it is.
+ * Returns FALSE if there is nothing left to undo */
+bool_t history_step_back(history_p, lc3_p);
+
+/** Goes back to the last time the PC was at a breakpoint, or as far back as the history goes.
+ * Conditions aren't looked at and watchpoints don't stop it. Returns TRUE if it stopped at a
+ * breakpoint */
+bool_t history_reverse(history_p, lc3_p, breakpoints_p);
+
+/** Gets how many instructions have been recorded, less those stepped back through. Only the
+ * difference between two readings means anything */
+unsigned long long history_get_position(history_p);
+
+#endif
@@ -0,0 +1,794 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  JIT Module File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#include "jit.h"
+#include "cpu.h"
+#include "global.h"
+#include "lc3.h"
+#include "memory.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+
+#include <sys/mman.h>
+
+/** Host register numbers as used in the x86-64 ModRM/REX encodings */
+#define HOST_RAX 0
+#define HOST_RCX 1
+#define HOST_RDX 2
+#define HOST_RBX 3
+#define HOST_RSP 4
+#define HOST_RBP 5
+#define HOST_RSI 6
+#define HOST_RDI 7
+#define HOST_R8 8
+#define HOST_R15 15
+
+/** Inside a block LC3 register Rn lives in host register r(8+n), RBX holds the context and
+ * EBP holds the last value written to a register, which is all the CC is derived from. R0-R3
+ * sit in caller-saved registers, so they are written back to the context around helper calls */
+#define HOST_REG(lc3_reg) (HOST_R8 + (lc3_reg))
+#define HOST_CONTEXT HOST_RBX
+#define HOST_LAST_RESULT HOST_RBP
+#define CALLER_SAVED_LC3_REGS 4
+
+/** ALU opcodes and /digit extensions */
+#define X86_ADD_RR 0x01
+#define X86_AND_RR 0x21
+#define X86_EXT_ADD 0
+#define X86_EXT_AND 4
+#define X86_EXT_SUB 5
+#define X86_EXT_CMP 7
+
+/** Condition codes for Jcc */
+#define X86_CC_B 0x2
+#define X86_CC_E 0x4
+#define X86_CC_NE 0x5
+#define X86_CC_S 0x8
+#define X86_CC_NS 0x9
+#define X86_CC_LE 0xE
+#define X86_CC_G 0xF
+
+/** Room left in the buffer below which the cache is flushed before compiling another block */
+#define JIT_BLOCK_RESERVE (JIT_MAX_BLOCK_LENGTH * 160 + 256)
+
+/** The state a block works on. Loaded into host registers on entry and written back on exit */
+typedef struct jit_context_t {
+    word_t registers[REGISTER_SIZE];
+    word_t pc;
+    word_t last_result;
+    word_t ir;
+    unsigned long remaining;
+    unsigned char **link_slot;
+    memory_p memory;
+    bool_t invalidated;
+} jit_context_t;
+
+/** One translated basic block */
+typedef struct jit_block_t {
+    word_t start;
+    word_t length;
+    unsigned char *entry;
+} jit_block_t;
+
+typedef struct jit_t {
+    lc3_p lc3;
+    jit_context_t context;
+
+    /** The code buffer. The enter/exit stubs sit at the front and survive flushes. It is never
+     * writable and executable at once: it is flipped to writable to emit a block or link a
+     * chain slot, and back to executable before running one */
+    unsigned char *buffer;
+    bool_t writable;
+    unsigned char *cursor;
+    unsigned char *first_block;
+    unsigned char *exit_stub;
+    void (*enter)(jit_context_t *, unsigned char *);
+
+    /** Live blocks, and a lookup table from LC3 address to block */
+    jit_block_t blocks[JIT_MAX_BLOCKS];
+    int block_count;
+    jit_block_t *table[MEMORY_SIZE];
+
+    /** Set when a translated word was written; the cache is flushed before the next block runs */
+    bool_t needs_flush;
+    unsigned long generation;
+} jit_t, *jit_p;
+
+/** Memory callback for writes to translated words. The address isn't used: any such write
+ * flushes the whole cache, since other blocks may be chained into the one covering it */
+void jit_invalidate(void *, word_t address);
+
+/** Makes the buffer writable or executable, if it isn't already. Returns FALSE if the kernel
+ * refuses */
+bool_t jit_set_writable(jit_p, bool_t);
+
+/** Writes the enter and exit stubs at the front of the buffer */
+void emit_stubs(jit_p);
+
+/** Translates the block starting at the address. Returns NULL if the first instruction is one
+ * the JIT doesn't translate */
+jit_block_t *compile_block(jit_p, word_t);
+
+/** Returns the block starting at the address, compiling it if needed */
+jit_block_t *lookup_block(jit_p, word_t);
+
+/** Helpers called from translated code for memory access */
+word_t jit_read(jit_context_t *, word_t);
+int jit_write(jit_context_t *, word_t, word_t);
+
+/** Allocates a JIT for the given LC3 */
+jit_p jit_create(lc3_p lc3) {
+    jit_p jit = calloc(1, sizeof(jit_t));
+    if (jit == NULL) {
+        return NULL;
+    }
+    void *buffer = mmap(NULL, JIT_BUFFER_SIZE, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffer == MAP_FAILED) {
+        free(jit);
+        return NULL;
+    }
+    jit->lc3 = lc3;
+    jit->buffer = buffer;
+    jit->writable = TRUE;
+    jit->cursor = buffer;
+    jit->context.memory = lc3->memory;
+    emit_stubs(jit);
+    jit->first_block = jit->cursor;
+    /** Checked up front, so a policy against executable mappings falls back to the fast
+     * interpreter like a host without a JIT does */
+    if (jit_set_writable(jit, FALSE) == FALSE) {
+        munmap(buffer, JIT_BUFFER_SIZE);
+        free(jit);
+        return NULL;
+    }
+    memory_set_invalidate_handler(lc3->memory, jit_invalidate, jit);
+    return jit;
+}
+
+/** Unhooks from memory and releases the executable buffer */
+void jit_destroy(jit_p jit) {
+    jit_flush(jit);
+    memory_set_invalidate_handler(jit->lc3->memory, NULL, NULL);
+    munmap(jit->buffer, JIT_BUFFER_SIZE);
+    free(jit);
+}
+
+/** Drops every translated block and unmarks the words they were compiled from */
+void jit_flush(jit_p jit) {
+    int i;
+    for (i = 0; i < jit->block_count; i++) {
+        jit_block_t *block = &jit->blocks[i];
+        word_t j;
+        for (j = 0; j < block->length; j++) {
+            memory_unmark_translated(jit->lc3->memory, block->start + j);
+        }
+        jit->table[block->start] = NULL;
+    }
+    jit->block_count = 0;
+    jit->cursor = jit->first_block;
+    jit->needs_flush = FALSE;
+    jit->generation++;
+}
+
+/** Flips the buffer between writable and executable. Emitting and linking happen in bursts
+ * between runs, so once the hot blocks are built and chained this stops being called */
+bool_t jit_set_writable(jit_p jit, bool_t writable) {
+    if (jit->writable == writable) {
+        return TRUE;
+    }
+    int protection = writable ? (PROT_READ | PROT_WRITE) : (PROT_READ | PROT_EXEC);
+    if (mprotect(jit->buffer, JIT_BUFFER_SIZE, protection) != 0) {
+        return FALSE;
+    }
+    jit->writable = writable;
+    return TRUE;
+}
+
+/** Memory callback for writes to translated words. Blocks can be chained to each other, so
+ * rather than unlinking one block the whole cache is flushed once control is back in C */
+void jit_invalidate(void *context, word_t address) {
+    (void)address;
+    jit_p jit = context;
+    jit->needs_flush = TRUE;
+    jit->context.invalidated = TRUE;
+}
+
+/** Runs the LC3 using translated basic blocks */
+run_result_t jit_run(jit_p jit, unsigned long *budget) {
+    lc3_p lc3 = jit->lc3;
+    cpu_p cpu = lc3->cpu;
+    jit_context_t *context = &jit->context;
+
+    while (lc3_is_halted(lc3) == FALSE) {
+        if (*budget == 0) {
+            return RUN_BUDGET;
+        }
+        if (jit->needs_flush) {
+            jit_flush(jit);
+        }
+
+        /** Blocks derive the CC from the last value written, which can't express the CC
+         * before the first register write, so that stretch is interpreted */
+        word_t pc = cpu_get_pc(cpu);
+        cc_t cc = cpu_get_cc(cpu);
+        jit_block_t *block = (cc != 0) ? lookup_block(jit, pc) : NULL;
+        if (block == NULL || block->length > *budget ||
+            jit_set_writable(jit, FALSE) == FALSE) {
+            unsigned long one = 1;
+            run_result_t result = lc3_run_fast(lc3, &one);
+            (*budget)--;
+            if (result == RUN_TRAP) {
+                return RUN_TRAP;
+            }
+            continue;
+        }
+
+        memcpy(context->registers, cpu_get_registers(cpu), sizeof(context->registers));
+        context->pc = pc;
+        context->last_result = (cc & MASK_CC_N) ? 0x8000 : ((cc & MASK_CC_Z) ? 0 : 1);
+        context->remaining = *budget;
+        context->link_slot = NULL;
+        context->invalidated = FALSE;
+        jit->enter(context, block->entry);
+
+        memcpy(cpu_get_registers(cpu), context->registers, sizeof(context->registers));
+        cpu_set_pc(cpu, context->pc);
+        cpu_set_ir(cpu, context->ir);
+        cpu_set_cc(cpu, (context->last_result & 0x8000)
+                            ? MASK_CC_N
+                            : ((context->last_result == 0) ? MASK_CC_Z : MASK_CC_P));
+        *budget = context->remaining;
+
+        /** The block left through a chain slot that still points at the exit stub. Now that
+         * the next block is known, point the slot straight at it */
+        if (context->link_slot != NULL && jit->needs_flush == FALSE) {
+            unsigned long generation = jit->generation;
+            jit_block_t *next = lookup_block(jit, context->pc);
+            if (next != NULL && generation == jit->generation &&
+                jit_set_writable(jit, TRUE) == TRUE) {
+                *context->link_slot = next->entry;
+            }
+        }
+    }
+    return RUN_HALTED;
+}
+
+/** Returns the block starting at the address, compiling it if needed */
+jit_block_t *lookup_block(jit_p jit, word_t address) {
+    jit_block_t *block = jit->table[address];
+    if (block == NULL) {
+        block = compile_block(jit, address);
+    }
+    return block;
+}
+
+/** Reads memory on behalf of translated code */
+word_t jit_read(jit_context_t *context, word_t address) {
+    return memory_get_data(context->memory, address);
+}
+
+/** Writes memory on behalf of translated code. Returns nonzero if the write hit translated code,
+ * in which case the block leaves straight away */
+int jit_write(jit_context_t *context, word_t address, word_t data) {
+    memory_write(context->memory, address, data);
+    return context->invalidated;
+}
+
+/*
+ * x86-64 emitter
+ */
+
+void emit8(jit_p jit, unsigned char byte) { *jit->cursor++ = byte; }
+
+void emit16(jit_p jit, uint16_t value) {
+    memcpy(jit->cursor, &value, sizeof(value));
+    jit->cursor += sizeof(value);
+}
+
+void emit32(jit_p jit, uint32_t value) {
+    memcpy(jit->cursor, &value, sizeof(value));
+    jit->cursor += sizeof(value);
+}
+
+void emit64(jit_p jit, uint64_t value) {
+    memcpy(jit->cursor, &value, sizeof(value));
+    jit->cursor += sizeof(value);
+}
+
+/** Emits a REX prefix if one is needed for a 64 bit operand or an extended register */
+void emit_rex(jit_p jit, int wide, int reg, int rm) {
+    unsigned char rex = 0x40 | (wide ? 8 : 0) | ((reg >> 3) << 2) | (rm >> 3);
+    if (rex != 0x40) {
+        emit8(jit, rex);
+    }
+}
+
+void emit_modrm(jit_p jit, int mod, int reg, int rm) {
+    emit8(jit, (unsigned char)((mod << 6) | ((reg & 7) << 3) | (rm & 7)));
+}
+
+/** Patches a rel32 field so it lands on the target */
+void patch_rel32(unsigned char *field, unsigned char *target) {
+    int32_t rel = (int32_t)(target - (field + 4));
+    memcpy(field, &rel, sizeof(rel));
+}
+
+/** op r32, r32 (mov/add/and) */
+void emit_rr(jit_p jit, unsigned char opcode, int dst, int src) {
+    emit_rex(jit, 0, src, dst);
+    emit8(jit, opcode);
+    emit_modrm(jit, 3, src, dst);
+}
+
+void emit_mov_rr(jit_p jit, int dst, int src) { emit_rr(jit, 0x89, dst, src); }
+
+/** add/and r32, imm32 */
+void emit_ri(jit_p jit, int extension, int dst, int32_t imm) {
+    emit_rex(jit, 0, 0, dst);
+    emit8(jit, 0x81);
+    emit_modrm(jit, 3, extension, dst);
+    emit32(jit, (uint32_t)imm);
+}
+
+/** mov r32, imm32 */
+void emit_mov_ri(jit_p jit, int dst, uint32_t imm) {
+    emit_rex(jit, 0, 0, dst);
+    emit8(jit, 0xB8 + (dst & 7));
+    emit32(jit, imm);
+}
+
+/** not r32 */
+void emit_not(jit_p jit, int dst) {
+    emit_rex(jit, 0, 0, dst);
+    emit8(jit, 0xF7);
+    emit_modrm(jit, 3, 2, dst);
+}
+
+/** movzx r32, r16 */
+void emit_movzx(jit_p jit, int dst, int src) {
+    emit_rex(jit, 0, dst, src);
+    emit8(jit, 0x0F);
+    emit8(jit, 0xB7);
+    emit_modrm(jit, 3, dst, src);
+}
+
+/** mov word [rbx + offset], r16 */
+void emit_store_context(jit_p jit, size_t offset, int src) {
+    emit8(jit, 0x66);
+    emit_rex(jit, 0, src, HOST_CONTEXT);
+    emit8(jit, 0x89);
+    emit_modrm(jit, 1, src, HOST_CONTEXT);
+    emit8(jit, (unsigned char)offset);
+}
+
+/** movzx r32, word [rbx + offset] */
+void emit_load_context(jit_p jit, int dst, size_t offset) {
+    emit_rex(jit, 0, dst, HOST_CONTEXT);
+    emit8(jit, 0x0F);
+    emit8(jit, 0xB7);
+    emit_modrm(jit, 1, dst, HOST_CONTEXT);
+    emit8(jit, (unsigned char)offset);
+}
+
+/** mov word [rbx + offset], imm16 */
+void emit_store_context_imm(jit_p jit, size_t offset, word_t value) {
+    emit8(jit, 0x66);
+    emit8(jit, 0xC7);
+    emit_modrm(jit, 1, 0, HOST_CONTEXT);
+    emit8(jit, (unsigned char)offset);
+    emit16(jit, value);
+}
+
+/** add/sub/cmp qword [rbx + offset], imm32 */
+void emit_context_qword_op(jit_p jit, int extension, size_t offset, uint32_t imm) {
+    emit8(jit, 0x48);
+    emit8(jit, 0x81);
+    emit_modrm(jit, 1, extension, HOST_CONTEXT);
+    emit8(jit, (unsigned char)offset);
+    emit32(jit, imm);
+}
+
+/** jmp rel32 to a known target */
+void emit_jmp(jit_p jit, unsigned char *target) {
+    emit8(jit, 0xE9);
+    emit32(jit, 0);
+    patch_rel32(jit->cursor - 4, target);
+}
+
+/** jcc rel32. Returns the rel32 field so it can be patched once the target is known */
+unsigned char *emit_jcc(jit_p jit, int condition) {
+    emit8(jit, 0x0F);
+    emit8(jit, 0x80 + condition);
+    emit32(jit, 0);
+    return jit->cursor - 4;
+}
+
+/** xor eax, eax; jmp exit. Leaves without asking the dispatcher to link anything */
+void emit_exit(jit_p jit) {
+    emit8(jit, 0x31);
+    emit8(jit, 0xC0);
+    emit_jmp(jit, jit->exit_stub);
+}
+
+/** Calls a C helper with the context as the first argument. The caller-saved LC3 registers are
+ * written back to the context first and reloaded afterwards */
+void emit_call(jit_p jit, void *helper) {
+    int i;
+    for (i = 0; i < CALLER_SAVED_LC3_REGS; i++) {
+        emit_store_context(jit, offsetof(jit_context_t, registers) + i * sizeof(word_t),
+                           HOST_REG(i));
+    }
+    /** mov rdi, rbx */
+    emit8(jit, 0x48);
+    emit8(jit, 0x89);
+    emit8(jit, 0xDF);
+    /** mov rax, imm64; call rax */
+    emit8(jit, 0x48);
+    emit8(jit, 0xB8);
+    emit64(jit, (uint64_t)(uintptr_t)helper);
+    emit8(jit, 0xFF);
+    emit8(jit, 0xD0);
+    for (i = 0; i < CALLER_SAVED_LC3_REGS; i++) {
+        emit_load_context(jit, HOST_REG(i),
+                          offsetof(jit_context_t, registers) + i * sizeof(word_t));
+    }
+}
+
+/** Loads ESI with base + offset truncated to 16 bits */
+void emit_address(jit_p jit, int base, int32_t offset) {
+    emit_mov_rr(jit, HOST_RSI, base);
+    if (offset != 0) {
+        emit_ri(jit, X86_EXT_ADD, HOST_RSI, offset);
+    }
+    emit_movzx(jit, HOST_RSI, HOST_RSI);
+}
+
+/** Writes AX to an LC3 register and records it as the last result for the CC */
+void emit_set_register(jit_p jit, reg_addr_t dr, int src) {
+    emit_movzx(jit, HOST_REG(dr), src);
+    emit_mov_rr(jit, HOST_LAST_RESULT, HOST_REG(dr));
+}
+
+/** Leaves through a chain slot. The slot starts out pointing at the exit stub; once the
+ * dispatcher knows the block at the target it repoints the slot so later runs jump straight
+ * there. Returns where the slot's rip-relative displacements need patching */
+unsigned char *emit_chain(jit_p jit, word_t target, word_t ir) {
+    emit_store_context_imm(jit, offsetof(jit_context_t, pc), target);
+    emit_store_context_imm(jit, offsetof(jit_context_t, ir), ir);
+    unsigned char *fixup = jit->cursor;
+    /** lea rax, [rip + slot] */
+    emit8(jit, 0x48);
+    emit8(jit, 0x8D);
+    emit8(jit, 0x05);
+    emit32(jit, 0);
+    /** jmp [rip + slot] */
+    emit8(jit, 0xFF);
+    emit8(jit, 0x25);
+    emit32(jit, 0);
+    return fixup;
+}
+
+/** Writes the enter and exit stubs at the front of the buffer */
+void emit_stubs(jit_p jit) {
+    int i;
+    /** enter(context, entry): save callee-saved registers, keep the stack 16 byte aligned for
+     * helper calls, load the LC3 state and jump to the block */
+    jit->enter = (void (*)(jit_context_t *, unsigned char *))jit->cursor;
+    emit8(jit, 0x53); /* push rbx */
+    emit8(jit, 0x55); /* push rbp */
+    emit8(jit, 0x41); /* push r12 */
+    emit8(jit, 0x54);
+    emit8(jit, 0x41); /* push r13 */
+    emit8(jit, 0x55);
+    emit8(jit, 0x41); /* push r14 */
+    emit8(jit, 0x56);
+    emit8(jit, 0x41); /* push r15 */
+    emit8(jit, 0x57);
+    emit8(jit, 0x48); /* sub rsp, 8 */
+    emit8(jit, 0x83);
+    emit8(jit, 0xEC);
+    emit8(jit, 0x08);
+    emit8(jit, 0x48); /* mov rbx, rdi */
+    emit8(jit, 0x89);
+    emit8(jit, 0xFB);
+    for (i = 0; i < REGISTER_SIZE; i++) {
+        emit_load_context(jit, HOST_REG(i),
+                          offsetof(jit_context_t, registers) + i * sizeof(word_t));
+    }
+    emit_load_context(jit, HOST_LAST_RESULT, offsetof(jit_context_t, last_result));
+    emit8(jit, 0xFF); /* jmp rsi */
+    emit8(jit, 0xE6);
+
+    /** exit: RAX holds the chain slot that was taken (or zero), PC and IR are already stored */
+    jit->exit_stub = jit->cursor;
+    emit8(jit, 0x48); /* mov [rbx + link_slot], rax */
+    emit8(jit, 0x89);
+    emit_modrm(jit, 1, HOST_RAX, HOST_CONTEXT);
+    emit8(jit, (unsigned char)offsetof(jit_context_t, link_slot));
+    for (i = 0; i < REGISTER_SIZE; i++) {
+        emit_store_context(jit, offsetof(jit_context_t, registers) + i * sizeof(word_t),
+                           HOST_REG(i));
+    }
+    emit_store_context(jit, offsetof(jit_context_t, last_result), HOST_LAST_RESULT);
+    emit8(jit, 0x48); /* add rsp, 8 */
+    emit8(jit, 0x83);
+    emit8(jit, 0xC4);
+    emit8(jit, 0x08);
+    emit8(jit, 0x41); /* pop r15 */
+    emit8(jit, 0x5F);
+    emit8(jit, 0x41); /* pop r14 */
+    emit8(jit, 0x5E);
+    emit8(jit, 0x41); /* pop r13 */
+    emit8(jit, 0x5D);
+    emit8(jit, 0x41); /* pop r12 */
+    emit8(jit, 0x5C);
+    emit8(jit, 0x5D); /* pop rbp */
+    emit8(jit, 0x5B); /* pop rbx */
+    emit8(jit, 0xC3); /* ret */
+}
+
+/** Whether an opcode is left to the interpreter */
+bool_t is_interpreted(opcode_t opcode) {
+    return opcode == OPCODE_TRAP || opcode == OPCODE_STACK || opcode == OPCODE_RTI;
+}
+
+/** Whether an opcode ends a block */
+bool_t ends_block(opcode_t opcode) {
+    return opcode == OPCODE_BR || opcode == OPCODE_JMP || opcode == OPCODE_JSR;
+}
+
+/** Emits a memory write and the early exit taken if it hit translated code. After k of the
+ * block's n instructions the unused part of the budget is handed back */
+void emit_write(jit_p jit, word_t next_pc, word_t ir, word_t unused) {
+    emit_call(jit, (void *)jit_write);
+    emit8(jit, 0x85); /* test eax, eax */
+    emit8(jit, 0xC0);
+    unsigned char *skip = emit_jcc(jit, X86_CC_E);
+    emit_store_context_imm(jit, offsetof(jit_context_t, pc), next_pc);
+    emit_store_context_imm(jit, offsetof(jit_context_t, ir), ir);
+    emit_context_qword_op(jit, X86_EXT_ADD, offsetof(jit_context_t, remaining), unused);
+    emit_exit(jit);
+    patch_rel32(skip, jit->cursor);
+}
+
+/** Translates the block starting at the address */
+jit_block_t *compile_block(jit_p jit, word_t start) {
+    memory_p memory = jit->lc3->memory;
+
+    /** Find the block's extent first, since its length is checked against the budget on entry */
+    word_t length = 0;
+    while (length < JIT_MAX_BLOCK_LENGTH) {
+        const decoded_t *d = memory_get_decoded(memory, start + length);
+        if (is_interpreted(d->opcode)) {
+            break;
+        }
+        length++;
+        if (ends_block(d->opcode)) {
+            break;
+        }
+    }
+    if (length == 0 || jit_set_writable(jit, TRUE) == FALSE) {
+        return NULL;
+    }
+
+    if (jit->block_count == JIT_MAX_BLOCKS ||
+        jit->cursor + JIT_BLOCK_RESERVE > jit->buffer + JIT_BUFFER_SIZE) {
+        jit_flush(jit);
+    }
+
+    jit_block_t *block = &jit->blocks[jit->block_count++];
+    block->start = start;
+    block->length = length;
+    block->entry = jit->cursor;
+
+    /** Up to two chain slots per block: taken and fall through */
+    unsigned char *fixups[2];
+    word_t targets[2];
+    int slot_count = 0;
+
+    /** Not enough budget left for the whole block: leave and let the interpreter finish */
+    emit_context_qword_op(jit, X86_EXT_CMP, offsetof(jit_context_t, remaining), length);
+    unsigned char *bail = emit_jcc(jit, X86_CC_B);
+    emit_context_qword_op(jit, X86_EXT_SUB, offsetof(jit_context_t, remaining), length);
+
+    word_t i;
+    bool_t terminated = FALSE;
+    for (i = 0; i < length; i++) {
+        word_t address = start + i;
+        word_t next_pc = address + 1;
+        const decoded_t *d = memory_get_decoded(memory, address);
+        memory_mark_translated(memory, address);
+
+        switch (d->opcode) {
+        case OPCODE_ADD:
+        case OPCODE_AND:
+            emit_mov_rr(jit, HOST_RAX, HOST_REG(d->sr1));
+            if (d->imm_mode) {
+                emit_ri(jit, d->opcode == OPCODE_ADD ? X86_EXT_ADD : X86_EXT_AND, HOST_RAX,
+                        d->imm_5);
+            } else {
+                emit_rr(jit, d->opcode == OPCODE_ADD ? X86_ADD_RR : X86_AND_RR, HOST_RAX,
+                        HOST_REG(d->sr2));
+            }
+            emit_set_register(jit, d->dr, HOST_RAX);
+            break;
+        case OPCODE_NOT:
+            emit_mov_rr(jit, HOST_RAX, HOST_REG(d->sr1));
+            emit_not(jit, HOST_RAX);
+            emit_set_register(jit, d->dr, HOST_RAX);
+            break;
+        case OPCODE_LEA:
+            emit_mov_ri(jit, HOST_RAX, (word_t)(next_pc + d->pc_offset_9));
+            emit_set_register(jit, d->dr, HOST_RAX);
+            break;
+        case OPCODE_LD:
+            emit_mov_ri(jit, HOST_RSI, (word_t)(next_pc + d->pc_offset_9));
+            emit_call(jit, (void *)jit_read);
+            emit_set_register(jit, d->dr, HOST_RAX);
+            break;
+        case OPCODE_LDR:
+            emit_address(jit, HOST_REG(d->sr1), d->pc_offset_6);
+            emit_call(jit, (void *)jit_read);
+            emit_set_register(jit, d->dr, HOST_RAX);
+            break;
+        case OPCODE_LDI:
+            emit_mov_ri(jit, HOST_RSI, (word_t)(next_pc + d->pc_offset_9));
+            emit_call(jit, (void *)jit_read);
+            emit_movzx(jit, HOST_RSI, HOST_RAX);
+            emit_call(jit, (void *)jit_read);
+            emit_set_register(jit, d->dr, HOST_RAX);
+            break;
+        case OPCODE_ST:
+            emit_mov_ri(jit, HOST_RSI, (word_t)(next_pc + d->pc_offset_9));
+            emit_mov_rr(jit, HOST_RDX, HOST_REG(d->dr));
+            emit_write(jit, next_pc, d->ir, length - i - 1);
+            break;
+        case OPCODE_STR:
+            emit_address(jit, HOST_REG(d->sr1), d->pc_offset_6);
+            emit_mov_rr(jit, HOST_RDX, HOST_REG(d->dr));
+            emit_write(jit, next_pc, d->ir, length - i - 1);
+            break;
+        case OPCODE_STI:
+            emit_mov_ri(jit, HOST_RSI, (word_t)(next_pc + d->pc_offset_9));
+            emit_call(jit, (void *)jit_read);
+            emit_movzx(jit, HOST_RSI, HOST_RAX);
+            emit_mov_rr(jit, HOST_RDX, HOST_REG(d->dr));
+            emit_write(jit, next_pc, d->ir, length - i - 1);
+            break;
+        case OPCODE_BR: {
+            word_t target = next_pc + d->pc_offset_9;
+            int condition = -1;
+            switch (d->nzp) {
+            case MASK_CC_N:
+                condition = X86_CC_S;
+                break;
+            case MASK_CC_Z:
+                condition = X86_CC_E;
+                break;
+            case MASK_CC_P:
+                condition = X86_CC_G;
+                break;
+            case MASK_CC_N | MASK_CC_Z:
+                condition = X86_CC_LE;
+                break;
+            case MASK_CC_Z | MASK_CC_P:
+                condition = X86_CC_NS;
+                break;
+            case MASK_CC_N | MASK_CC_P:
+                condition = X86_CC_NE;
+                break;
+            }
+            if (d->nzp == (MASK_CC_N | MASK_CC_Z | MASK_CC_P)) {
+                targets[slot_count] = target;
+                fixups[slot_count++] = emit_chain(jit, target, d->ir);
+            } else if (d->nzp == 0) {
+                targets[slot_count] = next_pc;
+                fixups[slot_count++] = emit_chain(jit, next_pc, d->ir);
+            } else {
+                /** test bp, bp sets SF from bit 15 and ZF when zero, which is the CC */
+                emit8(jit, 0x66);
+                emit8(jit, 0x85);
+                emit8(jit, 0xED);
+                unsigned char *taken = emit_jcc(jit, condition);
+                targets[slot_count] = next_pc;
+                fixups[slot_count++] = emit_chain(jit, next_pc, d->ir);
+                patch_rel32(taken, jit->cursor);
+                targets[slot_count] = target;
+                fixups[slot_count++] = emit_chain(jit, target, d->ir);
+            }
+            terminated = TRUE;
+            break;
+        }
+        case OPCODE_JSR:
+            if (d->jsr_imm_mode) {
+                word_t target = next_pc + d->pc_offset_11;
+                emit_mov_ri(jit, HOST_REG(R7), next_pc);
+                emit_mov_rr(jit, HOST_LAST_RESULT, HOST_REG(R7));
+                targets[slot_count] = target;
+                fixups[slot_count++] = emit_chain(jit, target, d->ir);
+                terminated = TRUE;
+                break;
+            }
+            /* JSRR is a JMP that links, which JMP does as well */
+        case OPCODE_JMP:
+            /** Read the base register before R7 is overwritten by the link */
+            emit_mov_rr(jit, HOST_RAX, HOST_REG(d->sr1));
+            emit_mov_ri(jit, HOST_REG(R7), next_pc);
+            emit_mov_rr(jit, HOST_LAST_RESULT, HOST_REG(R7));
+            emit_store_context(jit, offsetof(jit_context_t, pc), HOST_RAX);
+            emit_store_context_imm(jit, offsetof(jit_context_t, ir), d->ir);
+            emit_exit(jit);
+            terminated = TRUE;
+            break;
+        }
+    }
+
+    if (terminated == FALSE) {
+        /** Ran into an interpreted instruction or the length limit: fall through */
+        word_t last_ir = memory_get_decoded(memory, start + length - 1)->ir;
+        targets[slot_count] = start + length;
+        fixups[slot_count++] = emit_chain(jit, start + length, last_ir);
+    }
+
+    patch_rel32(bail, jit->cursor);
+    emit_exit(jit);
+
+    /** Registering the block first lets a loop back to its own start chain immediately */
+    jit->table[start] = block;
+
+    /** The chain slots follow the code, 8 byte aligned */
+    while ((uintptr_t)jit->cursor % 8 != 0) {
+        emit8(jit, 0xCC);
+    }
+    int j;
+    for (j = 0; j < slot_count; j++) {
+        unsigned char *slot = jit->cursor;
+        jit_block_t *target = jit->table[targets[j]];
+        emit64(jit, (uint64_t)(uintptr_t)(target != NULL ? target->entry : jit->exit_stub));
+        patch_rel32(fixups[j] + 3, slot);
+        patch_rel32(fixups[j] + 9, slot);
+    }
+    return block;
+}
+
+#else
+
+/** Without an x86-64 host there is nothing to translate to. jit_create returns NULL and the
+ * simulator falls back to the fast interpreter */
+jit_p jit_create(lc3_p lc3) { return NULL; }
+
+void jit_destroy(jit_p jit) {}
+
+void jit_flush(jit_p jit) {}
+
+run_result_t jit_run(jit_p jit, unsigned long *budget) { return RUN_BUDGET; }
+
+#endif
@@ -0,0 +1,59 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  JIT Module Header File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#ifndef JIT_H
+#define JIT_H
+
+#include "global.h"
+#include "lc3.h"
+
+/** Size of the executable buffer holding translated code */
+#define JIT_BUFFER_SIZE (1024 * 1024)
+/** The longest run of LC3 instructions compiled into one block */
+#define JIT_MAX_BLOCK_LENGTH 64
+/** How many blocks can be live before the translation cache is flushed */
+#define JIT_MAX_BLOCKS 8192
+
+typedef struct jit_t *jit_p;
+
+/** Allocates a JIT for the given LC3 and hooks it into the LC3's memory so blocks are dropped
+ * when the code they were compiled from is written. Returns NULL if the host is not x86-64 or
+ * an executable buffer could not be mapped */
+jit_p jit_create(lc3_p);
+
+/** Unhooks from memory and releases the executable buffer */
+void jit_destroy(jit_p);
+
+/** Drops every translated block */
+void jit_flush(jit_p);
+
+/** Runs the LC3 using translated basic blocks. Same contract as lc3_run_fast: returns on HALT, on
+ * a console TRAP (vector in the MAR) or once the budget is used up, and decrements the budget
+ * by the instructions executed. Instructions the JIT doesn't translate (TRAP, the stack opcode
+ * and RTI) are handed to lc3_run_fast one at a time */
+run_result_t jit_run(jit_p, unsigned long *budget);
+
+#endif
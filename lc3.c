@@ -26,17 +26,48 @@
 
 #include "lc3.h"
 #include "alu.h"
+#include "breakpoint.h"
 #include "cpu.h"
+#include "device.h"
 #include "global.h"
+#include "jit.h"
 #include "memory.h"
+#include "profile.h"
+#include "slc3.h"
 #include <stdlib.h>
+#include <string.h>
+
+/** GCC and Clang can jump straight through a table of label addresses, giving the fast engine
+ * one indirect branch per instruction. Other compilers fall back to a switch; the handler
+ * macros hide the difference */
+#if defined(__GNUC__)
+#define FAST_COMPUTED_GOTO 1
+#define FAST_DISPATCH(opcode) goto *dispatch_table[opcode];
+#define FAST_HANDLER(opcode, label) label
+#else
+#define FAST_COMPUTED_GOTO 0
+#define FAST_DISPATCH(opcode) switch (opcode)
+#define FAST_HANDLER(opcode, label) case opcode
+#endif
+
+/** The CC the CPU sets after the given value is written to a register */
+#define FAST_CC(value) (((value)&0x8000) ? MASK_CC_N : ((value) == 0 ? MASK_CC_Z : MASK_CC_P))
 
 /** Sets LC3 values to default starting values */
 void initialize_lc3(lc3_p);
 
+/** Initializes an LC3 in zeroed storage of lc3_size() bytes */
+lc3_p lc3_create_at(void *);
+
+/** Enters supervisor mode to service an interrupt or exception: the PSR and PC are pushed on
+ * the supervisor stack and the PC is loaded from the vector table */
+void enter_service_routine(lc3_p, trap_vector_t vector, word_t priority);
+
 /** Reinitializes the variables used during each phase of instruction processing */
 void initialize_intrastate(lc3_p);
 
+/** The field getters below read from the decoded copy of the IR made in lc3_decode */
+
 /** Fetches the opcode from the IR */
 opcode_t fetch_opcode(lc3_p);
 
@@ -87,10 +118,39 @@ word_t zext(trap_vector_t);
 
 /** Allocates and initializes a new LC3 module */
 lc3_p lc3_create() {
-    lc3_p lc3 = calloc(1, sizeof(lc3_t));
-    lc3->cpu = cpu_create();
-    lc3->alu = alu_create();
-    lc3->memory = memory_create();
+    void *storage = aligned_alloc(ARENA_ALIGNMENT, lc3_size());
+    memset(storage, 0, lc3_size());
+    return lc3_create_at(storage);
+}
+
+/** Allocates and initializes a new LC3 module from an arena */
+lc3_p lc3_create_in_arena(arena_p arena) {
+    void *storage = arena_alloc(arena);
+    if (storage == NULL) {
+        return NULL;
+    }
+    lc3_p lc3 = lc3_create_at(storage);
+    lc3->arena = arena;
+    return lc3;
+}
+
+/** Gets the number of bytes a single LC3 allocation takes */
+size_t lc3_size() {
+    return ARENA_ROUND_UP(sizeof(lc3_t)) + ARENA_ROUND_UP(cpu_size()) +
+           ARENA_ROUND_UP(alu_size()) + ARENA_ROUND_UP(memory_size());
+}
+
+/** Lays the LC3 out in zeroed storage: the LC3 itself, then the CPU, ALU and memory module,
+ * each starting on a cache line */
+lc3_p lc3_create_at(void *storage) {
+    char *next = storage;
+    lc3_p lc3 = (lc3_p)next;
+    next += ARENA_ROUND_UP(sizeof(lc3_t));
+    lc3->cpu = cpu_create_at(next);
+    next += ARENA_ROUND_UP(cpu_size());
+    lc3->alu = alu_create_at(next);
+    next += ARENA_ROUND_UP(alu_size());
+    lc3->memory = memory_create_at(next);
     initialize_lc3(lc3);
     return lc3;
 }
@@ -100,38 +160,47 @@ void lc3_reset(lc3_p lc3) {
     cpu_reset(lc3->cpu);
     alu_reset(lc3->alu);
     memory_reset(lc3->memory);
+    if (lc3->jit != NULL) {
+        jit_flush(lc3->jit);
+    }
     initialize_lc3(lc3);
 }
 
 /** Deallocates the LC3 module */
 void lc3_destroy(lc3_p lc3) {
-    cpu_destroy(lc3->cpu);
-    alu_destroy(lc3->alu);
-    memory_destroy(lc3->memory);
-    free(lc3);
+    if (lc3->jit != NULL) {
+        jit_destroy(lc3->jit);
+    }
+    /* The CPU, ALU and memory module live in the same allocation as the LC3 */
+    memory_destroy_at(lc3->memory);
+    if (lc3->arena != NULL) {
+        arena_free(lc3->arena, lc3);
+    } else {
+        free(lc3);
+    }
 }
 
-/** Compiles a snapshot of the LC3 for debugging and/or display purposes. */
-const lc3_snapshot_t lc3_get_snapshot(lc3_p lc3) {
-    lc3_snapshot_t snapshot;
-    snapshot.starting_address = lc3->starting_address;
-    snapshot.file_loaded = lc3->is_file_loaded;
-    snapshot.is_halted = lc3->is_halted;
-    snapshot.cpu_snapshot = cpu_get_snapshot(lc3->cpu);
-    snapshot.alu_snapshot = alu_get_snapshot(lc3->alu);
-    snapshot.memory_snapshot = memory_get_snapshot(lc3->memory);
-    return snapshot;
+/** Brings a snapshot of the LC3 up to date for debugging and/or display purposes. */
+void lc3_update_snapshot(lc3_p lc3, lc3_snapshot_t *snapshot) {
+    snapshot->starting_address = lc3->starting_address;
+    snapshot->file_loaded = lc3->is_file_loaded;
+    snapshot->is_halted = lc3->is_halted;
+    snapshot->cpu_snapshot = cpu_get_snapshot(lc3->cpu);
+    snapshot->alu_snapshot = alu_get_snapshot(lc3->alu);
+    memory_update_snapshot(lc3->memory, &snapshot->memory_snapshot);
 }
 
 void lc3_fetch(lc3_p lc3) {
-    /** Microstate 18 */
+    /** Microstate 18. An interrupt has already been taken by devices_service (microstate 49),
+     * so the fetch comes from its service routine */
     word_t pc = cpu_get_pc(lc3->cpu);
     cpu_set_mar(lc3->cpu, pc);
     cpu_increment_pc(lc3->cpu);
 
-    /** Microstate 33 */
+    /** Microstate 33. Instructions come from the stored words, the same ones the decoded side
+     * table and the other engines see, even where a device is mapped */
     word_t mar = cpu_get_mar(lc3->cpu);
-    word_t data = memory_get_data(lc3->memory, mar);
+    word_t data = memory_peek(lc3->memory, mar);
     cpu_set_mdr(lc3->cpu, data);
 
     /** Microstate 35 */
@@ -141,7 +210,19 @@ void lc3_fetch(lc3_p lc3) {
 
 void lc3_decode(lc3_p lc3) {
     /** Microstate 32
-     * The opcode is calculated from the IR and determines the subsequent path of execution */
+     * The opcode is calculated from the IR and determines the subsequent path of execution.
+     * The MAR still holds the address the IR was fetched from, so the fields come out of the
+     * memory's decoded side table instead of being extracted again. A restored or edited state
+     * can leave an IR that isn't the word at the MAR, so the entry has to match the IR or the
+     * IR is decoded on the spot */
+    word_t mar = cpu_get_mar(lc3->cpu);
+    word_t ir = cpu_get_ir(lc3->cpu);
+    const decoded_t *decoded = memory_get_decoded(lc3->memory, mar);
+    if (decoded->ir == ir) {
+        lc3->decoded = *decoded;
+    } else {
+        decoder_decode(ir, &lc3->decoded);
+    }
     lc3->opcode = fetch_opcode(lc3);
 }
 
@@ -213,7 +294,7 @@ void lc3_store_and(lc3_p lc3) {
 
 /** BR evaluate address */
 void lc3_eval_addr_br(lc3_p lc3) {
-    /** Microstate 32 */
+    /** Microstate 0 */
     bool_t cc_n = cpu_get_cc_n(lc3->cpu);
     bool_t cc_z = cpu_get_cc_z(lc3->cpu);
     bool_t cc_p = cpu_get_cc_p(lc3->cpu);
@@ -316,7 +397,7 @@ void lc3_fetch_op_ldi(lc3_p lc3) {
     /** Microstate 10 */
     cpu_set_mar(lc3->cpu, lc3->eval_addr_calculation);
 
-    /** Microstate 21 */
+    /** Microstate 24 */
     word_t mar = cpu_get_mar(lc3->cpu);
     word_t data = memory_get_data(lc3->memory, mar);
     cpu_set_mdr(lc3->cpu, data);
@@ -567,6 +648,27 @@ void lc3_store_stack(lc3_p lc3) {
     }
 }
 
+/** RTI execute */
+void lc3_execute_rti(lc3_p lc3) {
+    if (lc3->psr & PSR_USER) {
+        /** Microstate 44. Only the supervisor may return from an interrupt */
+        enter_service_routine(lc3, INTERRUPT_PRIVILEGE_VECTOR, lc3->psr & PSR_PRIORITY);
+        return;
+    }
+    /** Microstates 8, 36, 38, 39, 40, 42 and 34. The PC and PSR come off the supervisor stack,
+     * switching back to the user stack if that's the mode being returned to (59) */
+    word_t *reg = cpu_get_registers(lc3->cpu);
+    cpu_set_pc(lc3->cpu, memory_get_data(lc3->memory, reg[R6]));
+    word_t psr = memory_get_data(lc3->memory, reg[R6] + 1);
+    reg[R6] += 2;
+    lc3->psr = psr & (PSR_USER | PSR_PRIORITY);
+    cpu_set_cc(lc3->cpu, psr & PSR_CC);
+    if (psr & PSR_USER) {
+        lc3->saved_ssp = reg[R6];
+        reg[R6] = lc3->saved_usp;
+    }
+}
+
 /** TRAP execute */
 word_t lc3_execute_trap(lc3_p lc3) {
     /** This is an extra credit opportunity to fully implement trap according to Microstates
@@ -625,6 +727,287 @@ void lc3_trap_x25(lc3_p lc3) {
     }
 }
 
+/** Fast execution engine. Runs whole instructions straight from the decoded side table until
+ * HALT, a console TRAP or until the budget runs out. Each handler below does the same work as
+ * the matching eval address/fetch operands/execute/store functions above, including the R7 and
+ * CC side effects of JMP and the R5 status of the stack opcode, but without the MAR/MDR/ALU
+ * hand-offs between microstates */
+run_result_t lc3_run_fast(lc3_p lc3, unsigned long *budget) {
+#if FAST_COMPUTED_GOTO
+    static void *dispatch_table[16] = {&&op_br,  &&op_add, &&op_ld,  &&op_st,
+                                       &&op_jsr, &&op_and, &&op_ldr, &&op_str,
+                                       &&op_rti, &&op_not, &&op_ldi, &&op_sti,
+                                       &&op_jmp, &&op_stack, &&op_lea, &&op_trap};
+#endif
+    if (lc3->is_halted) {
+        return RUN_HALTED;
+    }
+
+    /** Architectural state is kept in locals while running and written back at the end */
+    memory_p memory = lc3->memory;
+    word_t *reg = cpu_get_registers(lc3->cpu);
+    word_t pc = cpu_get_pc(lc3->cpu);
+    cc_t cc = cpu_get_cc(lc3->cpu);
+    unsigned long remaining = *budget;
+    run_result_t result = RUN_BUDGET;
+    const decoded_t *d = NULL;
+    word_t address;
+    word_t data;
+    /** Profiling counters, pulled out of the profile so counting is a single increment */
+    profile_p profile = lc3->profile;
+    unsigned long long *pc_counts = NULL;
+    unsigned long long *opcode_counts = NULL;
+    unsigned long long *back_edge_counts = NULL;
+    if (profile != NULL) {
+        pc_counts = profile->pc_counts;
+        opcode_counts = profile->opcode_counts;
+        back_edge_counts = profile->back_edge_counts;
+    }
+    /** Only armed breakpoints are ever handed over, so without any this is one test of a
+     * local per instruction */
+    breakpoints_p breakpoints = lc3->breakpoints;
+    bool_t stop_after = FALSE;
+
+next:
+    if (breakpoints != NULL) {
+        /** A watched word was touched by the instruction that just ran */
+        if (stop_after == TRUE) {
+            result = RUN_BREAK;
+            goto done;
+        }
+        if (remaining != 0) {
+            switch (breakpoints_check(breakpoints, memory, pc, reg)) {
+            case BREAKPOINT_BEFORE:
+                result = RUN_BREAK;
+                goto done;
+            case BREAKPOINT_AFTER:
+                stop_after = TRUE;
+                break;
+            }
+        }
+    }
+    if (remaining == 0) {
+        goto done;
+    }
+    remaining--;
+    d = memory_get_decoded(memory, pc);
+    if (pc_counts != NULL) {
+        pc_counts[pc]++;
+        opcode_counts[d->opcode]++;
+        /** R6 doesn't hold a stack pointer until the program sets it */
+        address = reg[R6];
+        if (address != 0) {
+            if (address < profile->stack_low || profile->stack_high == 0) {
+                profile->stack_low = address;
+            }
+            if (address > profile->stack_high) {
+                profile->stack_high = address;
+            }
+        }
+    }
+    pc++;
+
+    FAST_DISPATCH(d->opcode) {
+    FAST_HANDLER(OPCODE_ADD, op_add):
+        data = reg[d->sr1] + (d->imm_mode ? (word_t)d->imm_5 : reg[d->sr2]);
+        reg[d->dr] = data;
+        cc = FAST_CC(data);
+        goto next;
+
+    FAST_HANDLER(OPCODE_AND, op_and):
+        data = reg[d->sr1] & (d->imm_mode ? (word_t)d->imm_5 : reg[d->sr2]);
+        reg[d->dr] = data;
+        cc = FAST_CC(data);
+        goto next;
+
+    FAST_HANDLER(OPCODE_NOT, op_not):
+        data = ~reg[d->sr1];
+        reg[d->dr] = data;
+        cc = FAST_CC(data);
+        goto next;
+
+    FAST_HANDLER(OPCODE_BR, op_br):
+        if (d->nzp & cc) {
+            /** A branch taken backwards is the back-edge of a loop */
+            if (back_edge_counts != NULL && d->pc_offset_9 < 0) {
+                back_edge_counts[(word_t)(pc - 1)]++;
+            }
+            pc += d->pc_offset_9;
+        }
+        goto next;
+
+    FAST_HANDLER(OPCODE_JMP, op_jmp):
+        /** Like lc3_store_jmp, RET and JMP also link through R7 */
+        address = reg[d->sr1];
+        reg[R7] = pc;
+        cc = FAST_CC(pc);
+        pc = address;
+        if (profile != NULL && d->sr1 == R7) {
+            profile_return(profile, pc, profile->instructions + *budget - remaining);
+        }
+        goto next;
+
+    FAST_HANDLER(OPCODE_JSR, op_jsr):
+        address = d->jsr_imm_mode ? (word_t)(pc + d->pc_offset_11) : reg[d->sr1];
+        reg[R7] = pc;
+        cc = FAST_CC(pc);
+        if (profile != NULL) {
+            profile_call(profile, address, pc, profile->instructions + *budget - remaining);
+        }
+        pc = address;
+        goto next;
+
+    FAST_HANDLER(OPCODE_LD, op_ld):
+        data = memory_get_data(memory, pc + d->pc_offset_9);
+        reg[d->dr] = data;
+        cc = FAST_CC(data);
+        goto next;
+
+    FAST_HANDLER(OPCODE_LDI, op_ldi):
+        address = memory_get_data(memory, pc + d->pc_offset_9);
+        data = memory_get_data(memory, address);
+        reg[d->dr] = data;
+        cc = FAST_CC(data);
+        goto next;
+
+    FAST_HANDLER(OPCODE_LDR, op_ldr):
+        data = memory_get_data(memory, reg[d->sr1] + d->pc_offset_6);
+        reg[d->dr] = data;
+        cc = FAST_CC(data);
+        goto next;
+
+    FAST_HANDLER(OPCODE_LEA, op_lea):
+        data = pc + d->pc_offset_9;
+        reg[d->dr] = data;
+        cc = FAST_CC(data);
+        goto next;
+
+    FAST_HANDLER(OPCODE_ST, op_st):
+        memory_write(memory, pc + d->pc_offset_9, reg[d->dr]);
+        goto next;
+
+    FAST_HANDLER(OPCODE_STI, op_sti):
+        address = memory_get_data(memory, pc + d->pc_offset_9);
+        memory_write(memory, address, reg[d->dr]);
+        goto next;
+
+    FAST_HANDLER(OPCODE_STR, op_str):
+        memory_write(memory, reg[d->sr1] + d->pc_offset_6, reg[d->dr]);
+        goto next;
+
+    FAST_HANDLER(OPCODE_STACK, op_stack):
+        address = reg[R6];
+        if (d->imm_mode == STACK_PUSH) {
+            if (address < STACK_MAX) {
+                reg[R5] = STACK_ERROR;
+                cc = FAST_CC(STACK_ERROR);
+                goto next;
+            }
+            reg[R5] = STACK_SUCCESS;
+            data = reg[d->dr];
+            address--;
+            reg[R6] = address;
+            cc = FAST_CC(address);
+            memory_write(memory, address, data);
+        } else {
+            if (address > STACK_LAST) {
+                reg[R5] = STACK_ERROR;
+                cc = FAST_CC(STACK_ERROR);
+                goto next;
+            }
+            reg[R5] = STACK_SUCCESS;
+            data = memory_get_data(memory, address);
+            address++;
+            reg[R6] = address;
+            reg[d->dr] = data;
+            cc = FAST_CC(data);
+        }
+        goto next;
+
+    FAST_HANDLER(OPCODE_TRAP, op_trap):
+        switch (d->trap_vector) {
+        case TRAP_VECTOR_X25:
+            /** Same as lc3_trap_x25 */
+            reg[R7] = pc;
+            cc = FAST_CC(pc);
+            lc3->is_halted = TRUE;
+            result = RUN_HALTED;
+            goto done;
+        case TRAP_VECTOR_X20:
+        case TRAP_VECTOR_X21:
+        case TRAP_VECTOR_X22:
+            /** Microstate 15. The simulator finishes the routine */
+            cpu_set_mar(lc3->cpu, zext(d->trap_vector));
+            result = RUN_TRAP;
+            goto done;
+        }
+        goto next;
+
+    FAST_HANDLER(OPCODE_RTI, op_rti):
+        /** Same as lc3_execute_rti, which works on the CPU */
+        cpu_set_pc(lc3->cpu, pc);
+        cpu_set_cc(lc3->cpu, cc);
+        lc3_execute_rti(lc3);
+        pc = cpu_get_pc(lc3->cpu);
+        cc = cpu_get_cc(lc3->cpu);
+        goto next;
+    }
+
+done:
+    cpu_set_pc(lc3->cpu, pc);
+    cpu_set_cc(lc3->cpu, cc);
+    if (d != NULL) {
+        cpu_set_ir(lc3->cpu, d->ir);
+        lc3->decoded = *d;
+        lc3->opcode = d->opcode;
+    }
+    if (profile != NULL) {
+        profile->instructions += *budget - remaining;
+    }
+    *budget = remaining;
+    return result;
+}
+
+/** JIT execution engine. The translation cache is created on first use. Translated blocks
+ * don't stop between instructions, so with breakpoints set the fast engine runs instead */
+run_result_t lc3_run_jit(lc3_p lc3, unsigned long *budget) {
+    if (lc3->breakpoints != NULL) {
+        return lc3_run_fast(lc3, budget);
+    }
+    if (lc3->jit == NULL) {
+        lc3->jit = jit_create(lc3);
+        if (lc3->jit == NULL) {
+            return lc3_run_fast(lc3, budget);
+        }
+    }
+    return jit_run(lc3->jit, budget);
+}
+
+/** Starts or stops filling in the profile's counters while the fast engine runs */
+void lc3_set_profile(lc3_p lc3, profile_p profile) { lc3->profile = profile; }
+
+/** Starts or stops checking the breakpoints before every instruction */
+void lc3_set_breakpoints(lc3_p lc3, breakpoints_p breakpoints) {
+    lc3->breakpoints = breakpoints;
+}
+
+/** Attaches or detaches the devices whose interrupts are taken */
+void lc3_set_devices(lc3_p lc3, devices_p devices) { lc3->devices = devices; }
+
+/** Takes the interrupt the devices are requesting if it outranks the running program */
+bool_t lc3_interrupt(lc3_p lc3) {
+    if (lc3->devices == NULL) {
+        return FALSE;
+    }
+    word_t request = devices_poll_interrupt(lc3->devices);
+    word_t priority = request & PSR_PRIORITY;
+    if (request == 0 || priority <= (lc3->psr & PSR_PRIORITY)) {
+        return FALSE;
+    }
+    enter_service_routine(lc3, request & MASK_TRAPVECT8, priority);
+    return TRUE;
+}
+
 /** Gets the starting address for the PC according to the first line in the loaded hex file */
 word_t lc3_get_starting_address(lc3_p lc3) { return lc3->starting_address; }
 
@@ -659,17 +1042,64 @@ opcode_t lc3_get_opcode(lc3_p lc3) { return lc3->opcode; }
  */
 word_t lc3_get_pc(lc3_p lc3) { return cpu_get_pc(lc3->cpu); }
 
-/** Sets memory data at the specified address. This is used for loading a file to memory and
- * editing memory from the Display */
+/** Sets memory data at the specified address. This is used for editing memory from the
+ * Display */
 void lc3_set_memory(lc3_p lc3, word_t address, word_t data) {
     memory_write(lc3->memory, address, data);
 }
 
+/** Sets a block of memory data starting at the specified address */
+void lc3_set_memory_block(lc3_p lc3, word_t address, const word_t *data, size_t count) {
+    memory_write_block(lc3->memory, address, data, count);
+}
+
+/** Works out the address the next instruction will write to, if it writes memory at all.
+ * Only ST, STI, STR and a stack push that doesn't overflow do */
+bool_t lc3_get_store_address(lc3_p lc3, word_t *address) {
+    word_t pc = cpu_get_pc(lc3->cpu);
+    const decoded_t *d = memory_get_decoded(lc3->memory, pc);
+    word_t *reg = cpu_get_registers(lc3->cpu);
+    switch (d->opcode) {
+    case OPCODE_ST:
+        *address = pc + 1 + d->pc_offset_9;
+        return TRUE;
+    case OPCODE_STI:
+        *address = memory_peek(lc3->memory, pc + 1 + d->pc_offset_9);
+        return TRUE;
+    case OPCODE_STR:
+        *address = reg[d->sr1] + d->pc_offset_6;
+        return TRUE;
+    case OPCODE_STACK:
+        *address = reg[R6] - 1;
+        return (d->imm_mode == STACK_PUSH && reg[R6] >= STACK_MAX);
+    default:
+        return FALSE;
+    }
+}
+
+/** Enters supervisor mode to service an interrupt or exception. Microstates 45 and 37 to 54 */
+void enter_service_routine(lc3_p lc3, trap_vector_t vector, word_t priority) {
+    word_t *reg = cpu_get_registers(lc3->cpu);
+    word_t psr = lc3->psr | cpu_get_cc(lc3->cpu);
+    if (psr & PSR_USER) {
+        lc3->saved_usp = reg[R6];
+        reg[R6] = lc3->saved_ssp;
+    }
+    reg[R6] -= 2;
+    memory_write(lc3->memory, reg[R6] + 1, psr);
+    memory_write(lc3->memory, reg[R6], cpu_get_pc(lc3->cpu));
+    lc3->psr = priority;
+    cpu_set_pc(lc3->cpu, memory_get_data(lc3->memory, INTERRUPT_TABLE + vector));
+}
+
 /** Sets LC3 values to default starting values */
 void initialize_lc3(lc3_p lc3) {
-    lc3->starting_address = MEMORY_ADDRESS_MIN;
+    lc3->starting_address = USER_SPACE_START;
     lc3->is_halted = FALSE;
     lc3->is_file_loaded = FALSE;
+    lc3->psr = PSR_USER;
+    lc3->saved_ssp = INTERRUPT_SUPERVISOR_STACK;
+    lc3->saved_usp = 0;
     initialize_intrastate(lc3);
 }
 
@@ -682,47 +1112,25 @@ void initialize_intrastate(lc3_p lc3) {
 }
 
 /** Fetches the opcode from the IR */
-opcode_t fetch_opcode(lc3_p lc3) {
-    /** No masking needed */
-    opcode_t opcode = cpu_get_ir(lc3->cpu) >> BITSHIFT_OPCODE;
-    return opcode;
-}
+opcode_t fetch_opcode(lc3_p lc3) { return lc3->decoded.opcode; }
 
 /** Fetches the destination register from the IR */
-reg_addr_t get_dr(lc3_p lc3) {
-    word_t masked_ir = cpu_get_ir(lc3->cpu) & MASK_DR;
-    return (reg_addr_t)(masked_ir >> BITSHIFT_DR);
-}
+reg_addr_t get_dr(lc3_p lc3) { return lc3->decoded.dr; }
 
 /** Fetches the source register 1 from the IR */
-reg_addr_t get_sr1(lc3_p lc3) {
-    word_t masked_ir = cpu_get_ir(lc3->cpu) & MASK_SR1;
-    return (reg_addr_t)(masked_ir >> BITSHIFT_SR1);
-}
+reg_addr_t get_sr1(lc3_p lc3) { return lc3->decoded.sr1; }
 
 /** Fetches the source register 2 from the IR */
-reg_addr_t get_sr2(lc3_p lc3) {
-    word_t masked_ir = cpu_get_ir(lc3->cpu) & MASK_SR2;
-    return masked_ir; /* No shift needed */
-}
+reg_addr_t get_sr2(lc3_p lc3) { return lc3->decoded.sr2; }
 
 /** Fetches bit 5 (immediate mode flag for AND and ADD) from the IR */
-bool_t get_imm_mode(lc3_p lc3) {
-    word_t masked_ir = cpu_get_ir(lc3->cpu) & MASK_BIT5;
-    return (bool_t)(masked_ir >> BITSHIFT_BIT5);
-}
+bool_t get_imm_mode(lc3_p lc3) { return lc3->decoded.imm_mode; }
 
 /** Fetches the immediate bits from the IR */
-bool_t get_jsr_imm_mode(lc3_p lc3) {
-    word_t masked_ir = cpu_get_ir(lc3->cpu) & MASK_BIT11;
-    return (bool_t)(masked_ir >> BITSHIFT_BIT11);
-}
+bool_t get_jsr_imm_mode(lc3_p lc3) { return lc3->decoded.jsr_imm_mode; }
 
 /** Fetches the NZP bits from the IR */
-cc_t get_nzp(lc3_p lc3) {
-    word_t masked_ir = cpu_get_ir(lc3->cpu) & MASK_NZP;
-    return (cc_t)(masked_ir >> BITSHIFT_NZP);
-}
+cc_t get_nzp(lc3_p lc3) { return lc3->decoded.nzp; }
 
 /** Fetches the high order bit of the NZP representing negative */
 bool_t get_nzp_n(cc_t nzp) {
@@ -743,43 +1151,19 @@ bool_t get_nzp_p(cc_t nzp) {
 }
 
 /** Fetches the 5 immediate bits (AND and ADD) from the IR */
-imm_5_t get_imm_5(lc3_p lc3) {
-    imm_5_t masked_ir = (imm_5_t)(cpu_get_ir(lc3->cpu) & MASK_IMMED5);
-    if (((masked_ir & BIT_IMMED5) >> BITSHIFT_NEGATIVE_IMMED5) == 1) {
-        masked_ir = masked_ir | MASK_NEGATIVE_IMMED5;
-    }
-    return masked_ir;
-}
+imm_5_t get_imm_5(lc3_p lc3) { return lc3->decoded.imm_5; }
 
 /** Fetches the 6 PC offset bits (LDR and STR) from the IR */
-pc_offset_6_t get_pc_offset_6(lc3_p lc3) {
-    pc_offset_6_t masked_ir = (pc_offset_6_t)(cpu_get_ir(lc3->cpu) & MASK_PCOFFSET6);
-    if (((masked_ir & BIT_PCOFFSET6) >> BITSHIFT_NEGATIVE_PCOFFSET6) == 1) {
-        masked_ir = masked_ir | MASK_NEGATIVE_PCOFFSET6;
-    }
-    return masked_ir;
-}
+pc_offset_6_t get_pc_offset_6(lc3_p lc3) { return lc3->decoded.pc_offset_6; }
 
 /** Fetches the 9 PC offset bits (BR, LD, LDI, LEA, ST, and STI) from the IR */
-pc_offset_9_t get_pc_offset_9(lc3_p lc3) {
-    pc_offset_9_t masked_ir = (pc_offset_9_t)(cpu_get_ir(lc3->cpu) & MASK_PCOFFSET9);
-    if (((masked_ir & BIT_PCOFFSET9) >> BITSHIFT_NEGATIVE_PCOFFSET9) == 1) {
-        masked_ir = masked_ir | MASK_NEGATIVE_PCOFFSET9;
-    }
-    return masked_ir;
-}
+pc_offset_9_t get_pc_offset_9(lc3_p lc3) { return lc3->decoded.pc_offset_9; }
 
 /** Fetches the 11 PC offset bits (JSR) from the IR */
-pc_offset_11_t get_pc_offset_11(lc3_p lc3) {
-    pc_offset_11_t masked_ir = (pc_offset_11_t)(cpu_get_ir(lc3->cpu) & MASK_PCOFFSET11);
-    if (((masked_ir & BIT_PCOFFSET11) >> BITSHIFT_NEGATIVE_PCOFFSET11) == 1) {
-        masked_ir = masked_ir | MASK_NEGATIVE_PCOFFSET11;
-    }
-    return masked_ir;
-}
+pc_offset_11_t get_pc_offset_11(lc3_p lc3) { return lc3->decoded.pc_offset_11; }
 
 /** Fetches the TRAP vector from the IR */
-trap_vector_t get_trap_vector(lc3_p lc3) { return cpu_get_ir(lc3->cpu) & MASK_TRAPVECT8; }
+trap_vector_t get_trap_vector(lc3_p lc3) { return lc3->decoded.trap_vector; }
 
 /** Zero extends the trap vector to be a full 16-bit word */
 word_t zext(trap_vector_t trap_vector) { return (word_t)trap_vector; }
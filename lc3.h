@@ -29,6 +29,7 @@
 
 #include "global.h"
 #include "alu.h"
+#include "arena.h"
 #include "cpu.h"
 #include "memory.h"
 
@@ -57,6 +58,26 @@
 #define OPCODE_STI 11   /* 1011 */
 #define OPCODE_STR 7    /* 0111 */
 #define OPCODE_STACK 13 /* 1101 */
+#define OPCODE_RTI 8    /* 1000 */
+
+/** Reasons lc3_run_fast hands control back to the simulator */
+#define RUN_HALTED 0 /* HALT was executed, or the LC3 was already halted */
+#define RUN_TRAP 1   /* A console TRAP needs the simulator; the vector is in the MAR */
+#define RUN_BUDGET 2 /* The instruction budget ran out */
+#define RUN_BREAK 3  /* A breakpoint or watchpoint stopped the run. See breakpoints_get_hit */
+
+/** Processor status register. The CPU keeps the CC, so the PSR held by the LC3 only has the
+ * privilege and priority bits; the CC is merged in whenever the PSR is pushed */
+#define PSR_USER 0x8000     /* 1000 0000 0000 0000 */
+#define PSR_PRIORITY 0x0700 /* 0000 0111 0000 0000 */
+#define PSR_CC 0x0007       /* 0000 0000 0000 0111 */
+#define BITSHIFT_PRIORITY 8
+
+/** Interrupts and exceptions go through the vector table. Programs start in user mode, and the
+ * supervisor stack starts just below user space, as the LC-3 OS sets it up */
+#define INTERRUPT_TABLE 0x0100
+#define INTERRUPT_PRIVILEGE_VECTOR 0x00 /* RTI in user mode */
+#define INTERRUPT_SUPERVISOR_STACK USER_SPACE_START
 
 /** Stack status codes. Used for the LC-3 stack push/pop opcode */
 #define STACK_MAX 0x31F6
@@ -102,11 +123,34 @@
 #define MASK_NEGATIVE_PCOFFSET9 0xFE00  // 1111 1110 0000 0000
 #define MASK_NEGATIVE_PCOFFSET6 0xFFC0  // 1111 1111 1100 0000
 
+typedef int run_result_t;
+
 typedef struct lc3_t {
     cpu_p cpu;
     alu_p alu;
     memory_p memory;
 
+    /** Translation cache for the JIT engine, created the first time it is used */
+    struct jit_t *jit;
+
+    /** Execution counters the fast engine fills in while profiling, otherwise NULL */
+    struct profile_t *profile;
+
+    /** Breakpoints the engines check before each instruction, or NULL when none are set */
+    struct breakpoints_t *breakpoints;
+
+    /** Memory-mapped devices that can interrupt the program, or NULL if none are attached */
+    struct devices_t *devices;
+
+    /** The privilege and priority bits of the PSR, and the stack pointer of the mode that
+     * isn't running. R6 is swapped with it on the way into and out of supervisor mode */
+    word_t psr;
+    word_t saved_ssp;
+    word_t saved_usp;
+
+    /** The arena this LC3 was allocated from, or NULL if it has an allocation of its own */
+    arena_p arena;
+
     word_t starting_address;
     bool_t is_halted;
     bool_t is_file_loaded;
@@ -114,22 +158,55 @@ typedef struct lc3_t {
     /** Intra-state variables */
     state_t state;
     opcode_t opcode;
+    decoded_t decoded;
     word_t eval_addr_calculation;
     bool_t branch_enabled;
     trap_vector_t trap_vector;
 } lc3_t, *lc3_p;
 
-/** Allocates and initializes a new LC3 module */
+/** Allocates and initializes a new LC3 module. The LC3, CPU, ALU and memory module share a
+ * single cache-aligned allocation of lc3_size() bytes */
 lc3_p lc3_create();
 
+/** Allocates and initializes a new LC3 module in a slot of the arena, which must have been
+ * created with a slot size of at least lc3_size(). Returns NULL if the arena is full.
+ * lc3_destroy gives the slot back to the arena */
+lc3_p lc3_create_in_arena(arena_p);
+
+/** Gets the number of bytes a single LC3 allocation takes, not counting memory pages or the JIT
+ * translation cache, which are only allocated once they're used */
+size_t lc3_size();
+
 /** Reinitializes the LC3 module without reallocation */
 void lc3_reset(lc3_p);
 
 /** Deallocates the LC3 module */
 void lc3_destroy(lc3_p);
 
-/** Gets a snapshot of the LC3 data for debugging or display purposes */
-const lc3_snapshot_t lc3_get_snapshot(lc3_p);
+/** Brings a snapshot of the LC3 data up to date for debugging or display purposes. Snapshots
+ * are meant to be kept and updated rather than taken afresh: the registers are always copied,
+ * but only the memory pages written since the last update are. A new snapshot must start
+ * zeroed */
+void lc3_update_snapshot(lc3_p, lc3_snapshot_t *);
+
+/** Starts filling in the profile's counters while the fast engine runs, or stops if NULL. The
+ * profile belongs to the caller */
+void lc3_set_profile(lc3_p, struct profile_t *);
+
+/** Starts checking the breakpoints before every instruction, or stops if NULL. Should only be
+ * given breakpoints that are armed, since checking costs time even when nothing is set. The
+ * breakpoints belong to the caller */
+void lc3_set_breakpoints(lc3_p, struct breakpoints_t *);
+
+/** Attaches devices whose interrupts are taken between instructions, or detaches them if
+ * NULL. The devices belong to the caller */
+void lc3_set_devices(lc3_p, struct devices_t *);
+
+/** Takes the interrupt the devices are requesting, if devices are attached and one of them
+ * is requesting an interrupt of higher priority than the running program's. Returns whether
+ * it was taken. devices_service calls this before the FSM's every fetch; the other engines
+ * can't stop between instructions to look, so it calls this between the slices they run in */
+bool_t lc3_interrupt(lc3_p);
 
 /** Gets/sets the starting address for the PC according to the first line in the loaded hex
  * file */
@@ -155,10 +232,33 @@ opcode_t lc3_get_opcode(lc3_p);
  * requesting a breakpoint at this location */
 word_t lc3_get_pc(lc3_p);
 
-/** Sets memory data at the specified address. This is used for loading a file to memory and
- * editing memory from the Display */
+/** Sets memory data at the specified address. This is used for editing memory from the
+ * Display */
 void lc3_set_memory(lc3_p, word_t address, word_t data);
 
+/** Sets count words of memory starting at the specified address in one block. The words must
+ * fit below MEMORY_SIZE. Used for loading a program */
+void lc3_set_memory_block(lc3_p, word_t address, const word_t *data, size_t count);
+
+/** Works out the address the next instruction will write to. Returns FALSE if it doesn't write
+ * memory at all. Must be called before the instruction runs, since STI's pointer and R6 may
+ * not hold the same values afterwards */
+bool_t lc3_get_store_address(lc3_p, word_t *address);
+
+/** Fast execution engine. Runs whole instructions from the decoded side table, dispatching
+ * once per instruction, until HALT, a console TRAP (x20, x21, x22), a breakpoint or until the
+ * budget runs out. The budget is decremented by the number of instructions executed.
+ * Architectural state (registers, PC, CC, IR and memory) comes out exactly as the microstate
+ * functions below would leave it; the ALU latches and MDR are not maintained. On RUN_TRAP the
+ * MAR holds the vector so the simulator can finish the routine the same way it does after
+ * lc3_execute_trap */
+run_result_t lc3_run_fast(lc3_p, unsigned long *budget);
+
+/** JIT execution engine. Same contract as lc3_run_fast, but straight-line code is translated
+ * to native basic blocks first. Falls back to lc3_run_fast where the host can't run
+ * translated code */
+run_result_t lc3_run_jit(lc3_p, unsigned long *budget);
+
 /** Fetch instruction cycle */
 void lc3_fetch(lc3_p);
 
@@ -231,6 +331,9 @@ void lc3_store_str(lc3_p);
 void lc3_fetch_op_stack(lc3_p);
 void lc3_store_stack(lc3_p);
 
+/** RTI */
+void lc3_execute_rti(lc3_p);
+
 /** TRAP */
 void lc3_fetch_op_trap(lc3_p);
 word_t lc3_execute_trap(lc3_p);
@@ -0,0 +1,353 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Loader Module File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#include "loader.h"
+#include "savestate.h"
+#include <ctype.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/** The most hex digits a word in a hex file can have */
+#define LOADER_WORD_DIGITS 4
+
+/** Parses a hex file into the origin and the words that go there. The words array must have
+ * room for MEMORY_SIZE words */
+loader_result_t loader_parse_hex(const unsigned char *, size_t, word_t *origin, word_t *words,
+                                 size_t *count);
+
+/** Parses an object file into the origin and the words that go there */
+loader_result_t loader_parse_object(const unsigned char *, size_t, word_t *origin,
+                                    word_t *words, size_t *count);
+
+/** Returns the value of a hex digit, or -1 if the character isn't one */
+int loader_hex_digit(unsigned char);
+
+/** Writes one word of a saved file */
+void loader_write_word(FILE *, word_t, bool_t object);
+
+/** Writes the words into the LC3 and starts it at their origin */
+void loader_place(lc3_p, word_t origin, const word_t *words, size_t count);
+
+/** Maps a whole regular file into memory for reading it once from start to end */
+loader_result_t loader_map(const char *file_name, const unsigned char **data, size_t *size);
+
+/** Loads the file without reporting assembly errors */
+loader_result_t loader_load(lc3_p lc3, const char *file_name) {
+    return loader_load_reporting(lc3, file_name, NULL);
+}
+
+/** Maps the file into memory and parses or assembles the whole of it before writing the words
+ * into the LC3 as a single block */
+loader_result_t loader_load_reporting(lc3_p lc3, const char *file_name, FILE *errors) {
+    if (savestate_is_file(file_name) == TRUE) {
+        return savestate_restore(lc3, file_name);
+    }
+    if (loader_has_extension(file_name, ASSEMBLER_EXTENSION) == TRUE) {
+        assembler_p assembler = assembler_create();
+        loader_result_t result =
+            loader_load_assembly(lc3, assembler, file_name, FALSE, errors);
+        assembler_destroy(assembler);
+        return result;
+    }
+    const unsigned char *data;
+    size_t size;
+    loader_result_t mapped = loader_map(file_name, &data, &size);
+    if (mapped != LOADER_OK) {
+        return mapped;
+    }
+
+    word_t origin = 0;
+    size_t count = 0;
+    word_t *words = malloc(sizeof(word_t) * MEMORY_SIZE);
+    loader_result_t result = (loader_is_object_file(file_name) == TRUE)
+                                 ? loader_parse_object(data, size, &origin, words, &count)
+                                 : loader_parse_hex(data, size, &origin, words, &count);
+    munmap((void *)data, size);
+
+    if (result == LOADER_OK) {
+        loader_place(lc3, origin, words, count);
+    }
+    free(words);
+    return result;
+}
+
+/** Assembles the file and either loads the whole program or patches in the words that
+ * changed. Words are patched one at a time so only their own decoded and translated entries
+ * are dropped */
+loader_result_t loader_load_assembly(lc3_p lc3, assembler_p assembler, const char *file_name,
+                                     bool_t patch, FILE *errors) {
+    const unsigned char *data;
+    size_t size;
+    loader_result_t result = loader_map(file_name, &data, &size);
+    if (result != LOADER_OK) {
+        return result;
+    }
+    bool_t assembled = assembler_assemble(assembler, (const char *)data, size);
+    munmap((void *)data, size);
+    if (assembled == FALSE) {
+        if (errors != NULL) {
+            assembler_write_errors(assembler, file_name, errors);
+        }
+        return LOADER_ASSEMBLY_ERROR;
+    }
+    const word_t *words = assembler_get_words(assembler);
+    word_t origin = assembler_get_origin(assembler);
+    if (patch == FALSE) {
+        loader_place(lc3, origin, words, assembler_get_count(assembler));
+        return LOADER_OK;
+    }
+    size_t count;
+    const word_t *changes = assembler_get_changes(assembler, &count);
+    size_t i;
+    for (i = 0; i < count; i++) {
+        lc3_set_memory(lc3, changes[i], words[(word_t)(changes[i] - origin)]);
+    }
+    return LOADER_OK;
+}
+
+/** Assembles the source file and saves the program and its listing */
+loader_result_t loader_assemble(const char *source_name, const char *output_name,
+                                FILE *errors) {
+    const unsigned char *data;
+    size_t size;
+    loader_result_t result = loader_map(source_name, &data, &size);
+    if (result != LOADER_OK) {
+        return result;
+    }
+    assembler_p assembler = assembler_create();
+    bool_t assembled = assembler_assemble(assembler, (const char *)data, size);
+    munmap((void *)data, size);
+    if (assembled == FALSE) {
+        assembler_write_errors(assembler, source_name, errors);
+        assembler_destroy(assembler);
+        return LOADER_ASSEMBLY_ERROR;
+    }
+
+    char listing_name[PATH_MAX];
+    loader_replace_extension(output_name, ASSEMBLER_LISTING_EXTENSION, listing_name,
+                             sizeof(listing_name));
+
+    result = LOADER_NOT_FOUND;
+    if (loader_save(output_name, assembler_get_origin(assembler),
+                    assembler_get_words(assembler), assembler_get_count(assembler)) == TRUE) {
+        FILE *listing = fopen(listing_name, "w");
+        if (listing != NULL) {
+            assembler_write_listing(assembler, listing);
+            result = (fclose(listing) == 0) ? LOADER_OK : LOADER_NOT_FOUND;
+        }
+    }
+    assembler_destroy(assembler);
+    return result;
+}
+
+/** Saves the words, origin first */
+bool_t loader_save(const char *file_name, word_t origin, const word_t *words, size_t count) {
+    FILE *file = fopen(file_name, "w+");
+    if (file == NULL) {
+        return FALSE;
+    }
+    bool_t object = loader_is_object_file(file_name);
+    loader_write_word(file, origin, object);
+    size_t i;
+    for (i = 0; i < count; i++) {
+        loader_write_word(file, words[i], object);
+    }
+    return (fclose(file) == 0) ? TRUE : FALSE;
+}
+
+/** Returns whether the file name ends in the object file extension */
+bool_t loader_is_object_file(const char *file_name) {
+    return loader_has_extension(file_name, LOADER_OBJECT_EXTENSION);
+}
+
+/** Returns whether the file name ends in the extension, in any case */
+bool_t loader_has_extension(const char *file_name, const char *extension) {
+    size_t length = strlen(file_name);
+    size_t extension_length = strlen(extension);
+    return length > extension_length &&
+           strcasecmp(file_name + length - extension_length, extension) == 0;
+}
+
+/** Copies the file name with its extension swapped for another. A dot in a directory name
+ * isn't an extension */
+void loader_replace_extension(const char *file_name, const char *extension, char *result,
+                              size_t size) {
+    int length = strlen(file_name);
+    const char *dot = strrchr(file_name, '.');
+    if (dot != NULL && strchr(dot, '/') == NULL) {
+        length = dot - file_name;
+    }
+    snprintf(result, size, "%.*s%s", length, file_name, extension);
+}
+
+/** Gets a short description of a load result */
+const char *loader_describe(loader_result_t result) {
+    switch (result) {
+    case LOADER_OK:
+        return "Loaded";
+    case LOADER_NOT_FOUND:
+        return "File not found";
+    case LOADER_BAD_FORMAT:
+        return "Not a hex, object or state file";
+    case LOADER_TOO_LARGE:
+        return "Program runs past xFFFF";
+    case LOADER_BAD_VERSION:
+        return "State saved by another version";
+    case LOADER_ASSEMBLY_ERROR:
+        return "Assembly failed";
+    case LOADER_BUSY:
+        return "Program is waiting for input";
+    default:
+        return "Unknown load error";
+    }
+}
+
+/** Parses a hex file. Words are separated by any whitespace and may start with x or 0x, so
+ * the file is walked once with no line buffering */
+loader_result_t loader_parse_hex(const unsigned char *text, size_t size, word_t *origin,
+                                 word_t *words, size_t *count) {
+    const unsigned char *end = text + size;
+    bool_t has_origin = FALSE;
+    size_t capacity = 0;
+    *count = 0;
+    while (TRUE) {
+        while (text < end && isspace(*text)) {
+            text++;
+        }
+        if (text == end) {
+            break;
+        }
+        if (*text == 'x' || *text == 'X') {
+            text++;
+        } else if (*text == '0' && text + 1 < end && (text[1] == 'x' || text[1] == 'X')) {
+            text += 2;
+        }
+        unsigned int value = 0;
+        int digits = 0;
+        int digit;
+        while (text < end && (digit = loader_hex_digit(*text)) >= 0) {
+            value = (value << 4) | digit;
+            digits++;
+            text++;
+        }
+        if (digits == 0 || digits > LOADER_WORD_DIGITS || (text < end && !isspace(*text))) {
+            return LOADER_BAD_FORMAT;
+        }
+        if (has_origin == FALSE) {
+            *origin = value;
+            capacity = MEMORY_SIZE - value;
+            has_origin = TRUE;
+        } else if (*count == capacity) {
+            return LOADER_TOO_LARGE;
+        } else {
+            words[(*count)++] = value;
+        }
+    }
+    return (has_origin == TRUE) ? LOADER_OK : LOADER_BAD_FORMAT;
+}
+
+/** Parses an object file, swapping each big-endian word into host order */
+loader_result_t loader_parse_object(const unsigned char *data, size_t size, word_t *origin,
+                                    word_t *words, size_t *count) {
+    if (size < 2 || size % 2 != 0) {
+        return LOADER_BAD_FORMAT;
+    }
+    *origin = (data[0] << 8) | data[1];
+    *count = size / 2 - 1;
+    if (*count > MEMORY_SIZE - *origin) {
+        return LOADER_TOO_LARGE;
+    }
+    size_t i;
+    for (i = 0; i < *count; i++) {
+        words[i] = (data[2 * i + 2] << 8) | data[2 * i + 3];
+    }
+    return LOADER_OK;
+}
+
+/** Returns the value of a hex digit */
+int loader_hex_digit(unsigned char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+/** Writes a word as a line of hex, or as two big-endian bytes for an object file */
+void loader_write_word(FILE *file, word_t word, bool_t object) {
+    if (object == TRUE) {
+        fputc(word >> 8, file);
+        fputc(word & 0xFF, file);
+    } else {
+        fprintf(file, "%04X\n", word);
+    }
+}
+
+/** Writes the words into the LC3 as one block and marks a file as loaded */
+void loader_place(lc3_p lc3, word_t origin, const word_t *words, size_t count) {
+    lc3_set_memory_block(lc3, origin, words, count);
+    lc3_set_starting_address(lc3, origin);
+    if (lc3_has_file_loaded(lc3) == FALSE) {
+        lc3_toggle_file_loaded(lc3);
+    }
+}
+
+/** Maps the file read-only and tells the kernel it will be read in order. Anything but a
+ * regular file is treated as not found, and an empty file as not being in any format */
+loader_result_t loader_map(const char *file_name, const unsigned char **data, size_t *size) {
+    int fd = open(file_name, O_RDONLY);
+    if (fd < 0) {
+        return LOADER_NOT_FOUND;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || S_ISREG(info.st_mode) == 0) {
+        close(fd);
+        return LOADER_NOT_FOUND;
+    }
+    *size = info.st_size;
+    if (*size == 0) {
+        close(fd);
+        return LOADER_BAD_FORMAT;
+    }
+    *data = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (*data == MAP_FAILED) {
+        return LOADER_NOT_FOUND;
+    }
+    madvise((void *)*data, *size, MADV_SEQUENTIAL);
+    return LOADER_OK;
+}
@@ -0,0 +1,93 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Loader Module Header File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#ifndef LOADER_H
+#define LOADER_H
+
+#include "assembler.h"
+#include "global.h"
+#include "lc3.h"
+#include <stdio.h>
+
+/** Files with this extension are taken to be binary LC-3 object files: a big-endian origin
+ * followed by the big-endian words to load there. Files ending in .asm are assembled (see
+ * assembler_assemble). Anything else is read as a hex file: the origin, then one word per
+ * line, each as up to four hex digits */
+#define LOADER_OBJECT_EXTENSION ".obj"
+
+/** Why a load finished */
+#define LOADER_OK 0
+#define LOADER_NOT_FOUND 1   /* The file couldn't be opened or read */
+#define LOADER_BAD_FORMAT 2  /* No origin, a word that isn't hex, or half a word at the end */
+#define LOADER_TOO_LARGE 3   /* The words run past the end of memory */
+#define LOADER_BAD_VERSION 4 /* A saved state from another version or byte order */
+#define LOADER_ASSEMBLY_ERROR 5 /* The assembly source has errors in it */
+#define LOADER_BUSY 6           /* The core is waiting for GETC input and can't load now */
+
+typedef int loader_result_t;
+
+/** Loads a hex or object file into the LC3 and sets the starting address to its origin, or
+ * restores a saved state if the file name says it is one (see savestate_restore). The whole
+ * file is checked before anything is written, so the LC3 is left alone if it fails */
+loader_result_t loader_load(lc3_p, const char *file_name);
+
+/** Loads the file the same as loader_load, writing any assembly errors to the errors file
+ * first if it isn't NULL */
+loader_result_t loader_load_reporting(lc3_p, const char *file_name, FILE *errors);
+
+/** Loads an assembly file with an assembler that is kept from one load to the next. When
+ * patch is TRUE only the words that changed since the assembler's last program are written,
+ * one at a time through lc3_set_memory, so a running program can be edited without losing the
+ * registers, the PC or anything it has stored. Otherwise it is the same as loader_load.
+ * Assembly errors are written to the errors file if it isn't NULL */
+loader_result_t loader_load_assembly(lc3_p, assembler_p, const char *file_name, bool_t patch,
+                                     FILE *errors);
+
+/** Assembles the source file and saves the program to the output file the way loader_save
+ * does, with a listing beside it named after the output but ending in .lst. Errors are written
+ * to the errors file. Returns LOADER_NOT_FOUND if the output can't be written */
+loader_result_t loader_assemble(const char *source_name, const char *output_name,
+                                FILE *errors);
+
+/** Saves the words to a file that loader_load can read back, as an object file if the name
+ * says it is one and as a hex file otherwise. Returns FALSE if it can't be written */
+bool_t loader_save(const char *file_name, word_t origin, const word_t *words, size_t count);
+
+/** Returns whether the file name has the object file extension */
+bool_t loader_is_object_file(const char *file_name);
+
+/** Returns whether the file name ends in the extension, in any case */
+bool_t loader_has_extension(const char *file_name, const char *extension);
+
+/** Copies the file name with its extension swapped for another, or with the extension added
+ * if it has none. The result is cut short to fit the size */
+void loader_replace_extension(const char *file_name, const char *extension, char *result,
+                              size_t size);
+
+/** Gets a short description of a load result for error messages */
+const char *loader_describe(loader_result_t);
+
+#endif
@@ -0,0 +1,363 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Lockstep Module File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#include "lockstep.h"
+#include "cpu.h"
+#include "decoder.h"
+#include "memory.h"
+#include <string.h>
+
+/** One 16 bit word per lane. Element i of every vector belongs to lane i. Comparisons give a
+ * lane_mask_t with every bit set in the lanes where they hold */
+typedef word_t lane_word_t __attribute__((vector_size(LOCKSTEP_LANES * sizeof(word_t))));
+typedef short lane_mask_t __attribute__((vector_size(LOCKSTEP_LANES * sizeof(word_t))));
+
+/** Keeps the old value in lanes outside the mask and takes the new one in lanes inside it */
+#define LOCKSTEP_BLEND(old, new, mask) (((old) & ~(mask)) | ((new) & (mask)))
+
+/** Architectural state of every lane in struct-of-arrays layout */
+typedef struct lockstep_t {
+    lane_word_t reg[REGISTER_SIZE];
+    lane_word_t pc;
+    lane_word_t cc;
+    lane_word_t ir;
+
+    /** Every bit is set in the lanes that haven't halted or run out of budget */
+    lane_word_t active;
+
+    /** Instructions each lane ran since the counts were last brought up to date, and how many
+     * more steps can go by before a lane could reach its budget or overflow its count */
+    lane_word_t steps;
+    unsigned long steps_left;
+    unsigned long *instructions;
+    unsigned long budget;
+
+    /** Pages any lane has written. Everywhere else the lanes still have the same code */
+    bool_t written_pages[MEMORY_PAGE_COUNT];
+
+    lc3_p lanes[LOCKSTEP_LANES];
+    console_p consoles[LOCKSTEP_LANES];
+    int lane_count;
+} lockstep_t;
+
+/** Executes the instruction for every lane in the mask, all of which are at the same PC */
+void lockstep_execute(lockstep_t *, const decoded_t *, lane_word_t mask);
+
+/** Writes a register in the lanes in the mask, setting their condition codes like every
+ * register write does */
+void lockstep_write_register(lockstep_t *, reg_addr_t, lane_word_t data, lane_word_t mask);
+
+/** Computes the condition codes of each lane's data */
+lane_word_t lockstep_cc(lane_word_t data);
+
+/** Executes a PUSH or POP for one lane, directly on its slice of the register file */
+void lockstep_stack(lockstep_t *, const decoded_t *, int lane);
+
+/** Executes one instruction on a lane's own LC3 with the fast engine. Used for TRAPs, which
+ * need the lane's console */
+void lockstep_execute_lane(lockstep_t *, int lane);
+
+/** Adds the steps each lane took to its instruction count and retires the lanes that have
+ * reached their budget */
+void lockstep_count_steps(lockstep_t *);
+
+/** Copies a lane's registers out of its LC3 and back */
+void lockstep_load_lane(lockstep_t *, int lane);
+void lockstep_store_lane(lockstep_t *, int lane);
+
+/** Runs the lanes until each has halted or run its budget */
+void lockstep_run(lc3_p lanes[], console_p consoles[], int lane_count, unsigned long budget,
+                  unsigned long instructions[]) {
+    lockstep_t state;
+    memset(&state, 0, sizeof(lockstep_t));
+    state.lane_count = lane_count;
+    state.instructions = instructions;
+    state.budget = budget;
+    int lane;
+    for (lane = 0; lane < lane_count; lane++) {
+        state.lanes[lane] = lanes[lane];
+        state.consoles[lane] = consoles[lane];
+        state.active[lane] = (lc3_is_halted(lanes[lane]) == FALSE && budget > 0) ? 0xFFFF : 0;
+        instructions[lane] = 0;
+        lockstep_load_lane(&state, lane);
+    }
+    lockstep_count_steps(&state);
+
+    for (;;) {
+        /** The lanes at the lowest PC go next. Lanes that branched ahead wait for the others
+         * to reach them, which is where diverged lanes usually meet up again */
+        int leader = -1;
+        int active_count = 0;
+        for (lane = 0; lane < lane_count; lane++) {
+            if (state.active[lane] && (leader < 0 || state.pc[lane] < state.pc[leader])) {
+                leader = lane;
+            }
+            active_count += (state.active[lane] != 0);
+        }
+        if (active_count == 1) {
+            /** Nothing left to step together with, so the last lane finishes on its own */
+            lockstep_count_steps(&state);
+            lockstep_store_lane(&state, leader);
+            while (lc3_is_halted(lanes[leader]) == FALSE && instructions[leader] < budget) {
+                instructions[leader] += execute(lanes[leader], consoles[leader], ENGINE_FAST,
+                                                budget - instructions[leader]);
+            }
+            lockstep_load_lane(&state, leader);
+            break;
+        }
+        if (leader < 0) {
+            break;
+        }
+        word_t pc = state.pc[leader];
+        const decoded_t *d = memory_get_decoded(lanes[leader]->memory, pc);
+
+        /** A lane whose copy of the code was written differently runs on its own turn */
+        lane_word_t mask = (lane_word_t)(state.pc == pc) & state.active;
+        if (state.written_pages[pc / MEMORY_PAGE_SIZE] == TRUE) {
+            for (lane = 0; lane < lane_count; lane++) {
+                if (mask[lane] && memory_get_decoded(lanes[lane]->memory, pc)->ir != d->ir) {
+                    mask[lane] = 0;
+                }
+            }
+        }
+
+        lockstep_execute(&state, d, mask);
+        state.steps += mask & (word_t)1;
+        if (--state.steps_left == 0) {
+            lockstep_count_steps(&state);
+        }
+    }
+
+    lockstep_count_steps(&state);
+    for (lane = 0; lane < lane_count; lane++) {
+        lockstep_store_lane(&state, lane);
+    }
+}
+
+/** Executes the instruction for every lane in the mask. Mirrors lc3_run_fast */
+void lockstep_execute(lockstep_t *state, const decoded_t *d, lane_word_t mask) {
+    lane_word_t next = state->pc + (word_t)1;
+    lane_word_t address;
+    lane_word_t data;
+    int lane;
+
+    state->ir = LOCKSTEP_BLEND(state->ir, (lane_word_t){} + d->ir, mask);
+    switch (d->opcode) {
+    case OPCODE_ADD:
+        data = state->reg[d->sr1] +
+               (d->imm_mode ? (lane_word_t){} + (word_t)d->imm_5 : state->reg[d->sr2]);
+        lockstep_write_register(state, d->dr, data, mask);
+        break;
+
+    case OPCODE_AND:
+        data = state->reg[d->sr1] &
+               (d->imm_mode ? (lane_word_t){} + (word_t)d->imm_5 : state->reg[d->sr2]);
+        lockstep_write_register(state, d->dr, data, mask);
+        break;
+
+    case OPCODE_NOT:
+        lockstep_write_register(state, d->dr, ~state->reg[d->sr1], mask);
+        break;
+
+    case OPCODE_BR:
+        /** Lanes that don't take the branch add nothing to the next PC */
+        data = (lane_word_t)((state->cc & d->nzp) != 0);
+        next += data & (word_t)d->pc_offset_9;
+        break;
+
+    case OPCODE_JMP:
+        /** Like lc3_store_jmp, RET and JMP also link through R7 */
+        address = state->reg[d->sr1];
+        lockstep_write_register(state, R7, next, mask);
+        next = address;
+        break;
+
+    case OPCODE_JSR:
+        address = d->jsr_imm_mode ? next + (word_t)d->pc_offset_11 : state->reg[d->sr1];
+        lockstep_write_register(state, R7, next, mask);
+        next = address;
+        break;
+
+    case OPCODE_LEA:
+        lockstep_write_register(state, d->dr, next + (word_t)d->pc_offset_9, mask);
+        break;
+
+    case OPCODE_LD:
+    case OPCODE_LDI:
+    case OPCODE_LDR:
+        address = (d->opcode == OPCODE_LDR) ? state->reg[d->sr1] + (word_t)d->pc_offset_6
+                                            : next + (word_t)d->pc_offset_9;
+        data = address;
+        for (lane = 0; lane < state->lane_count; lane++) {
+            if (mask[lane]) {
+                memory_p memory = state->lanes[lane]->memory;
+                if (d->opcode == OPCODE_LDI) {
+                    address[lane] = memory_get_data(memory, address[lane]);
+                }
+                data[lane] = memory_get_data(memory, address[lane]);
+            }
+        }
+        lockstep_write_register(state, d->dr, data, mask);
+        break;
+
+    case OPCODE_ST:
+    case OPCODE_STI:
+    case OPCODE_STR:
+        address = (d->opcode == OPCODE_STR) ? state->reg[d->sr1] + (word_t)d->pc_offset_6
+                                            : next + (word_t)d->pc_offset_9;
+        data = state->reg[d->dr];
+        for (lane = 0; lane < state->lane_count; lane++) {
+            if (mask[lane]) {
+                memory_p memory = state->lanes[lane]->memory;
+                if (d->opcode == OPCODE_STI) {
+                    address[lane] = memory_get_data(memory, address[lane]);
+                }
+                memory_write(memory, address[lane], data[lane]);
+                state->written_pages[address[lane] / MEMORY_PAGE_SIZE] = TRUE;
+            }
+        }
+        break;
+
+    case OPCODE_STACK:
+        for (lane = 0; lane < state->lane_count; lane++) {
+            if (mask[lane]) {
+                lockstep_stack(state, d, lane);
+            }
+        }
+        break;
+
+    case OPCODE_TRAP:
+    case OPCODE_RTI:
+        /** The fast engine fetches the TRAP or RTI again, so these lanes keep their PC here */
+        for (lane = 0; lane < state->lane_count; lane++) {
+            if (mask[lane]) {
+                lockstep_execute_lane(state, lane);
+            }
+        }
+        return;
+    }
+    state->pc = LOCKSTEP_BLEND(state->pc, next, mask);
+}
+
+/** Writes a register and sets the condition codes in the lanes in the mask */
+void lockstep_write_register(lockstep_t *state, reg_addr_t reg, lane_word_t data,
+                             lane_word_t mask) {
+    state->reg[reg] = LOCKSTEP_BLEND(state->reg[reg], data, mask);
+    state->cc = LOCKSTEP_BLEND(state->cc, lockstep_cc(data), mask);
+}
+
+/** Computes the condition codes of each lane's data, like FAST_CC does for one */
+lane_word_t lockstep_cc(lane_word_t data) {
+    lane_word_t negative = (lane_word_t)((lane_mask_t)data < 0);
+    lane_word_t zero = (lane_word_t)(data == 0);
+    return (negative & (word_t)MASK_CC_N) | (zero & (word_t)MASK_CC_Z) |
+           (~(negative | zero) & (word_t)MASK_CC_P);
+}
+
+/** Executes a PUSH or POP for one lane. Same as the stack handler in lc3_run_fast */
+void lockstep_stack(lockstep_t *state, const decoded_t *d, int lane) {
+    memory_p memory = state->lanes[lane]->memory;
+    word_t address = state->reg[R6][lane];
+    word_t data;
+    if ((d->imm_mode == STACK_PUSH) ? address < STACK_MAX : address > STACK_LAST) {
+        state->reg[R5][lane] = STACK_ERROR;
+        state->cc[lane] = MASK_CC_Z;
+        return;
+    }
+    state->reg[R5][lane] = STACK_SUCCESS;
+    if (d->imm_mode == STACK_PUSH) {
+        data = state->reg[d->dr][lane];
+        address--;
+        state->reg[R6][lane] = address;
+        memory_write(memory, address, data);
+        state->written_pages[address / MEMORY_PAGE_SIZE] = TRUE;
+        /** A push sets the condition codes from the new stack pointer */
+        data = address;
+    } else {
+        data = memory_get_data(memory, address);
+        address++;
+        state->reg[R6][lane] = address;
+        state->reg[d->dr][lane] = data;
+    }
+    state->cc[lane] = (data & 0x8000) ? MASK_CC_N : (data == 0 ? MASK_CC_Z : MASK_CC_P);
+}
+
+/** Executes one instruction on a lane's own LC3 with the fast engine */
+void lockstep_execute_lane(lockstep_t *state, int lane) {
+    lockstep_store_lane(state, lane);
+    execute(state->lanes[lane], state->consoles[lane], ENGINE_FAST, 1);
+    lockstep_load_lane(state, lane);
+    if (lc3_is_halted(state->lanes[lane]) == TRUE) {
+        state->active[lane] = 0;
+    }
+}
+
+/** Adds the steps each lane took to its instruction count and retires the lanes that have
+ * reached their budget. Until the next count, no lane can take more steps than the one
+ * closest to its budget has left, nor more than a lane's step counter holds */
+void lockstep_count_steps(lockstep_t *state) {
+    state->steps_left = 0xFFFF;
+    int lane;
+    for (lane = 0; lane < state->lane_count; lane++) {
+        state->instructions[lane] += state->steps[lane];
+        unsigned long left = state->budget - state->instructions[lane];
+        if (left == 0) {
+            state->active[lane] = 0;
+        } else if (state->active[lane] && left < state->steps_left) {
+            state->steps_left = left;
+        }
+    }
+    state->steps = (lane_word_t){};
+}
+
+/** Copies a lane's registers out of its LC3 */
+void lockstep_load_lane(lockstep_t *state, int lane) {
+    cpu_p cpu = state->lanes[lane]->cpu;
+    word_t *registers = cpu_get_registers(cpu);
+    int i;
+    for (i = 0; i < REGISTER_SIZE; i++) {
+        state->reg[i][lane] = registers[i];
+    }
+    state->pc[lane] = cpu_get_pc(cpu);
+    state->cc[lane] = cpu_get_cc(cpu);
+    state->ir[lane] = cpu_get_ir(cpu);
+}
+
+/** Copies a lane's registers back into its LC3, along with the decoded IR the fast engine
+ * would have left behind */
+void lockstep_store_lane(lockstep_t *state, int lane) {
+    lc3_p lc3 = state->lanes[lane];
+    word_t *registers = cpu_get_registers(lc3->cpu);
+    int i;
+    for (i = 0; i < REGISTER_SIZE; i++) {
+        registers[i] = state->reg[i][lane];
+    }
+    cpu_set_pc(lc3->cpu, state->pc[lane]);
+    cpu_set_cc(lc3->cpu, state->cc[lane]);
+    cpu_set_ir(lc3->cpu, state->ir[lane]);
+    decoder_decode(state->ir[lane], &lc3->decoded);
+    lc3->opcode = lc3->decoded.opcode;
+}
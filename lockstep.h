@@ -0,0 +1,49 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Lockstep Module Header File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+
+#include "global.h"
+#include "lc3.h"
+#include "slc3.h"
+
+/** How many LC3s step together. Eight 16 bit lanes fill a 128 bit vector, which every x86-64
+ * (SSE2) and ARMv8 (NEON) host has without extra compiler flags */
+#define LOCKSTEP_LANES 8
+
+/** Runs up to LOCKSTEP_LANES LC3s side by side, each with its own console, until every one has
+ * halted or run budget instructions, and records how many instructions each ran. The lanes
+ * must have the same program loaded, typically to run it against different input: the
+ * register files are kept in struct-of-arrays layout and every lane at the same PC executes
+ * that instruction together with vector operations, while lanes that have diverged wait,
+ * masked off, until the lowest PC catches up with them. Memory accesses and console TRAPs are
+ * done lane by lane, and code a lane writes over is only run with lanes that wrote the same.
+ * Each LC3 comes out exactly as the fast engine would have left it */
+void lockstep_run(lc3_p lanes[], console_p consoles[], int lane_count, unsigned long budget,
+                  unsigned long instructions[]);
+
+#endif
@@ -29,60 +29,328 @@
 #include <stdlib.h>
 #include <string.h>
 
-/** The time (in milliseconds) the memory will take to read and write */
-#define MEM_WRITE_DELAY 50
-#define MEM_READ_DELAY 50
+/** Splits a 16-bit address into its page number and the offset within that page */
+#define PAGE_OF(address) ((address) / MEMORY_PAGE_SIZE)
+#define OFFSET_OF(address) ((address) % MEMORY_PAGE_SIZE)
 
+/** One page of memory. Each word has a decoded instruction side table entry next to it, only
+ * trusted while its valid flag is set; memory_write clears the flag for the word it touches */
+typedef struct memory_page_t {
+    word_t data[MEMORY_PAGE_SIZE];
+    decoded_t decoded[MEMORY_PAGE_SIZE];
+    bool_t decoded_valid[MEMORY_PAGE_SIZE];
+    /** Words the JIT has compiled. Writing one of these calls the invalidate handler */
+    bool_t translated[MEMORY_PAGE_SIZE];
+    /** The memory generation of the last write to this page */
+    unsigned long generation;
+} memory_page_t;
+
+/** A range of addresses mapped to a device */
+typedef struct memory_device_t {
+    word_t first;
+    word_t last;
+    memory_device_read_t read;
+    memory_device_write_t write;
+    void *context;
+} memory_device_t;
+
+/** The memory covers the full 16-bit address space, but pages are only allocated the first
+ * time they are written. Reads from a page that was never written return zero */
 typedef struct memory_t {
-    word_t data[MEMORY_SIZE];
+    memory_page_t *pages[MEMORY_PAGE_COUNT];
+    memory_invalidate_handler_t invalidate_handler;
+    void *invalidate_context;
+    /** Mapped devices, and how many of them touch each page. Accesses only look for a device
+     * when their page has one. Mappings outlive a reset, like the devices themselves */
+    memory_device_t devices[MEMORY_DEVICES_MAX];
+    int device_count;
+    unsigned char device_pages[MEMORY_PAGE_COUNT];
+    /** Incremented on every write, so readers can tell which pages changed since they last
+     * looked. Unallocated pages carry the generation at which the memory was last reset */
+    unsigned long generation;
+    unsigned long reset_generation;
 } memory_t, *memory_p;
 
+/** Every word of an unallocated page decodes to this (x0000, a BR that never branches) */
+static const decoded_t ZERO_DECODED;
+
 /** Initializes each memory location to zero */
 void initialize_memory(memory_p);
 
-size_t address_to_index(word_t);
+/** Returns the page holding the address, allocating it if it doesn't exist yet */
+memory_page_t *get_page(memory_p, word_t);
+
+/** Notes that a stored word changed: its decoded form is dropped, its page counts as written
+ * and native code compiled from it is invalidated */
+void word_changed(memory_p, memory_page_t *, word_t address);
 
-word_t index_to_address(size_t);
+/** Returns the device mapped at the address, or NULL if there isn't one */
+memory_device_t *find_device(memory_p, word_t address);
 
 /** Allocates and initializes a new memory module. */
-memory_p memory_create() {
-    memory_p memory = calloc(MEMORY_SIZE, sizeof(memory_t));
+memory_p memory_create() { return memory_create_at(calloc(1, sizeof(memory_t))); }
+
+/** Initializes a memory module in storage supplied by the caller */
+memory_p memory_create_at(void *storage) {
+    memory_p memory = storage;
     initialize_memory(memory);
     return memory;
 }
+
+/** Gets the number of bytes a memory module needs, not counting its pages */
+size_t memory_size() { return sizeof(memory_t); }
 /** Reinitializes the memory module without reallocation */
 void memory_reset(memory_p memory) { initialize_memory(memory); }
 
 /** Deallocates the memory module */
-void memory_destroy(memory_p memory) { free(memory); }
+void memory_destroy(memory_p memory) {
+    memory_destroy_at(memory);
+    free(memory);
+}
 
-/** Takes a snapshot of the memory for debugging or display purposes */
-const memory_snapshot_t memory_get_snapshot(memory_p memory) {
-    memory_snapshot_t snapshot;
-    memcpy(snapshot.data, memory->data, sizeof(word_t) * MEMORY_SIZE);
-    return snapshot;
+/** Releases the pages of a memory module without freeing the module itself */
+void memory_destroy_at(memory_p memory) { initialize_memory(memory); }
+
+/** Brings a snapshot of the memory up to date. A page is only copied if its generation differs
+ * from the one the snapshot recorded for it, which means it was written (or released by a
+ * reset) since */
+void memory_update_snapshot(memory_p memory, memory_snapshot_t *snapshot) {
+    if (snapshot->generation == memory->generation) {
+        return;
+    }
+    unsigned int i;
+    for (i = 0; i < MEMORY_PAGE_COUNT; i++) {
+        memory_page_t *page = memory->pages[i];
+        unsigned long generation = (page != NULL) ? page->generation : memory->reset_generation;
+        if (generation == snapshot->page_generations[i]) {
+            continue;
+        }
+        word_t *destination = snapshot->data + i * MEMORY_PAGE_SIZE;
+        if (page != NULL) {
+            memcpy(destination, page->data, sizeof(word_t) * MEMORY_PAGE_SIZE);
+        } else {
+            memset(destination, 0, sizeof(word_t) * MEMORY_PAGE_SIZE);
+        }
+        snapshot->page_generations[i] = generation;
+    }
+    snapshot->generation = memory->generation;
 }
 
-/** Writes to the specified memory address */
+/** Writes back every word that differs from the snapshot. Decoded and translated copies of
+ * them are dropped as usual, but devices aren't told: only their stored state goes back */
+void memory_restore_snapshot(memory_p memory, const memory_snapshot_t *snapshot) {
+    if (snapshot->generation == memory->generation) {
+        return;
+    }
+    unsigned int i;
+    for (i = 0; i < MEMORY_PAGE_COUNT; i++) {
+        memory_page_t *page = memory->pages[i];
+        unsigned long generation = (page != NULL) ? page->generation : memory->reset_generation;
+        if (generation == snapshot->page_generations[i]) {
+            continue;
+        }
+        unsigned int address;
+        for (address = i * MEMORY_PAGE_SIZE; address < (i + 1) * MEMORY_PAGE_SIZE; address++) {
+            if (memory_peek(memory, address) != snapshot->data[address]) {
+                memory_poke(memory, address, snapshot->data[address]);
+            }
+        }
+    }
+}
+
+/** Writes to the specified memory address, or to the device mapped there */
 void memory_write(memory_p memory, word_t address, word_t data) {
-    size_t index = address_to_index(address);
-    memory->data[index] = data;
+    if (memory->device_pages[PAGE_OF(address)] != 0) {
+        memory_device_t *device = find_device(memory, address);
+        if (device != NULL) {
+            memory_page_t *page = get_page(memory, address);
+            word_t *stored = &page->data[OFFSET_OF(address)];
+            word_t before = *stored;
+            device->write(device->context, address, data, stored);
+            if (*stored != before) {
+                word_changed(memory, page, address);
+            }
+            return;
+        }
+    }
+    memory_poke(memory, address, data);
 }
 
-/** Reads from the memory at the specified address and returns the data */
+/** Writes a block of words. Each page it touches is copied into at once and has its decoded
+ * entries dropped together; only translated words need looking at one by one */
+void memory_write_block(memory_p memory, word_t address, const word_t *data, size_t count) {
+    size_t start = address;
+    size_t end = start + count;
+    while (start < end) {
+        size_t offset = OFFSET_OF(start);
+        size_t length = MEMORY_PAGE_SIZE - offset;
+        if (length > end - start) {
+            length = end - start;
+        }
+        memory_page_t *page = get_page(memory, start);
+        memcpy(page->data + offset, data, sizeof(word_t) * length);
+        memset(page->decoded_valid + offset, FALSE, sizeof(bool_t) * length);
+        page->generation = ++memory->generation;
+        size_t i;
+        for (i = offset; i < offset + length; i++) {
+            if (page->translated[i] == TRUE) {
+                page->translated[i] = FALSE;
+                memory->invalidate_handler(memory->invalidate_context,
+                                           PAGE_OF(start) * MEMORY_PAGE_SIZE + i);
+            }
+        }
+        data += length;
+        start += length;
+    }
+}
+
+/** Reads from the memory at the specified address and returns the data. A device mapped
+ * there is asked instead */
 word_t memory_get_data(memory_p memory, word_t address) {
-    size_t index = address_to_index(address);
-    return memory->data[index];
+    if (memory->device_pages[PAGE_OF(address)] != 0) {
+        memory_device_t *device = find_device(memory, address);
+        if (device != NULL) {
+            memory_page_t *page = get_page(memory, address);
+            word_t *stored = &page->data[OFFSET_OF(address)];
+            word_t before = *stored;
+            word_t data = device->read(device->context, address, stored);
+            if (*stored != before) {
+                word_changed(memory, page, address);
+            }
+            return data;
+        }
+    }
+    return memory_peek(memory, address);
 }
 
-/** Initializes each memory location to zero */
+/** Reads the stored word at an address, leaving any device mapped there alone */
+word_t memory_peek(memory_p memory, word_t address) {
+    memory_page_t *page = memory->pages[PAGE_OF(address)];
+    return (page != NULL) ? page->data[OFFSET_OF(address)] : 0;
+}
+
+/** Writes the stored word at an address, leaving any device mapped there alone */
+void memory_poke(memory_p memory, word_t address, word_t data) {
+    memory_page_t *page = get_page(memory, address);
+    page->data[OFFSET_OF(address)] = data;
+    word_changed(memory, page, address);
+}
+
+/** Gets the words of a page without allocating it */
+const word_t *memory_get_page(memory_p memory, unsigned int page) {
+    return (memory->pages[page] != NULL) ? memory->pages[page]->data : NULL;
+}
+
+/** Returns the decoded form of the word at the specified address, decoding it first if the
+ * word has been written since it was last decoded */
+const decoded_t *memory_get_decoded(memory_p memory, word_t address) {
+    memory_page_t *page = memory->pages[PAGE_OF(address)];
+    if (page == NULL) {
+        return &ZERO_DECODED;
+    }
+    size_t offset = OFFSET_OF(address);
+    if (page->decoded_valid[offset] == FALSE) {
+        decoder_decode(page->data[offset], &page->decoded[offset]);
+        page->decoded_valid[offset] = TRUE;
+    }
+    return &page->decoded[offset];
+}
+
+/** Registers the handler called when a translated word is written */
+void memory_set_invalidate_handler(memory_p memory, memory_invalidate_handler_t handler,
+                                   void *context) {
+    memory->invalidate_handler = handler;
+    memory->invalidate_context = context;
+}
+
+/** Maps a range of addresses to a device. Does nothing once MEMORY_DEVICES_MAX are mapped */
+void memory_map_device(memory_p memory, word_t first, word_t last, memory_device_read_t read,
+                       memory_device_write_t write, void *context) {
+    if (memory->device_count == MEMORY_DEVICES_MAX) {
+        return;
+    }
+    memory_device_t *device = &memory->devices[memory->device_count++];
+    device->first = first;
+    device->last = last;
+    device->read = read;
+    device->write = write;
+    device->context = context;
+    unsigned int page;
+    for (page = PAGE_OF(first); page <= PAGE_OF(last); page++) {
+        memory->device_pages[page]++;
+    }
+}
+
+/** Removes every device mapped with the context, keeping the rest in the order they were
+ * mapped */
+void memory_unmap_device(memory_p memory, void *context) {
+    int kept = 0;
+    int i;
+    for (i = 0; i < memory->device_count; i++) {
+        memory_device_t *device = &memory->devices[i];
+        if (device->context != context) {
+            memory->devices[kept++] = *device;
+            continue;
+        }
+        unsigned int page;
+        for (page = PAGE_OF(device->first); page <= PAGE_OF(device->last); page++) {
+            memory->device_pages[page]--;
+        }
+    }
+    memory->device_count = kept;
+}
+
+/** Marks a word as having been translated to native code. The page is allocated if needed so a
+ * later write to it is still noticed */
+void memory_mark_translated(memory_p memory, word_t address) {
+    get_page(memory, address)->translated[OFFSET_OF(address)] = TRUE;
+}
+
+/** Unmarks a word as having been translated to native code */
+void memory_unmark_translated(memory_p memory, word_t address) {
+    memory_page_t *page = memory->pages[PAGE_OF(address)];
+    if (page != NULL) {
+        page->translated[OFFSET_OF(address)] = FALSE;
+    }
+}
+
+/** Releases every page, which leaves each memory location reading as zero */
 void initialize_memory(memory_p memory) {
     unsigned int i;
-    for (i = 0; i < MEMORY_SIZE; i++) {
-        memory->data[i] = 0;
+    for (i = 0; i < MEMORY_PAGE_COUNT; i++) {
+        free(memory->pages[i]);
+        memory->pages[i] = NULL;
     }
+    memory->reset_generation = ++memory->generation;
 }
 
-size_t address_to_index(word_t address) { return address - MEMORY_ADDRESS_MIN; }
+/** Returns the page holding the address, allocating it if it doesn't exist yet */
+memory_page_t *get_page(memory_p memory, word_t address) {
+    memory_page_t **page = &memory->pages[PAGE_OF(address)];
+    if (*page == NULL) {
+        *page = calloc(1, sizeof(memory_page_t));
+    }
+    return *page;
+}
+
+/** Notes that a stored word changed */
+void word_changed(memory_p memory, memory_page_t *page, word_t address) {
+    size_t offset = OFFSET_OF(address);
+    page->decoded_valid[offset] = FALSE;
+    page->generation = ++memory->generation;
+    if (page->translated[offset] == TRUE) {
+        page->translated[offset] = FALSE;
+        memory->invalidate_handler(memory->invalidate_context, address);
+    }
+}
 
-word_t index_to_address(size_t index) { return MEMORY_ADDRESS_MIN + index; }
+/** Returns the device mapped at the address. Only called for pages that have one */
+memory_device_t *find_device(memory_p memory, word_t address) {
+    int i;
+    for (i = 0; i < memory->device_count; i++) {
+        if (address >= memory->devices[i].first && address <= memory->devices[i].last) {
+            return &memory->devices[i];
+        }
+    }
+    return NULL;
+}
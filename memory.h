@@ -27,26 +27,98 @@
 #ifndef MEMORY_H
 #define MEMORY_H
 
+#include "decoder.h"
 #include "global.h"
 
+/** The number of wait states (in cycles) the memory holds the CPU for on a read and a write.
+ * Reads and writes complete at once in the simulator; the timing model charges these */
+#define MEM_WRITE_DELAY 50
+#define MEM_READ_DELAY 50
+
 typedef struct memory_t *memory_p;
 
+/** Called when a write lands on a word that has been marked as translated */
+typedef void (*memory_invalidate_handler_t)(void *context, word_t address);
+
+/** The most address ranges that can be mapped to devices at once */
+#define MEMORY_DEVICES_MAX 8
+
+/** Called for reads and writes of a word mapped to a device. Stored is the word of memory
+ * behind the address, which the device can keep its register's state in so it is saved,
+ * snapshotted and restored along with the rest of memory. A read returns what the program
+ * sees */
+typedef word_t (*memory_device_read_t)(void *context, word_t address, word_t *stored);
+typedef void (*memory_device_write_t)(void *context, word_t address, word_t data,
+                                      word_t *stored);
+
 /** Allocates and initializes a new memory module. */
 memory_p memory_create();
 
+/** Initializes a new memory module in zeroed storage of at least memory_size() bytes supplied
+ * by the caller. Pages are still allocated on first write */
+memory_p memory_create_at(void *storage);
+
+/** Gets the number of bytes a memory module needs, not counting its pages */
+size_t memory_size();
+
 /** Reinitializes the memory module without reallocation */
 void memory_reset(memory_p);
 
 /** Deallocates the memory module */
 void memory_destroy(memory_p);
 
-/** Takes a snapshot of the memory for debugging or display purposes */
-const memory_snapshot_t memory_get_snapshot(memory_p);
+/** Releases the pages of a memory module created with memory_create_at. The storage itself
+ * belongs to the caller */
+void memory_destroy_at(memory_p);
+
+/** Brings a snapshot of the memory up to date for debugging or display purposes. Only the
+ * pages written since the snapshot was last updated are copied. A new snapshot must start
+ * zeroed */
+void memory_update_snapshot(memory_p, memory_snapshot_t *);
+
+/** Writes back every word that differs from the snapshot, looking only at the pages written
+ * since the snapshot was last updated. Used to go back to an earlier state */
+void memory_restore_snapshot(memory_p, const memory_snapshot_t *);
 
 /** Writes to the specified memory address */
 void memory_write(memory_p, word_t address, word_t data);
 
+/** Writes count words starting at the specified address, a page at a time. The words must
+ * fit below MEMORY_SIZE. Used to load whole programs */
+void memory_write_block(memory_p, word_t address, const word_t *data, size_t count);
+
 /** Reads from the specified memory address and returns the data */
 word_t memory_get_data(memory_p, word_t);
 
+/** Gets the words of the specified page, or NULL if the page has never been written and so
+ * reads as all zeros */
+const word_t *memory_get_page(memory_p, unsigned int page);
+
+/** Returns the decoded form of the word at the specified address. The word is only decoded the
+ * first time it is requested after being written */
+const decoded_t *memory_get_decoded(memory_p, word_t);
+
+/** Registers the handler called when a translated word is written. Used by the JIT to drop
+ * native code that was compiled from a word that has since changed */
+void memory_set_invalidate_handler(memory_p, memory_invalidate_handler_t, void *context);
+
+/** Maps the addresses from first to last to a device. Reads and writes of them go to the
+ * handlers instead of memory. Loading a program and restoring a snapshot still set the stored
+ * words directly. Pages without a device cost nothing extra to access */
+void memory_map_device(memory_p, word_t first, word_t last, memory_device_read_t,
+                       memory_device_write_t, void *context);
+
+/** Removes every device mapped with the context given */
+void memory_unmap_device(memory_p, void *context);
+
+/** Reads/writes the word stored at an address without going through any device mapped
+ * there. Used by devices themselves, and by the debugger so that looking at or undoing an
+ * access doesn't disturb them */
+word_t memory_peek(memory_p, word_t);
+void memory_poke(memory_p, word_t address, word_t data);
+
+/** Marks/unmarks a word as having been translated to native code */
+void memory_mark_translated(memory_p, word_t address);
+void memory_unmark_translated(memory_p, word_t address);
+
 #endif
@@ -0,0 +1,309 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Profile Module File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#include "profile.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** A counter and the address or opcode it belongs to, for sorting */
+typedef struct profile_entry_t {
+    word_t key;
+    unsigned long long count;
+} profile_entry_t;
+
+/** Gathers the non-zero counters into a new array sorted by count, highest first, and returns
+ * how many there are */
+int profile_sort(unsigned long long *counts, int size, profile_entry_t **entries);
+
+/** Orders entries by count, highest first. Ties go to the lower key */
+int profile_compare(const void *, const void *);
+
+/** Gets a percentage without dividing by zero */
+double profile_share(unsigned long long count, unsigned long long total);
+
+/** Charges the instructions since the top frame last changed to it */
+void profile_switch(profile_p, unsigned long long count);
+
+/** Pops the top frame of the shadow stack */
+void profile_pop(profile_p, unsigned long long count);
+
+/** Finds or adds the call path for a function called from the parent path */
+int profile_node(profile_p, int parent, word_t function);
+
+/** Writes the path of a node from the root down, separated by ';' */
+void profile_write_path(profile_p, int node, FILE *);
+
+/** Pops whatever is still on the shadow stack, the entry point included */
+void profile_finish(profile_p);
+
+/** Allocates a profile with every counter at zero */
+profile_p profile_create() { return calloc(1, sizeof(profile_t)); }
+
+/** Sets every counter back to zero */
+void profile_reset(profile_p profile) { memset(profile, 0, sizeof(profile_t)); }
+
+/** Deallocates the profile */
+void profile_destroy(profile_p profile) { free(profile); }
+
+/** Puts the program's entry point at the bottom of the shadow call stack */
+void profile_start(profile_p profile, word_t entry) {
+    profile_frame_t *frame = &profile->frames[0];
+    frame->function = entry;
+    frame->return_address = entry;
+    frame->node = profile_node(profile, -1, entry);
+    frame->entry = profile->instructions;
+    profile->call_counts[entry]++;
+    profile->active_counts[entry]++;
+    profile->depth = 1;
+    profile->max_depth = 1;
+    profile->last_switch = profile->instructions;
+}
+
+/** Records a JSR or JSRR to the function */
+void profile_call(profile_p profile, word_t function, word_t return_address,
+                  unsigned long long count) {
+    profile_switch(profile, count);
+    profile->call_counts[function]++;
+    if (profile->depth < PROFILE_STACK_DEPTH) {
+        profile_frame_t *frame = &profile->frames[profile->depth];
+        frame->function = function;
+        frame->return_address = return_address;
+        int caller = profile->frames[profile->depth - 1].node;
+        frame->node = profile_node(profile, caller, function);
+        frame->entry = count;
+        profile->active_counts[function]++;
+    }
+    profile->depth++;
+    if (profile->depth > profile->max_depth) {
+        profile->max_depth = profile->depth;
+    }
+}
+
+/** Records a RET to the target */
+void profile_return(profile_p profile, word_t target, unsigned long long count) {
+    /** Past the kept frames there is nothing to match the return address against */
+    if (profile->depth > PROFILE_STACK_DEPTH) {
+        profile->depth--;
+        return;
+    }
+    /** Subroutines that returned some other way (by jumping, say) are popped along with the
+     * one the RET belongs to. The entry point's frame is never popped */
+    int i;
+    for (i = profile->depth - 1; i > 0; i--) {
+        if (profile->frames[i].return_address == target) {
+            profile_switch(profile, count);
+            while (profile->depth > i) {
+                profile_pop(profile, count);
+            }
+            return;
+        }
+    }
+}
+
+/** Pops whatever is still on the shadow stack, the entry point included */
+void profile_finish(profile_p profile) {
+    if (profile->depth == 0) {
+        return;
+    }
+    profile_switch(profile, profile->instructions);
+    while (profile->depth > PROFILE_STACK_DEPTH) {
+        profile->depth--;
+    }
+    while (profile->depth > 0) {
+        profile_pop(profile, profile->instructions);
+    }
+}
+
+/** Charges the instructions since the top frame last changed to it */
+void profile_switch(profile_p profile, unsigned long long count) {
+    int top = (profile->depth < PROFILE_STACK_DEPTH) ? profile->depth : PROFILE_STACK_DEPTH;
+    profile_frame_t *frame = &profile->frames[top - 1];
+    unsigned long long executed = count - profile->last_switch;
+    profile->nodes[frame->node].exclusive += executed;
+    profile->exclusive_counts[frame->function] += executed;
+    profile->last_switch = count;
+}
+
+/** Pops the top frame of the shadow stack. The inclusive count is only taken when the
+ * outermost frame of a function goes, so recursion doesn't count its instructions twice */
+void profile_pop(profile_p profile, unsigned long long count) {
+    profile->depth--;
+    profile_frame_t *frame = &profile->frames[profile->depth];
+    profile->active_counts[frame->function]--;
+    if (profile->active_counts[frame->function] == 0) {
+        profile->inclusive_counts[frame->function] += count - frame->entry;
+    }
+}
+
+/** Finds or adds the call path for a function called from the parent path */
+int profile_node(profile_p profile, int parent, word_t function) {
+    unsigned int slot = ((unsigned int)(parent + 1) * 31u + function) % PROFILE_NODE_HASH_SIZE;
+    while (profile->node_hash[slot] != 0) {
+        profile_node_t *node = &profile->nodes[profile->node_hash[slot] - 1];
+        if (node->parent == parent && node->function == function) {
+            return profile->node_hash[slot] - 1;
+        }
+        slot = (slot + 1) % PROFILE_NODE_HASH_SIZE;
+    }
+    if (profile->node_count == PROFILE_NODE_COUNT) {
+        return parent;
+    }
+    int index = profile->node_count++;
+    profile->nodes[index].parent = parent;
+    profile->nodes[index].function = function;
+    profile->nodes[index].exclusive = 0;
+    profile->node_hash[slot] = index + 1;
+    return index;
+}
+
+/** Writes the report */
+void profile_report(profile_p profile, memory_p memory, FILE *file_ptr) {
+    unsigned long long total = 0;
+    int i;
+    for (i = 0; i < OPCODE_COUNT; i++) {
+        total += profile->opcode_counts[i];
+    }
+    fprintf(file_ptr, "Instructions: %llu\n", total);
+
+    profile_entry_t *entries;
+    int count = profile_sort(profile->opcode_counts, OPCODE_COUNT, &entries);
+    fprintf(file_ptr, "\n%-6s %14s %7s\n", "Opcode", "Count", "Share");
+    for (i = 0; i < count; i++) {
+        fprintf(file_ptr, "%-6s %14llu %6.2f%%\n", decoder_opcode_name(entries[i].key),
+                entries[i].count, profile_share(entries[i].count, total));
+    }
+    free(entries);
+
+    count = profile_sort(profile->pc_counts, MEMORY_SIZE, &entries);
+    fprintf(file_ptr, "\n%-7s %-6s %-6s %14s %7s\n", "Address", "IR", "Opcode", "Count",
+            "Share");
+    for (i = 0; i < count && i < PROFILE_REPORT_LINES; i++) {
+        const decoded_t *d = memory_get_decoded(memory, entries[i].key);
+        fprintf(file_ptr, "x%04X   x%04X  %-6s %14llu %6.2f%%\n", entries[i].key, d->ir,
+                decoder_opcode_name(d->opcode), entries[i].count,
+                profile_share(entries[i].count, total));
+    }
+    free(entries);
+
+    /** A loop runs from the target of its back-edge down to the BR itself. Its body count is
+     * every instruction executed in that range, inner loops included */
+    count = profile_sort(profile->back_edge_counts, MEMORY_SIZE, &entries);
+    fprintf(file_ptr, "\n%-11s %14s %14s %7s\n", "Loop", "Iterations", "Body", "Share");
+    for (i = 0; i < count && i < PROFILE_REPORT_LINES; i++) {
+        word_t branch = entries[i].key;
+        const decoded_t *d = memory_get_decoded(memory, branch);
+        word_t target = branch + 1 + d->pc_offset_9;
+        unsigned long long body = 0;
+        unsigned int address;
+        if (target <= branch) {
+            for (address = target; address <= branch; address++) {
+                body += profile->pc_counts[address];
+            }
+        }
+        fprintf(file_ptr, "x%04X-x%04X %14llu %14llu %6.2f%%\n", target, branch,
+                entries[i].count, body, profile_share(body, total));
+    }
+    free(entries);
+
+    profile_finish(profile);
+    count = profile_sort(profile->inclusive_counts, MEMORY_SIZE, &entries);
+    fprintf(file_ptr, "\n%-10s %10s %14s %7s %14s %7s\n", "Subroutine", "Calls", "Inclusive",
+            "Share", "Exclusive", "Share");
+    for (i = 0; i < count && i < PROFILE_REPORT_LINES; i++) {
+        word_t function = entries[i].key;
+        fprintf(file_ptr, "x%04X      %10llu %14llu %6.2f%% %14llu %6.2f%%\n", function,
+                profile->call_counts[function], entries[i].count,
+                profile_share(entries[i].count, total), profile->exclusive_counts[function],
+                profile_share(profile->exclusive_counts[function], total));
+    }
+    free(entries);
+    fprintf(file_ptr, "\nMaximum call depth: %d\n", profile->max_depth);
+    if (profile->stack_high != 0) {
+        fprintf(file_ptr, "Stack: R6 from x%04X down to x%04X (%d words)\n",
+                profile->stack_high, profile->stack_low,
+                profile->stack_high - profile->stack_low);
+    }
+    fflush(file_ptr);
+}
+
+/** Gathers the non-zero counters into a new array sorted by count */
+int profile_sort(unsigned long long *counts, int size, profile_entry_t **entries) {
+    int count = 0;
+    int i;
+    for (i = 0; i < size; i++) {
+        count += (counts[i] != 0);
+    }
+    /** Always allocates at least one entry so the caller can free it either way */
+    *entries = malloc((count + 1) * sizeof(profile_entry_t));
+    count = 0;
+    for (i = 0; i < size; i++) {
+        if (counts[i] != 0) {
+            (*entries)[count].key = (word_t)i;
+            (*entries)[count].count = counts[i];
+            count++;
+        }
+    }
+    qsort(*entries, count, sizeof(profile_entry_t), profile_compare);
+    return count;
+}
+
+/** Orders entries by count, highest first. Ties go to the lower key */
+int profile_compare(const void *a, const void *b) {
+    const profile_entry_t *left = a;
+    const profile_entry_t *right = b;
+    if (left->count != right->count) {
+        return (left->count > right->count) ? -1 : 1;
+    }
+    return (int)left->key - (int)right->key;
+}
+
+/** Gets a percentage without dividing by zero */
+double profile_share(unsigned long long count, unsigned long long total) {
+    return (total == 0) ? 0.0 : 100.0 * (double)count / (double)total;
+}
+
+/** Writes one line per call path in the collapsed stack format */
+void profile_write_collapsed(profile_p profile, FILE *file_ptr) {
+    profile_finish(profile);
+    int i;
+    for (i = 0; i < profile->node_count; i++) {
+        if (profile->nodes[i].exclusive != 0) {
+            profile_write_path(profile, i, file_ptr);
+            fprintf(file_ptr, " %llu\n", profile->nodes[i].exclusive);
+        }
+    }
+    fflush(file_ptr);
+}
+
+/** Writes the path of a node from the root down, separated by ';' */
+void profile_write_path(profile_p profile, int node, FILE *file_ptr) {
+    int parent = profile->nodes[node].parent;
+    if (parent >= 0) {
+        profile_write_path(profile, parent, file_ptr);
+        fputc(';', file_ptr);
+    }
+    fprintf(file_ptr, "x%04X", profile->nodes[node].function);
+}
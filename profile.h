@@ -0,0 +1,148 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Profile Module Header File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "decoder.h"
+#include "global.h"
+#include "memory.h"
+#include <stdio.h>
+
+/* Command line flags. The second form names the report file */
+#define PROFILE_FLAG "--profile"
+#define PROFILE_FILE_FLAG "--profile="
+#define PROFILE_REPORT_DEFAULT "profile.txt"
+
+#define PROFILE_COLLAPSED_FLAG "--collapsed-stacks="
+
+/** How many of the hottest addresses, loops and subroutines the report lists */
+#define PROFILE_REPORT_LINES 20
+
+/** Calls nested deeper than this are still counted towards the depth, but their instructions
+ * are charged to the deepest frame that was kept */
+#define PROFILE_STACK_DEPTH 1024
+
+/** How many distinct call paths the call graph keeps. Once they run out, new paths are
+ * charged to their caller's path. The hash table has room for twice as many */
+#define PROFILE_NODE_COUNT 4096
+#define PROFILE_NODE_HASH_SIZE (2 * PROFILE_NODE_COUNT)
+
+/** One call path: a subroutine and the path it was called from. The root path is the
+ * program's entry point */
+typedef struct profile_node_t {
+    int parent; /* -1 for the root */
+    word_t function;
+    unsigned long long exclusive;
+} profile_node_t;
+
+/** One entry of the shadow call stack */
+typedef struct profile_frame_t {
+    word_t function;
+    word_t return_address;
+    int node;
+    unsigned long long entry; /* The instruction count when the call was made */
+} profile_frame_t;
+
+/** Execution counters. These are flat arrays indexed by address so the fast engine only has to
+ * bump a counter per instruction; all of the sorting is left for the report. The call graph is
+ * only touched by JSR, JSRR and RET */
+typedef struct profile_t {
+    /** How many times the instruction at each address was executed */
+    unsigned long long pc_counts[MEMORY_SIZE];
+
+    /** How many times each opcode was executed */
+    unsigned long long opcode_counts[OPCODE_COUNT];
+
+    /** How many times the BR at each address was taken backwards. Each of these back-edges
+     * closes a loop, and the count is the number of times around it */
+    unsigned long long back_edge_counts[MEMORY_SIZE];
+
+    /** Instructions executed before the fast engine's current run started. The engine adds
+     * its own count when it returns */
+    unsigned long long instructions;
+
+    /** Per-subroutine counters, indexed by the subroutine's address. Inclusive counts include
+     * the subroutines it called; a recursive subroutine is only counted by its outermost call.
+     * Active counts how many of its frames are on the shadow stack */
+    unsigned long long call_counts[MEMORY_SIZE];
+    unsigned long long inclusive_counts[MEMORY_SIZE];
+    unsigned long long exclusive_counts[MEMORY_SIZE];
+    unsigned int active_counts[MEMORY_SIZE];
+
+    /** The shadow call stack. Frame 0 is the entry point; depth counts frames past
+     * PROFILE_STACK_DEPTH too */
+    profile_frame_t frames[PROFILE_STACK_DEPTH];
+    int depth;
+    int max_depth;
+
+    /** The instruction count when the top frame last changed */
+    unsigned long long last_switch;
+
+    /** Call paths for the collapsed stacks, found by hashing the parent path and subroutine */
+    profile_node_t nodes[PROFILE_NODE_COUNT];
+    int node_count;
+    int node_hash[PROFILE_NODE_HASH_SIZE];
+
+    /** The lowest and highest values R6 held once the program set it. The stack grows down,
+     * so the lowest is its high-water mark */
+    word_t stack_low;
+    word_t stack_high;
+} profile_t, *profile_p;
+
+/** Allocates a profile with every counter at zero */
+profile_p profile_create();
+
+/** Puts the program's entry point at the bottom of the shadow call stack. Must be called
+ * before the first run */
+void profile_start(profile_p, word_t entry);
+
+/** Records a JSR or JSRR to the function. Count is the number of instructions executed so
+ * far, including the JSR */
+void profile_call(profile_p, word_t function, word_t return_address,
+                  unsigned long long count);
+
+/** Records a RET to the target. Frames are popped down to the call that returns there; a RET
+ * that matches no call is treated as a plain jump */
+void profile_return(profile_p, word_t target, unsigned long long count);
+
+/** Sets every counter back to zero */
+void profile_reset(profile_p);
+
+/** Deallocates the profile */
+void profile_destroy(profile_p);
+
+/** Writes the report: the instruction total, the opcodes by count, the hottest addresses, the
+ * hottest loops with their iteration counts and the call graph. The memory is used to name the
+ * instruction at each address. Subroutines still on the shadow stack are closed first */
+void profile_report(profile_p, memory_p, FILE *);
+
+/** Writes one line per call path in the collapsed stack format flame graph tools read: the
+ * subroutine addresses from the entry point down, separated by ';', and the instructions
+ * executed in the last of them. Subroutines still on the shadow stack are closed first */
+void profile_write_collapsed(profile_p, FILE *);
+
+#endif
@@ -0,0 +1,241 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Replay Module File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#include "replay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/** Written at the top of every recording */
+#define REPLAY_HEADER "# LC3 input log: <instructions> <character code>\n"
+
+/** Starting capacity of the entry list. It doubles whenever it fills */
+#define REPLAY_INITIAL_CAPACITY 64
+
+typedef struct replay_entry_t {
+    unsigned long instructions;
+    int c;
+} replay_entry_t;
+
+typedef struct replay_t {
+    /** The log being written, or NULL when replaying */
+    FILE *file_ptr;
+
+    /** Every character read so far when recording, or the whole log when replaying */
+    replay_entry_t *entries;
+    size_t count;
+    size_t capacity;
+
+    /** The next entry to replay */
+    size_t next;
+    bool_t has_diverged;
+
+    /** The console handed out by replay_attach, and the one it wraps */
+    console_t console;
+    console_t inner;
+} replay_t;
+
+/** Console routines handed out by replay_attach */
+int replay_record_char(void *);
+int replay_play_char(void *);
+bool_t replay_record_poll(void *, int timeout_ms);
+bool_t replay_play_poll(void *, int timeout_ms);
+void replay_put_char(void *, char);
+
+/** Adds an entry to the end of the list, growing it if it's full */
+void replay_append(replay_p, unsigned long instructions, int c);
+
+/** Writes an entry to the log in the recording format */
+void replay_write_entry(FILE *, const replay_entry_t *);
+
+/** Opens the file and starts a recording */
+replay_p replay_create_recorder(char *file_name) {
+    FILE *file_ptr = fopen(file_name, "w");
+    if (file_ptr == NULL) {
+        return NULL;
+    }
+    replay_p replay = calloc(1, sizeof(replay_t));
+    replay->file_ptr = file_ptr;
+    fputs(REPLAY_HEADER, file_ptr);
+    fflush(file_ptr);
+    return replay;
+}
+
+/** Reads an input log back for replaying */
+replay_p replay_create_player(char *file_name) {
+    FILE *file_ptr = fopen(file_name, "r");
+    if (file_ptr == NULL) {
+        return NULL;
+    }
+    replay_p replay = calloc(1, sizeof(replay_t));
+    char line[STRING_SIZE];
+    while (fgets(line, sizeof(line), file_ptr) != NULL) {
+        unsigned long instructions;
+        int c;
+        if (line[0] == REPLAY_COMMENT || strspn(line, " \t\r\n") == strlen(line)) {
+            continue;
+        }
+        if (sscanf(line, "%lu %d", &instructions, &c) != 2 || c < EOF || c > 255) {
+            fclose(file_ptr);
+            replay_destroy(replay);
+            return NULL;
+        }
+        replay_append(replay, instructions, c);
+    }
+    fclose(file_ptr);
+    return replay;
+}
+
+/** Closes the file and deallocates the replay */
+void replay_destroy(replay_p replay) {
+    if (replay->file_ptr != NULL) {
+        fclose(replay->file_ptr);
+    }
+    free(replay->entries);
+    free(replay);
+}
+
+/** Gets a console that reads input through the replay and sends output on to the inner one */
+console_p replay_attach(replay_p replay, console_p inner) {
+    replay->inner = *inner;
+    replay->console.get_char =
+        (replay->file_ptr != NULL) ? replay_record_char : replay_play_char;
+    if (replay->file_ptr == NULL) {
+        replay->console.poll_char = replay_play_poll;
+    } else {
+        replay->console.poll_char = (inner->poll_char != NULL) ? replay_record_poll : NULL;
+    }
+    replay->console.put_char = replay_put_char;
+    replay->console.context = replay;
+    replay->console.instructions = inner->instructions;
+    return &replay->console;
+}
+
+/** Forgets every character read after the given number of instructions. A recording is
+ * rewritten without them, and a replay picks up again from the first of them */
+void replay_rewind(replay_p replay, unsigned long instructions) {
+    replay->console.instructions = instructions;
+    size_t kept = 0;
+    while (kept < replay->count && replay->entries[kept].instructions <= instructions) {
+        kept++;
+    }
+    if (replay->file_ptr == NULL) {
+        replay->next = (replay->next < kept) ? replay->next : kept;
+        return;
+    }
+    if (kept == replay->count) {
+        return;
+    }
+    replay->count = kept;
+    rewind(replay->file_ptr);
+    if (ftruncate(fileno(replay->file_ptr), 0) != 0) {
+        return;
+    }
+    fputs(REPLAY_HEADER, replay->file_ptr);
+    size_t i;
+    for (i = 0; i < replay->count; i++) {
+        replay_write_entry(replay->file_ptr, &replay->entries[i]);
+    }
+    fflush(replay->file_ptr);
+}
+
+/** GETC while recording. Reads from the inner console and logs the character, or the end of
+ * the input */
+int replay_record_char(void *context) {
+    replay_p replay = context;
+    int c = replay->inner.get_char(replay->inner.context);
+    if (c != EOF) {
+        c = (unsigned char)c;
+    }
+    replay_append(replay, replay->console.instructions, c);
+    replay_write_entry(replay->file_ptr, &replay->entries[replay->count - 1]);
+    fflush(replay->file_ptr);
+    return c;
+}
+
+/** GETC while replaying. Takes the next character from the log, warning once if the program
+ * asks for it at a different point than it did when it was recorded */
+int replay_play_char(void *context) {
+    replay_p replay = context;
+    fflush(stdout);
+    if (replay->next == replay->count) {
+        fprintf(stderr, "GETC: end of replay, halting\n");
+        return EOF;
+    }
+    replay_entry_t *entry = &replay->entries[replay->next++];
+    if (entry->instructions != replay->console.instructions && replay->has_diverged == FALSE) {
+        fprintf(stderr,
+                "Replay diverged: input %lu was recorded at instruction %lu but read at "
+                "instruction %lu\n",
+                (unsigned long)replay->next, entry->instructions,
+                replay->console.instructions);
+        replay->has_diverged = TRUE;
+    }
+    if (entry->c == EOF) {
+        fprintf(stderr, "GETC: end of input, halting\n");
+    }
+    return entry->c;
+}
+
+/** Polling while recording asks the inner console */
+bool_t replay_record_poll(void *context, int timeout_ms) {
+    replay_p replay = context;
+    return replay->inner.poll_char(replay->inner.context, timeout_ms);
+}
+
+/** Polling while replaying. The next character is ready once the program has run as far as
+ * it had when the character was recorded, and the end of the replay is ready at once */
+bool_t replay_play_poll(void *context, int timeout_ms) {
+    replay_p replay = context;
+    return (replay->next == replay->count ||
+            replay->entries[replay->next].instructions <= replay->console.instructions)
+               ? TRUE
+               : FALSE;
+}
+
+/** OUT and PUTS go straight on to the inner console */
+void replay_put_char(void *context, char c) {
+    replay_p replay = context;
+    replay->inner.put_char(replay->inner.context, c);
+}
+
+/** Adds an entry to the end of the list, growing it if it's full */
+void replay_append(replay_p replay, unsigned long instructions, int c) {
+    if (replay->count == replay->capacity) {
+        replay->capacity =
+            (replay->capacity == 0) ? REPLAY_INITIAL_CAPACITY : replay->capacity * 2;
+        replay->entries = realloc(replay->entries, replay->capacity * sizeof(replay_entry_t));
+    }
+    replay->entries[replay->count].instructions = instructions;
+    replay->entries[replay->count].c = c;
+    replay->count++;
+}
+
+/** Writes an entry to the log in the recording format */
+void replay_write_entry(FILE *file_ptr, const replay_entry_t *entry) {
+    fprintf(file_ptr, "%lu %d\n", entry->instructions, entry->c);
+}
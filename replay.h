@@ -0,0 +1,68 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Replay Module Header File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "global.h"
+#include "slc3.h"
+
+/* Command line flags. Name the file console input is recorded to or replayed from */
+#define RECORD_FLAG "--record="
+#define REPLAY_FLAG "--replay="
+
+/** An input log is a text file with one line per character read, by GETC or by the keyboard:
+ * the number of instructions retired when it was read, counting the GETC itself, and the
+ * character code, both in decimal. A code of -1 marks where the input ended. Lines starting
+ * with '#' are skipped */
+#define REPLAY_COMMENT '#'
+
+typedef struct replay_t *replay_p;
+
+/** Opens the file and starts a recording. Every character read through the attached console
+ * is written out as soon as it is read, so the log survives a crash. Returns NULL if the file
+ * can't be written */
+replay_p replay_create_recorder(char *file_name);
+
+/** Reads an input log back for replaying. Returns NULL if the file can't be read or isn't an
+ * input log */
+replay_p replay_create_player(char *file_name);
+
+/** Closes the file and deallocates the replay */
+void replay_destroy(replay_p);
+
+/** Gets a console that sends output on to the inner console and reads input through the
+ * replay: a recorder reads from the inner console and logs the character, a player takes
+ * the next character from the log and returns EOF once it runs out. Polling a player says a
+ * character is ready once the count it was recorded at is reached. The console belongs to
+ * the replay, and its instruction count must be kept up to date by execute() */
+console_p replay_attach(replay_p, console_p inner);
+
+/** Forgets every character read after the given number of instructions, for when execution
+ * has gone back in time. The console's instruction count is set to match */
+void replay_rewind(replay_p, unsigned long instructions);
+
+#endif
@@ -0,0 +1,255 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Savestate Module File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#include "savestate.h"
+#include "alu.h"
+#include "cpu.h"
+#include "decoder.h"
+#include "memory.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/** Written as a word so a state saved on a machine of the other byte order is recognized */
+#define SAVESTATE_BYTE_ORDER 0x0102
+
+/** Bytes taken by one saved page */
+#define SAVESTATE_PAGE_BYTES (sizeof(word_t) * MEMORY_PAGE_SIZE)
+
+/** Everything but memory. Only word_t and single byte fields, so it has no padding and the
+ * pages after it stay word aligned */
+typedef struct savestate_header_t {
+    char magic[4];
+    word_t version;
+    word_t byte_order;
+    word_t registers[REGISTER_SIZE];
+    word_t ir;
+    word_t pc;
+    word_t mar;
+    word_t mdr;
+    word_t alu_a;
+    word_t alu_b;
+    word_t alu_result;
+    word_t starting_address;
+    word_t eval_addr_calculation;
+    word_t psr;
+    word_t saved_ssp;
+    word_t saved_usp;
+    unsigned char cc;
+    unsigned char is_halted;
+    unsigned char is_file_loaded;
+    unsigned char state;
+    unsigned char opcode;
+    unsigned char branch_enabled;
+    unsigned char trap_vector;
+    unsigned char reserved;
+    /** One bit per memory page, set if the page is saved */
+    unsigned char pages[MEMORY_PAGE_COUNT / 8];
+} savestate_header_t;
+
+/** Stands in for a page that wasn't saved */
+static const word_t ZERO_PAGE[MEMORY_PAGE_SIZE];
+
+/** Fills in the header from the LC3 */
+void savestate_fill_header(lc3_p, savestate_header_t *);
+
+/** Puts the LC3's registers, ALU and microstate back from the header */
+void savestate_apply_header(lc3_p, const savestate_header_t *);
+
+/** Returns whether a page holds nothing but zeros */
+bool_t savestate_page_is_zero(const word_t *);
+
+/** Builds the whole state in one buffer so it goes out in a single write. Pages that were
+ * never written, or were written back to zero, are left out */
+bool_t savestate_save(lc3_p lc3, const char *file_name) {
+    savestate_header_t header;
+    savestate_fill_header(lc3, &header);
+    size_t size = sizeof(savestate_header_t);
+    unsigned int i;
+    for (i = 0; i < MEMORY_PAGE_COUNT; i++) {
+        const word_t *page = memory_get_page(lc3->memory, i);
+        if (page != NULL && savestate_page_is_zero(page) == FALSE) {
+            header.pages[i / 8] |= 1 << (i % 8);
+            size += SAVESTATE_PAGE_BYTES;
+        }
+    }
+    char *buffer = malloc(size);
+    memcpy(buffer, &header, sizeof(savestate_header_t));
+    char *next = buffer + sizeof(savestate_header_t);
+    for (i = 0; i < MEMORY_PAGE_COUNT; i++) {
+        if (header.pages[i / 8] & (1 << (i % 8))) {
+            memcpy(next, memory_get_page(lc3->memory, i), SAVESTATE_PAGE_BYTES);
+            next += SAVESTATE_PAGE_BYTES;
+        }
+    }
+
+    bool_t saved = FALSE;
+    int fd = open(file_name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0) {
+        size_t written = 0;
+        ssize_t result = 0;
+        while (written < size && (result = write(fd, buffer + written, size - written)) > 0) {
+            written += result;
+        }
+        saved = (close(fd) == 0 && written == size) ? TRUE : FALSE;
+    }
+    free(buffer);
+    return saved;
+}
+
+/** Checks the header and the size of the mapped file, then copies the saved pages straight
+ * out of the mapping. Pages are overwritten in place rather than the memory being reset, so
+ * restoring doesn't have to allocate them all over again; writing them also drops any decoded
+ * or translated copies of the old words */
+loader_result_t savestate_restore(lc3_p lc3, const char *file_name) {
+    int fd = open(file_name, O_RDONLY);
+    if (fd < 0) {
+        return LOADER_NOT_FOUND;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || S_ISREG(info.st_mode) == 0) {
+        close(fd);
+        return LOADER_NOT_FOUND;
+    }
+    size_t size = info.st_size;
+    if (size < sizeof(savestate_header_t)) {
+        close(fd);
+        return LOADER_BAD_FORMAT;
+    }
+    const char *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return LOADER_NOT_FOUND;
+    }
+
+    const savestate_header_t *header = (const savestate_header_t *)data;
+    size_t expected = sizeof(savestate_header_t);
+    unsigned int i;
+    for (i = 0; i < MEMORY_PAGE_COUNT; i++) {
+        if (header->pages[i / 8] & (1 << (i % 8))) {
+            expected += SAVESTATE_PAGE_BYTES;
+        }
+    }
+    loader_result_t result = LOADER_OK;
+    if (memcmp(header->magic, SAVESTATE_MAGIC, sizeof(header->magic)) != 0) {
+        result = LOADER_BAD_FORMAT;
+    } else if (header->version != SAVESTATE_VERSION ||
+               header->byte_order != SAVESTATE_BYTE_ORDER) {
+        result = LOADER_BAD_VERSION;
+    } else if (size != expected) {
+        result = LOADER_BAD_FORMAT;
+    }
+
+    if (result == LOADER_OK) {
+        const char *page = data + sizeof(savestate_header_t);
+        for (i = 0; i < MEMORY_PAGE_COUNT; i++) {
+            if (header->pages[i / 8] & (1 << (i % 8))) {
+                memory_write_block(lc3->memory, i * MEMORY_PAGE_SIZE, (const word_t *)page,
+                                   MEMORY_PAGE_SIZE);
+                page += SAVESTATE_PAGE_BYTES;
+            } else if (memory_get_page(lc3->memory, i) != NULL) {
+                memory_write_block(lc3->memory, i * MEMORY_PAGE_SIZE, ZERO_PAGE,
+                                   MEMORY_PAGE_SIZE);
+            }
+        }
+        savestate_apply_header(lc3, header);
+    }
+    munmap((void *)data, size);
+    return result;
+}
+
+/** Returns whether the file name ends in the saved state extension */
+bool_t savestate_is_file(const char *file_name) {
+    return loader_has_extension(file_name, SAVESTATE_EXTENSION);
+}
+
+/** Fills in the header from the LC3. The page bitmap starts empty */
+void savestate_fill_header(lc3_p lc3, savestate_header_t *header) {
+    memset(header, 0, sizeof(savestate_header_t));
+    memcpy(header->magic, SAVESTATE_MAGIC, sizeof(header->magic));
+    header->version = SAVESTATE_VERSION;
+    header->byte_order = SAVESTATE_BYTE_ORDER;
+    memcpy(header->registers, cpu_get_registers(lc3->cpu), sizeof(header->registers));
+    header->ir = cpu_get_ir(lc3->cpu);
+    header->pc = cpu_get_pc(lc3->cpu);
+    header->mar = cpu_get_mar(lc3->cpu);
+    header->mdr = cpu_get_mdr(lc3->cpu);
+    header->cc = cpu_get_cc(lc3->cpu);
+    alu_snapshot_t alu = alu_get_snapshot(lc3->alu);
+    header->alu_a = alu.a;
+    header->alu_b = alu.b;
+    header->alu_result = alu.result;
+    header->starting_address = lc3->starting_address;
+    header->eval_addr_calculation = lc3->eval_addr_calculation;
+    header->psr = lc3->psr;
+    header->saved_ssp = lc3->saved_ssp;
+    header->saved_usp = lc3->saved_usp;
+    header->is_halted = lc3->is_halted;
+    header->is_file_loaded = lc3->is_file_loaded;
+    header->state = lc3->state;
+    header->opcode = lc3->opcode;
+    header->branch_enabled = lc3->branch_enabled;
+    header->trap_vector = lc3->trap_vector;
+}
+
+/** Puts the LC3 back from the header. The decoded copy of the IR isn't saved since it can be
+ * decoded again */
+void savestate_apply_header(lc3_p lc3, const savestate_header_t *header) {
+    memcpy(cpu_get_registers(lc3->cpu), header->registers, sizeof(header->registers));
+    cpu_set_ir(lc3->cpu, header->ir);
+    cpu_set_pc(lc3->cpu, header->pc);
+    cpu_set_mar(lc3->cpu, header->mar);
+    cpu_set_mdr(lc3->cpu, header->mdr);
+    cpu_set_cc(lc3->cpu, header->cc);
+    alu_snapshot_t alu = {header->alu_a, header->alu_b, header->alu_result};
+    alu_restore_snapshot(lc3->alu, &alu);
+    lc3->starting_address = header->starting_address;
+    lc3->eval_addr_calculation = header->eval_addr_calculation;
+    lc3->psr = header->psr;
+    lc3->saved_ssp = header->saved_ssp;
+    lc3->saved_usp = header->saved_usp;
+    lc3->is_halted = header->is_halted;
+    lc3->is_file_loaded = header->is_file_loaded;
+    lc3->state = header->state;
+    lc3->opcode = header->opcode;
+    lc3->branch_enabled = header->branch_enabled;
+    lc3->trap_vector = header->trap_vector;
+    decoder_decode(header->ir, &lc3->decoded);
+}
+
+/** Returns whether a page holds nothing but zeros */
+bool_t savestate_page_is_zero(const word_t *page) {
+    unsigned int i;
+    for (i = 0; i < MEMORY_PAGE_SIZE; i++) {
+        if (page[i] != 0) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
@@ -0,0 +1,58 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Savestate Module Header File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#ifndef SAVESTATE_H
+#define SAVESTATE_H
+
+#include "global.h"
+#include "lc3.h"
+#include "loader.h"
+
+/* Command line flag. Names the file the whole LC3 is saved to once a headless run stops */
+#define SAVE_STATE_FLAG "--save-state="
+
+/** Files with this extension hold a saved state rather than a program. Loading one puts the
+ * whole LC3 back the way it was saved, so a session (or a batch job) carries on from there */
+#define SAVESTATE_EXTENSION ".lc3s"
+
+/** A saved state starts with a header holding SAVESTATE_MAGIC, SAVESTATE_VERSION, the
+ * registers, the PSR, the ALU, the microstate and a bitmap of the memory pages that aren't
+ * all zero. Only those pages follow, in address order, so an empty page costs one bit. Words
+ * are in the byte order of the machine that saved them, which the header records */
+#define SAVESTATE_MAGIC "LC3S"
+#define SAVESTATE_VERSION 2
+
+/** Saves the whole LC3 to the file in a single write. Returns FALSE if it can't be written */
+bool_t savestate_save(lc3_p, const char *file_name);
+
+/** Maps a saved state and puts the LC3 back the way it was saved. The file is checked before
+ * the LC3 is touched, so it is left alone if the load fails */
+loader_result_t savestate_restore(lc3_p, const char *file_name);
+
+/** Returns whether the file name has the saved state extension */
+bool_t savestate_is_file(const char *file_name);
+
+#endif
@@ -24,42 +24,127 @@
  *  Tyler Schupack
  */
 
+#include <limits.h>
+#include <poll.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <unistd.h>
 
+#include "assembler.h"
+#include "batch.h"
+#include "breakpoint.h"
+#include "core.h"
+#include "device.h"
 #include "display.h"
+#include "history.h"
 #include "lc3.h"
+#include "loader.h"
 #include "memory.h"
+#include "profile.h"
+#include "replay.h"
+#include "savestate.h"
 #include "slc3.h"
+#include "timing.h"
+#include "trace.h"
+
+/** Options parsed from the command line */
+typedef struct options_t {
+    bool_t headless;
+    bool_t batch;
+    bool_t assemble;
+    bool_t lockstep;
+    bool_t cycles;
+    engine_t engine;
+    int threads;
+    unsigned long history_window;
+    char *file_name;
+    char *results_name;
+    char *cycle_costs_name;
+    char *profile_name;
+    char *collapsed_name;
+    char *trace_name;
+    char *record_name;
+    char *replay_name;
+    char *state_name;
+} options_t;
+
+/** Fills the options struct from the command line arguments */
+void parse_options(options_t *, int, char *[]);
+
+/** Loads the file and runs it to HALT without creating a Display */
+int run_headless(lc3_p, options_t *);
+
+/** Assembles the file into a program and listing without running it. Returns the process exit
+ * status */
+int run_assembler(options_t *);
+
+/** Runs the loaded program to HALT the way the options ask for, with the given console.
+ * Returns the process exit status */
+int run_program(lc3_p, console_p, options_t *);
+
+/** Runs the LC3 to HALT through the FSM, charging every instruction to the timing model */
+void run_timed(lc3_p, console_p, timing_p);
+
+/** Runs the LC3 to HALT with profiling on and writes the reports. Returns the process exit
+ * status */
+int run_profiled(lc3_p, console_p, options_t *);
+
+/** Runs the LC3 to HALT one instruction at a time, recording each one to the trace */
+void run_traced(lc3_p, console_p, trace_p);
+
+/** Prints the final register and CC state to stdout */
+void print_final_state(lc3_p);
+
+/** Runs the Display on this thread and the LC3 on a core thread until the user quits. The
+ * file name is the program named on the command line, or NULL */
+void run_display(lc3_p, display_p, engine_t, unsigned long history_window, replay_p recorder,
+                 const char *file_name);
+
+/** Handles the events the core has sent since the last frame. Returns whether a run is still
+ * going. Sets keyboard once the program starts reading the keyboard device */
+bool_t handle_core_events(core_p, display_p, bool_t running, bool_t *keyboard);
 
 /** Allows the display to edit memory */
-void prompt_edit_mem(lc3_p, display_p);
+const lc3_snapshot_t *prompt_edit_mem(core_p, display_p);
 
 /** Returns a non-null pointer to a (hopefully) hex file */
-void prompt_load_file_display(lc3_p);
+const lc3_snapshot_t *prompt_load_file_display(core_p, display_p);
 
-/** Returns a non-null pointer to a (hopefully) hex file */
-void prompt_save_file_display(lc3_p);
+/** Prompts for a file name and saves memory to it, or the whole LC3 if it names a saved
+ * state */
+void prompt_save_file_display(core_p, const lc3_snapshot_t *);
+
+/** Saves to the named file in whichever format its name asks for. Returns FALSE if it can't
+ * be written */
+bool_t save_file_display(core_p, char *, const lc3_snapshot_t *);
 
 /** Prompt from the terminal for a file if one wasn't specified in the arguments */
-void prompt_load_file_terminal(lc3_p, int, char *[]);
+void prompt_load_file_terminal(lc3_p, char *);
 
 /** The main instruction cycle control flow */
-void controller(lc3_p, display_p);
+void controller(lc3_p, console_p);
 
-/** Coordinates TRAP functionality between the Display and LC3 */
-void trap(display_p, lc3_p, word_t);
+/** Runs up to *count instructions on the fast or JIT engine without giving the devices a
+ * turn, and finishes a console TRAP that stops it. Leaves *count at the number not run */
+run_result_t run_slice(lc3_p, console_p, run_result_t (*)(lc3_p, unsigned long *),
+                       unsigned long *count);
 
-/** Opens a file with the given file name */
-FILE *open_file(char *);
+/** Returns the name of an engine for display purposes */
+char *engine_name(engine_t);
 
-/** Saves a file with the given file name */
-bool_t save_memory_to_file(char *, lc3_snapshot_t);
+/** Coordinates TRAP functionality between the console and LC3 */
+void trap(console_p, lc3_p, word_t);
+
+/** Console routines for headless runs, which go straight to stdin/stdout */
+int stdio_get_char(void *);
+bool_t stdio_poll_char(void *, int timeout_ms);
+void stdio_put_char(void *, char);
 
-/** This function allows for the loading of hex files into memory. */
-void load_file_to_memory(lc3_p, FILE *);
+/** Saves a file with the given file name */
+bool_t save_memory_to_file(char *, const lc3_snapshot_t *);
 
 /** Main method for the LC-3 Emulator.
  *
@@ -68,140 +153,485 @@ void load_file_to_memory(lc3_p, FILE *);
  * input "0x1694", that hexadecimal value will be stored into the instruction
  * register (IR) and can be thought of in binary as 0001 0110 1001 0100, which
  * (based on the four highest-order bits) is an ADD instruction for the LC-3
- * (from its instruction set). */
+ * (from its instruction set).
+ *
+ * Passing "--headless" skips the Display entirely: the file is run to HALT with GETC, OUT and
+ * PUTS routed to stdin/stdout, and the final register state is printed. Adding "--cycles"
+ * counts the cycles each instruction would take and reports them at HALT, and
+ * "--cycle-costs=<file>" does the same with costs read from the file. See timing_load_costs.
+ * "--profile" counts how often each address, opcode, loop and subroutine runs and writes the
+ * report to profile.txt at HALT, or to the file given with "--profile=<file>".
+ * "--collapsed-stacks=<file>" also writes the call paths for flame graph tools.
+ * "--trace=<file>" records every instruction to a binary trace that lc3trace can read back.
+ *
+ * "--record=<file>" logs every character GETC reads, along with when it was read, and
+ * "--replay=<file>" runs headless with GETC fed from such a log instead of the keyboard.
+ *
+ * A file name ending in .lc3s is a saved state rather than a program: loading one resumes the
+ * LC3 where it was saved. The Display saves one when given such a name, and
+ * "--save-state=<file>" saves one once a headless run stops.
+ *
+ * With the Display, the last 100000 instructions can be stepped back through; "--history=<n>"
+ * changes how many, and "--history=0" turns it off.
+ *
+ * A file name ending in .asm is assembled as it is loaded, and assembly errors are printed
+ * with their line numbers. "assemble <file.asm> [output]" only assembles it, writing the
+ * program as hex (or as an object file for an output ending in .obj) and a .lst listing.
+ *
+ * "batch <manifest> [results]" runs every job in the manifest across a pool of worker threads
+ * and writes the combined results. See batch_run. */
 int main(int argc, char *argv[]) {
+    options_t options;
+    parse_options(&options, argc, argv);
+
+    if (options.batch == TRUE) {
+        if (options.file_name == NULL) {
+            fprintf(stderr, "%s requires a manifest file name\n", BATCH_COMMAND);
+            return EXIT_FAILURE;
+        }
+        char *results_name =
+            (options.results_name == NULL) ? BATCH_RESULTS_DEFAULT : options.results_name;
+        return batch_run(options.file_name, results_name, options.engine, options.threads,
+                         options.lockstep);
+    }
+    if (options.assemble == TRUE) {
+        return run_assembler(&options);
+    }
+
     /** Create and initialze the LC3 object */
     lc3_p lc3 = lc3_create();
 
+    /** A replay has nobody to type anything, so it never needs the Display */
+    if (options.headless == TRUE || options.replay_name != NULL) {
+        int status = run_headless(lc3, &options);
+        lc3_destroy(lc3);
+        return status;
+    }
+
+    replay_p recorder = NULL;
+    if (options.record_name != NULL) {
+        recorder = replay_create_recorder(options.record_name);
+        if (recorder == NULL) {
+            fprintf(stderr, "Could not write input log to %s\n", options.record_name);
+            lc3_destroy(lc3);
+            return EXIT_FAILURE;
+        }
+    }
+
     /** Prompt from the terminal for a file if one wasn't specified in the arguments */
-    prompt_load_file_terminal(lc3, argc, argv);
+    prompt_load_file_terminal(lc3, options.file_name);
+
+    /** Interactive sessions walk the microstates by default since that is what the Display
+     * is there to show */
+    engine_t engine = (options.engine == ENGINE_DEFAULT) ? ENGINE_FSM : options.engine;
 
     /** Create and initialize the Display object */
     display_p disp = display_create();
-
-    /** Create a snapshot of LC3's components' current parameters and pass this struct by
-     * value into the Display component for displaying. This ensures the display only
-     * receieves a copy of all values in the LC3 and makes it impossible for Display to
-     * modify the LC3 without calling the appropriate methods. */
-    lc3_snapshot_t lc3_snapshot = lc3_get_snapshot(lc3);
-    display_update(disp, lc3_snapshot);
-    display_result_t result = display_loop(disp, lc3_snapshot);
-
-    /* If the user has selected MONITOR_STEP, then lets continue executing the
-     * LC-3 */
-    while (result != DISPLAY_QUIT) {
-        switch (result) {
-        case DISPLAY_EDIT_MEM:
-            prompt_edit_mem(lc3, disp);
-            break;
-        case DISPLAY_LOAD:
-            prompt_load_file_display(lc3);
-            lc3_snapshot = lc3_get_snapshot(lc3);
-            display_update(disp, lc3_snapshot);
-            break;
-        case DISPLAY_SAVE:
-            prompt_save_file_display(lc3);
-            break;
-        case DISPLAY_STEP:
-            if (lc3_is_halted(lc3) == FALSE) {
-                controller(lc3, disp);
-                lc3_snapshot = lc3_get_snapshot(lc3);
-                display_update(disp, lc3_snapshot);
-            }
-            break;
-        case DISPLAY_RUN:
-            do {
-                /** Run through the controller for this instruction */
-                controller(lc3, disp);
-                /** Update the display with new information (but don't wait for a
-                 * keystroke) */
-                lc3_snapshot = lc3_get_snapshot(lc3);
-                display_update(disp, lc3_snapshot);
-                /** Sleep for 5 milliseconds */
-                usleep(5000);
-            } while (lc3_is_halted(lc3) == FALSE &&
-                     display_has_breakpoint(disp, lc3_get_pc(lc3)) == FALSE);
+    if (disp == NULL) {
+        if (recorder != NULL) {
+            replay_destroy(recorder);
         }
-        lc3_snapshot = lc3_get_snapshot(lc3);
-        result = display_loop(disp, lc3_snapshot);
+        lc3_destroy(lc3);
+        return EXIT_FAILURE;
     }
 
+    run_display(lc3, disp, engine, options.history_window, recorder, options.file_name);
+
     /* Memory cleanup. */
     display_destroy(disp);
+    if (recorder != NULL) {
+        replay_destroy(recorder);
+    }
     lc3_destroy(lc3);
 
     return 0;
 }
 
+/** Fills the options struct from the command line arguments. Flags may appear anywhere; the
+ * first argument that isn't a flag is treated as the file name, unless it is the batch
+ * command, in which case the next two are the manifest and results file names */
+void parse_options(options_t *options, int argc, char *argv[]) {
+    options->headless = FALSE;
+    options->batch = FALSE;
+    options->assemble = FALSE;
+    options->lockstep = FALSE;
+    options->cycles = FALSE;
+    options->engine = ENGINE_DEFAULT;
+    options->threads = 0;
+    options->history_window = HISTORY_WINDOW_DEFAULT;
+    options->file_name = NULL;
+    options->results_name = NULL;
+    options->cycle_costs_name = NULL;
+    options->profile_name = NULL;
+    options->collapsed_name = NULL;
+    options->trace_name = NULL;
+    options->record_name = NULL;
+    options->replay_name = NULL;
+    options->state_name = NULL;
+    int i;
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], HEADLESS_FLAG) == 0) {
+            options->headless = TRUE;
+        } else if (strcmp(argv[i], LOCKSTEP_FLAG) == 0) {
+            options->lockstep = TRUE;
+        } else if (strcmp(argv[i], PROFILE_FLAG) == 0) {
+            options->profile_name = PROFILE_REPORT_DEFAULT;
+        } else if (strncmp(argv[i], PROFILE_FILE_FLAG, strlen(PROFILE_FILE_FLAG)) == 0) {
+            options->profile_name = argv[i] + strlen(PROFILE_FILE_FLAG);
+        } else if (strncmp(argv[i], PROFILE_COLLAPSED_FLAG, strlen(PROFILE_COLLAPSED_FLAG)) ==
+                   0) {
+            options->collapsed_name = argv[i] + strlen(PROFILE_COLLAPSED_FLAG);
+            if (options->profile_name == NULL) {
+                options->profile_name = PROFILE_REPORT_DEFAULT;
+            }
+        } else if (strncmp(argv[i], TRACE_FLAG, strlen(TRACE_FLAG)) == 0) {
+            options->trace_name = argv[i] + strlen(TRACE_FLAG);
+        } else if (strncmp(argv[i], RECORD_FLAG, strlen(RECORD_FLAG)) == 0) {
+            options->record_name = argv[i] + strlen(RECORD_FLAG);
+        } else if (strncmp(argv[i], REPLAY_FLAG, strlen(REPLAY_FLAG)) == 0) {
+            options->replay_name = argv[i] + strlen(REPLAY_FLAG);
+        } else if (strncmp(argv[i], SAVE_STATE_FLAG, strlen(SAVE_STATE_FLAG)) == 0) {
+            options->state_name = argv[i] + strlen(SAVE_STATE_FLAG);
+        } else if (strcmp(argv[i], CYCLES_FLAG) == 0) {
+            options->cycles = TRUE;
+        } else if (strncmp(argv[i], CYCLE_COSTS_FLAG, strlen(CYCLE_COSTS_FLAG)) == 0) {
+            options->cycles = TRUE;
+            options->cycle_costs_name = argv[i] + strlen(CYCLE_COSTS_FLAG);
+        } else if (strncmp(argv[i], HISTORY_FLAG, strlen(HISTORY_FLAG)) == 0) {
+            options->history_window = strtoul(argv[i] + strlen(HISTORY_FLAG), NULL, 10);
+        } else if (strncmp(argv[i], THREADS_FLAG, strlen(THREADS_FLAG)) == 0) {
+            options->threads = atoi(argv[i] + strlen(THREADS_FLAG));
+        } else if (strncmp(argv[i], ENGINE_FLAG, strlen(ENGINE_FLAG)) == 0) {
+            char *name = argv[i] + strlen(ENGINE_FLAG);
+            engine_t engine;
+            for (engine = ENGINE_FSM; engine <= ENGINE_JIT; engine++) {
+                if (strcmp(name, engine_name(engine)) == 0) {
+                    options->engine = engine;
+                }
+            }
+            if (options->engine == ENGINE_DEFAULT) {
+                printf("Unknown engine %s. Expected fsm, fast or jit.\n", name);
+            }
+        } else if (options->file_name == NULL && strcmp(argv[i], BATCH_COMMAND) == 0) {
+            options->batch = TRUE;
+        } else if (options->file_name == NULL && strcmp(argv[i], ASSEMBLE_COMMAND) == 0) {
+            options->assemble = TRUE;
+        } else if (options->file_name == NULL) {
+            options->file_name = argv[i];
+        } else if ((options->batch == TRUE || options->assemble == TRUE) &&
+                   options->results_name == NULL) {
+            options->results_name = argv[i];
+        } else {
+            printf("Too many arguments supplied. The first argument will be treated as a file "
+                   "name.\n");
+        }
+    }
+}
+
+/** Assembles the file to the output named after it, or to the results name if one was
+ * given. Returns the process exit status */
+int run_assembler(options_t *options) {
+    if (options->file_name == NULL) {
+        fprintf(stderr, "%s requires a file name\n", ASSEMBLE_COMMAND);
+        return EXIT_FAILURE;
+    }
+    /* By default the program goes beside the source, its .asm swapped for .hex */
+    char output_name[PATH_MAX];
+    if (options->results_name != NULL) {
+        snprintf(output_name, sizeof(output_name), "%s", options->results_name);
+    } else {
+        loader_replace_extension(options->file_name, ".hex", output_name, sizeof(output_name));
+    }
+    loader_result_t assembled = loader_assemble(options->file_name, output_name, stderr);
+    if (assembled == LOADER_ASSEMBLY_ERROR) {
+        return EXIT_FAILURE;
+    }
+    if (assembled != LOADER_OK) {
+        fprintf(stderr, "%s: %s\n", loader_describe(assembled),
+                (assembled == LOADER_NOT_FOUND) ? output_name : options->file_name);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/** Loads the file and runs it to HALT without creating a Display. Returns the process exit
+ * status */
+int run_headless(lc3_p lc3, options_t *options) {
+    if (options->file_name == NULL) {
+        fprintf(stderr, "%s requires a file name\n", HEADLESS_FLAG);
+        return EXIT_FAILURE;
+    }
+    loader_result_t loaded = loader_load_reporting(lc3, options->file_name, stderr);
+    if (loaded != LOADER_OK) {
+        fprintf(stderr, "%s: %s\n", loader_describe(loaded), options->file_name);
+        return EXIT_FAILURE;
+    }
+    /* Unbuffered, so whatever stdin has that GETC hasn't taken is still there to be polled */
+    setvbuf(stdin, NULL, _IONBF, 0);
+    console_t stdio_console = {.get_char = stdio_get_char,
+                               .poll_char = stdio_poll_char,
+                               .put_char = stdio_put_char,
+                               .context = NULL,
+                               .instructions = 0};
+
+    /** A replay takes the place of stdin; a recording listens in on it */
+    replay_p replay = NULL;
+    if (options->replay_name != NULL) {
+        replay = replay_create_player(options->replay_name);
+        if (replay == NULL) {
+            fprintf(stderr, "Could not read input log from %s\n", options->replay_name);
+            return EXIT_FAILURE;
+        }
+    } else if (options->record_name != NULL) {
+        replay = replay_create_recorder(options->record_name);
+        if (replay == NULL) {
+            fprintf(stderr, "Could not write input log to %s\n", options->record_name);
+            return EXIT_FAILURE;
+        }
+    }
+    console_p console =
+        (replay == NULL) ? &stdio_console : replay_attach(replay, &stdio_console);
+    /* The keyboard reads ahead on a thread of its own, so a program polling it never
+     * blocks. Recording or replaying, keys have to arrive at the same instruction every time,
+     * so the keyboard samples the console instead */
+    devices_p devices = devices_create(lc3, console, (replay == NULL) ? TRUE : FALSE);
+    int status = run_program(lc3, console, options);
+    devices_destroy(devices);
+    if (replay != NULL) {
+        replay_destroy(replay);
+    }
+    if (options->state_name != NULL && savestate_save(lc3, options->state_name) == FALSE) {
+        fprintf(stderr, "Could not save state to %s\n", options->state_name);
+        return EXIT_FAILURE;
+    }
+    return status;
+}
+
+/** Runs the loaded program to HALT: through the timing model, the profiler or the trace if
+ * one of them was asked for, and otherwise as fast as the engine goes */
+int run_program(lc3_p lc3, console_p console, options_t *options) {
+    if (options->cycles == TRUE) {
+        timing_p timing = timing_create();
+        if (options->cycle_costs_name != NULL &&
+            timing_load_costs(timing, options->cycle_costs_name) == FALSE) {
+            fprintf(stderr, "Could not read cycle costs from %s\n", options->cycle_costs_name);
+            timing_destroy(timing);
+            return EXIT_FAILURE;
+        }
+        run_timed(lc3, console, timing);
+        print_final_state(lc3);
+        timing_report(timing, stdout);
+        timing_destroy(timing);
+        return EXIT_SUCCESS;
+    }
+
+    if (options->profile_name != NULL) {
+        return run_profiled(lc3, console, options);
+    }
+
+    if (options->trace_name != NULL) {
+        trace_p trace = trace_create(options->trace_name, lc3);
+        if (trace == NULL) {
+            fprintf(stderr, "Could not write trace to %s\n", options->trace_name);
+            return EXIT_FAILURE;
+        }
+        run_traced(lc3, console, trace);
+        trace_destroy(trace);
+        print_final_state(lc3);
+        return EXIT_SUCCESS;
+    }
+
+    /** Headless runs are about throughput, so they use the fast engine unless told otherwise */
+    engine_t engine = (options->engine == ENGINE_DEFAULT) ? ENGINE_FAST : options->engine;
+    while (lc3_is_halted(lc3) == FALSE) {
+        execute(lc3, console, engine, ULONG_MAX);
+    }
+    print_final_state(lc3);
+    return EXIT_SUCCESS;
+}
+
+/** Runs the LC3 to HALT with profiling on and writes the report, along with the collapsed
+ * stacks if they were asked for. Only the fast engine fills in the counters, so the engine
+ * option doesn't apply here */
+int run_profiled(lc3_p lc3, console_p console, options_t *options) {
+    FILE *report_ptr = fopen(options->profile_name, "w");
+    if (report_ptr == NULL) {
+        fprintf(stderr, "Could not write profile to %s\n", options->profile_name);
+        return EXIT_FAILURE;
+    }
+    FILE *collapsed_ptr = NULL;
+    if (options->collapsed_name != NULL) {
+        collapsed_ptr = fopen(options->collapsed_name, "w");
+        if (collapsed_ptr == NULL) {
+            fprintf(stderr, "Could not write collapsed stacks to %s\n",
+                    options->collapsed_name);
+            fclose(report_ptr);
+            return EXIT_FAILURE;
+        }
+    }
+
+    profile_p profile = profile_create();
+    profile_start(profile, lc3_get_pc(lc3));
+    lc3_set_profile(lc3, profile);
+    while (lc3_is_halted(lc3) == FALSE) {
+        execute(lc3, console, ENGINE_FAST, ULONG_MAX);
+    }
+    lc3_set_profile(lc3, NULL);
+    print_final_state(lc3);
+
+    profile_report(profile, lc3->memory, report_ptr);
+    fclose(report_ptr);
+    if (collapsed_ptr != NULL) {
+        profile_write_collapsed(profile, collapsed_ptr);
+        fclose(collapsed_ptr);
+    }
+    profile_destroy(profile);
+    return EXIT_SUCCESS;
+}
+
+/** Runs the LC3 to HALT one instruction at a time, recording each one to the trace. The fast
+ * engine takes each step, so the engine option doesn't apply here */
+void run_traced(lc3_p lc3, console_p console, trace_p trace) {
+    while (lc3_is_halted(lc3) == FALSE) {
+        /* An interrupt taken before the instruction gets a record of its own, and the
+         * instruction's record then starts from the service routine */
+        trace_begin(trace, lc3);
+        if (lc3->devices != NULL && devices_service(lc3->devices) == TRUE) {
+            trace_interrupt(trace, lc3);
+            trace_begin(trace, lc3);
+        }
+        if (lc3_is_halted(lc3) == TRUE) {
+            break;
+        }
+        unsigned long count = 1;
+        run_slice(lc3, console, lc3_run_fast, &count);
+        trace_end(trace, lc3);
+    }
+}
+
+/** Runs the LC3 to HALT through the FSM, charging every instruction to the timing model. The
+ * cycles are counted per microstate, so the engine option doesn't apply here; keeping the
+ * accounting out of execute() means untimed runs don't pay for it */
+void run_timed(lc3_p lc3, console_p console, timing_p timing) {
+    while (lc3_is_halted(lc3) == FALSE) {
+        /* An interrupt is taken and charged before the instruction, which then comes from
+         * the service routine */
+        if (lc3->devices != NULL && devices_service(lc3->devices) == TRUE) {
+            timing_charge_interrupt(timing, lc3);
+        }
+        if (lc3_is_halted(lc3) == TRUE) {
+            break;
+        }
+        timing_charge(timing, lc3);
+        controller(lc3, console);
+    }
+}
+
+/** Prints the final register and CC state to stdout */
+void print_final_state(lc3_p lc3) {
+    cpu_snapshot_t snapshot = cpu_get_snapshot(lc3->cpu);
+    cpu_snapshot_t *cpu = &snapshot;
+    int i;
+    printf("\n");
+    for (i = 0; i < REGISTER_SIZE; i++) {
+        printf("R%d: x%04X%s", i, cpu->registers[i], (i == REGISTER_SIZE - 1) ? "\n" : "  ");
+    }
+    printf("PC: x%04X  IR: x%04X  CC: N=%d Z=%d P=%d\n", cpu->pc, cpu->ir, cpu->cc_n, cpu->cc_z,
+           cpu->cc_p);
+    fflush(stdout);
+}
+
 /** Prompt from and loads a hex file using the regular terminal before Display is loaded */
-void prompt_load_file_terminal(lc3_p lc3, int argc, char *argv[]) {
+void prompt_load_file_terminal(lc3_p lc3, char *file_name) {
     /** The char array used to store the hex file's name */
     char input_file_name[80];
-    /** The pointer to the file on disk */
-    FILE *file_ptr;
     /*
      * If there is an argument, attempt to use it first as the file name.
      * Example file name: "/hex/HW3.hex"
      */
-    if (argc > 1) {
-        if (argc > 2) {
-            printf("Too many arguments supplied. The first argument will be treated as a file "
-                   "name.\n");
-        }
-        file_ptr = open_file(argv[1]);
-        while (file_ptr == NULL) {
-            printf("File not found. Enter a file name: ");
-            scanf("%s", input_file_name);
-            file_ptr = open_file(input_file_name);
+    if (file_name != NULL) {
+        loader_result_t loaded = loader_load_reporting(lc3, file_name, stderr);
+        while (loaded != LOADER_OK) {
+            printf("%s. Enter a file name: ", loader_describe(loaded));
+            if (scanf("%79s", input_file_name) != 1) {
+                exit(EXIT_FAILURE);
+            }
+            loaded = loader_load_reporting(lc3, input_file_name, stderr);
         }
-        load_file_to_memory(lc3, file_ptr);
     }
 }
 
-/** Prompts for and loads a hex file. */
-void prompt_load_file_display(lc3_p lc3) {
+/** Prompts for a hex file and has the core load it. The file is only checked for here. Returns
+ * the snapshot taken after loading, which replaces the caller's */
+const lc3_snapshot_t *prompt_load_file_display(core_p core, display_p disp) {
     char user_input[64];
     display_get_file_name(user_input, sizeof(user_input) / sizeof(user_input[0]));
-    FILE *file_ptr = open_file(user_input);
-    while (file_ptr == NULL) {
-        display_get_file_error(user_input, sizeof(user_input) / sizeof(user_input[0]));
-        file_ptr = open_file(user_input);
+    /* The core reads the file and reports how it went, so it is only opened once */
+    core_send(core, CORE_LOAD, 0, 0, user_input);
+    core_flush(core);
+    loader_result_t loaded;
+    while ((loaded = core_get_load_result(core)) != LOADER_OK) {
+        if (loaded == LOADER_BUSY) {
+            /* GETC's prompt is still to come, so asking for another file won't help */
+            display_get_file_busy();
+            return core_get_snapshot(core);
+        }
+        display_get_file_error(loader_describe(loaded), user_input,
+                               sizeof(user_input) / sizeof(user_input[0]));
+        core_send(core, CORE_LOAD, 0, 0, user_input);
+        core_flush(core);
     }
-    load_file_to_memory(lc3, open_file(user_input));
+    display_load_symbols(disp, user_input);
+    const lc3_snapshot_t *lc3_snapshot = core_get_snapshot(core);
+    display_update(disp, lc3_snapshot);
     display_get_file_success(user_input);
+    return lc3_snapshot;
 }
 
 /** Prompts for and saves to a hex file. */
-void prompt_save_file_display(lc3_p lc3) {
-    lc3_snapshot_t snapshot = lc3_get_snapshot(lc3);
+void prompt_save_file_display(core_p core, const lc3_snapshot_t *snapshot) {
     char user_input[64];
     display_save_file_name(user_input, sizeof(user_input) / sizeof(user_input[0]));
-    bool_t success = save_memory_to_file(user_input, snapshot);
+    bool_t success = save_file_display(core, user_input, snapshot);
     while (success == FALSE) {
         display_save_file_error(user_input, sizeof(user_input) / sizeof(user_input[0]));
-        success = save_memory_to_file(user_input, snapshot);
+        success = save_file_display(core, user_input, snapshot);
     }
     display_save_file_success(user_input);
 }
 
-/** Allows the display to edit memory */
-void prompt_edit_mem(lc3_p lc3, display_p disp) {
+/** Saves memory from the snapshot, except for a saved state, which needs the microstate only
+ * the core can see */
+bool_t save_file_display(core_p core, char *file_name, const lc3_snapshot_t *snapshot) {
+    if (savestate_is_file(file_name) == FALSE) {
+        return save_memory_to_file(file_name, snapshot);
+    }
+    core_send(core, CORE_SAVE_STATE, 0, 0, file_name);
+    core_flush(core);
+    return core_get_save_result(core);
+}
+
+/** Allows the display to edit memory. Returns the snapshot taken after the edit, which
+ * replaces the caller's */
+const lc3_snapshot_t *prompt_edit_mem(core_p core, display_p disp) {
     char address_input[6];
     display_edit_mem_get_address(address_input);
     word_t address = get_word_from_string(address_input);
     char data_input[6];
     display_edit_mem_get_data(data_input, address_input);
     word_t data = get_word_from_string(data_input);
-    lc3_set_memory(lc3, address, data);
-    lc3_snapshot_t snapshot = lc3_get_snapshot(lc3);
-    display_update(disp, snapshot);
-    display_edit_mem_success(disp, address_input, address);
+    core_send(core, CORE_SET_MEMORY, address, data, NULL);
+    core_flush(core);
+    const lc3_snapshot_t *lc3_snapshot = core_get_snapshot(core);
+    display_update(disp, lc3_snapshot);
+    display_edit_mem_success(disp, lc3_snapshot, address_input, address);
+    return lc3_snapshot;
 }
 
 /*
  * The controller method of the LC-3. This contains much of the complete
  * instruction cycle of the LC-3 */
-void controller(lc3_p lc3, display_p disp) {
+void controller(lc3_p lc3, console_p console) {
     /** This is set to true at the end of the STORE phase and allows execution control to
      * be passed back to the main loop */
     bool_t is_cycle_complete = FALSE;
@@ -218,6 +648,7 @@ void controller(lc3_p lc3, display_p disp) {
         switch (lc3_get_state(lc3)) {
         /* The first state of the instruction cycle, the "fetch" state. */
         case STATE_FETCH:
+            console->instructions++;
             lc3_fetch(lc3);
             lc3_set_state(lc3, STATE_DECODE);
             break;
@@ -319,7 +750,10 @@ void controller(lc3_p lc3, display_p disp) {
                 lc3_execute_not(lc3);
                 break;
             case OPCODE_TRAP:
-                trap(disp, lc3, lc3_execute_trap(lc3));
+                trap(console, lc3, lc3_execute_trap(lc3));
+                break;
+            case OPCODE_RTI:
+                lc3_execute_rti(lc3);
                 break;
             case OPCODE_BR:
                 lc3_execute_br(lc3);
@@ -379,84 +813,300 @@ void controller(lc3_p lc3, display_p disp) {
     }     // end while (isCycleComplete)
 } // end controller()
 
+/** Executes up to the given number of instructions with the selected engine, stopping early
+ * if the LC3 halts or a breakpoint is hit. Console TRAPs hit by the fast engine are finished
+ * here the same way the controller finishes them. The FSM checks breakpoints here, the other
+ * engines check them as they go */
+unsigned long execute(lc3_p lc3, console_p console, engine_t engine, unsigned long count) {
+    unsigned long budget = count;
+    if (engine == ENGINE_FSM) {
+        int hit = BREAKPOINT_NONE;
+        while (count > 0 && lc3_is_halted(lc3) == FALSE && hit != BREAKPOINT_AFTER) {
+            if (lc3->devices != NULL) {
+                devices_service(lc3->devices);
+                if (lc3_is_halted(lc3) == TRUE) {
+                    break;
+                }
+            }
+            if (lc3->breakpoints != NULL) {
+                hit = breakpoints_check(lc3->breakpoints, lc3->memory, cpu_get_pc(lc3->cpu),
+                                        cpu_get_registers(lc3->cpu));
+                if (hit == BREAKPOINT_BEFORE) {
+                    break;
+                }
+            }
+            controller(lc3, console);
+            count--;
+        }
+        return budget - count;
+    }
+    run_result_t (*run)(lc3_p, unsigned long *) =
+        (engine == ENGINE_JIT) ? lc3_run_jit : lc3_run_fast;
+    run_result_t result = RUN_TRAP;
+    while (count > 0 && (result == RUN_TRAP || result == RUN_BUDGET)) {
+        /* With devices attached the engine runs in slices, and the devices get their turn in
+         * between */
+        unsigned long slice = count;
+        if (lc3->devices != NULL) {
+            devices_service(lc3->devices);
+            if (lc3_is_halted(lc3) == TRUE) {
+                break;
+            }
+            unsigned long boundary = DEVICE_SLICE - console->instructions % DEVICE_SLICE;
+            if (slice > boundary) {
+                slice = boundary;
+            }
+        }
+        unsigned long left = slice;
+        result = run_slice(lc3, console, run, &left);
+        count -= slice - left;
+    }
+    return budget - count;
+}
+
+/** Runs a slice on the fast or JIT engine, counting the instructions run on the console */
+run_result_t run_slice(lc3_p lc3, console_p console,
+                       run_result_t (*run)(lc3_p, unsigned long *), unsigned long *count) {
+    unsigned long slice = *count;
+    run_result_t result = run(lc3, count);
+    console->instructions += slice - *count;
+    if (result == RUN_TRAP) {
+        trap(console, lc3, lc3_execute_trap(lc3));
+    }
+    return result;
+}
+
+/** Runs the Display on this thread while a core thread runs the LC3. The Display only ever
+ * sees published snapshots, and everything it wants done goes to the core as a command. A
+ * new snapshot is drawn whenever the core publishes one, which during a run happens
+ * RUN_FRAME_RATE times a second. While a run is going, any keypress pauses it */
+void run_display(lc3_p lc3, display_p disp, engine_t engine, unsigned long history_window,
+                 replay_p recorder, const char *file_name) {
+    core_p core = core_create(lc3, engine, history_window, recorder);
+    /* An assembly file is loaded again through the core, which then knows to patch it in place
+     * if it is loaded a second time */
+    if (file_name != NULL && loader_has_extension(file_name, ASSEMBLER_EXTENSION) == TRUE) {
+        core_send(core, CORE_LOAD, 0, 0, file_name);
+        core_flush(core);
+    }
+    if (file_name != NULL) {
+        display_load_symbols(disp, file_name);
+    }
+    /* Belongs to the core and stays put until the next core_get_snapshot */
+    unsigned long shown = core_get_generation(core);
+    const lc3_snapshot_t *lc3_snapshot = core_get_snapshot(core);
+    display_update(disp, lc3_snapshot);
+
+    bool_t running = FALSE;
+    /* Once the program reads the keyboard, keys typed during a run are its input and only Esc
+     * pauses */
+    bool_t keyboard = FALSE;
+    display_result_t result = DISPLAY_NO_ACTION;
+    while (result != DISPLAY_QUIT) {
+        if (running == TRUE) {
+            result = DISPLAY_NO_ACTION;
+            int key = display_poll_key(disp, 1000 / RUN_FRAME_RATE);
+            if (key == DISPLAY_NO_KEY) {
+                /* Nothing typed */
+            } else if (keyboard == TRUE && key != DISPLAY_PAUSE_KEY && key < 256) {
+                core_send(core, CORE_INPUT, 0, (word_t)key, NULL);
+            } else {
+                core_send(core, CORE_PAUSE, 0, 0, NULL);
+            }
+        } else {
+            /* Returns DISPLAY_NO_ACTION if no key comes within a frame */
+            result = display_loop(disp, lc3_snapshot);
+        }
+
+        switch (result) {
+        case DISPLAY_EDIT_MEM:
+            lc3_snapshot = prompt_edit_mem(core, disp);
+            break;
+        case DISPLAY_LOAD:
+            lc3_snapshot = prompt_load_file_display(core, disp);
+            break;
+        case DISPLAY_SAVE:
+            prompt_save_file_display(core, lc3_snapshot);
+            break;
+        case DISPLAY_ENGINE:
+            engine = (engine == ENGINE_JIT) ? ENGINE_FSM : engine + 1;
+            core_send(core, CORE_SET_ENGINE, 0, engine, NULL);
+            display_engine_selected(engine_name(engine));
+            break;
+        case DISPLAY_BREAKPOINT:
+            core_send(core, CORE_SET_BREAKPOINT, display_get_breakpoint_address(disp),
+                      display_has_breakpoint(disp, display_get_breakpoint_address(disp)), NULL);
+            break;
+        case DISPLAY_WATCHPOINT:
+            core_send(core, CORE_SET_WATCHPOINT, display_get_breakpoint_address(disp),
+                      display_get_watch_kinds(disp), NULL);
+            break;
+        case DISPLAY_CONDITION:
+            core_send(core, CORE_SET_CONDITION, display_get_breakpoint_address(disp), 0,
+                      display_get_condition(disp));
+            break;
+        case DISPLAY_STEP:
+            core_send(core, CORE_STEP, 0, 0, NULL);
+            break;
+        case DISPLAY_STEP_BACK:
+            core_send(core, CORE_STEP_BACK, 0, 0, NULL);
+            break;
+        case DISPLAY_REVERSE:
+            core_send(core, CORE_REVERSE, 0, 0, NULL);
+            break;
+        case DISPLAY_RUN:
+            core_send(core, CORE_RUN, 0, 0, NULL);
+            running = TRUE;
+            if (keyboard == TRUE) {
+                display_keyboard_attached();
+            }
+            break;
+        }
+
+        running = handle_core_events(core, disp, running, &keyboard);
+        if (core_get_generation(core) != shown) {
+            shown = core_get_generation(core);
+            lc3_snapshot = core_get_snapshot(core);
+            display_update(disp, lc3_snapshot);
+        }
+    }
+
+    core_destroy(core);
+}
+
+/** Handles the events the core has sent: console output goes to the output window, GETC is
+ * answered from the input window, and the end of a step or run is reported */
+bool_t handle_core_events(core_p core, display_p disp, bool_t running, bool_t *keyboard) {
+    core_message_t event;
+    while (core_next_event(core, &event) == TRUE) {
+        switch (event.type) {
+        case CORE_EVENT_OUTPUT:
+            display_print_output(disp, (char)event.data);
+            break;
+        case CORE_EVENT_INPUT:
+            core_send(core, CORE_INPUT, 0, (unsigned char)display_get_input(disp), NULL);
+            break;
+        case CORE_EVENT_KEYBOARD:
+            *keyboard = TRUE;
+            if (running == TRUE) {
+                display_keyboard_attached();
+            }
+            break;
+        case CORE_EVENT_STOPPED:
+            if (event.data == CORE_STOP_BUSY) {
+                /* Only that command was dropped; whatever is running carries on */
+                display_core_busy(event.address);
+                break;
+            }
+            running = FALSE;
+            if (event.data == CORE_STOP_HALT) {
+                display_halted();
+            } else if (event.data == CORE_STOP_BREAKPOINT) {
+                display_breakpoint_hit(event.address);
+            } else if (event.data == CORE_STOP_WATCHPOINT) {
+                display_watchpoint_hit(event.address);
+            } else if (event.data == CORE_STOP_PAUSE) {
+                display_run_paused(event.address);
+            } else if (event.data == CORE_STOP_NO_HISTORY) {
+                display_history_start(event.address);
+            }
+            break;
+        }
+    }
+    return running;
+}
+
+/** Returns a monotonic clock reading in nanoseconds */
+long long get_time_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/** Returns the name of an engine, matching what the --engine= flag accepts */
+char *engine_name(engine_t engine) {
+    switch (engine) {
+    case ENGINE_FAST:
+        return "fast";
+    case ENGINE_JIT:
+        return "jit";
+    default:
+        return "fsm";
+    }
+}
+
 /*
  * This function that determines and executes the appropriate trap routine based
- * on the trap vector passed.
+ * on the trap vector passed. GETC, OUT and PUTS go through the console, which is stdin/stdout
+ * for headless runs, the core's events for the Display and each job's buffers for batch runs,
+ * possibly with a recording or replay wrapped around it. GETC takes keys typed for the
+ * keyboard device first when one is attached.
  */
-void trap(display_p disp, lc3_p lc3, word_t vector) {
+void trap(console_p console, lc3_p lc3, word_t vector) {
     char c;
+    int input;
     switch (vector) {
     case TRAP_VECTOR_X25:
         /** HALT */
         lc3_trap_x25(lc3);
         break;
     case TRAP_VECTOR_X20:
-        /** GETC */
-        c = display_get_input(disp);
-        lc3_trap_x20(lc3, c);
+        /** GETC. Keys typed for the keyboard device come first */
+        input = (lc3->devices != NULL) ? devices_get_char(lc3->devices)
+                                       : console->get_char(console->context);
+        if (input == EOF) {
+            /** Running out of input would otherwise spin forever, so treat it as a HALT */
+            lc3_trap_x25(lc3);
+            break;
+        }
+        lc3_trap_x20(lc3, (char)input);
         break;
     case TRAP_VECTOR_X21:
         /** OUT */
         c = lc3_trap_x21(lc3);
-        display_print_output(disp, c);
+        console->put_char(console->context, c);
         break;
     case TRAP_VECTOR_X22:
         /** PUTS */
         c = lc3_trap_x22(lc3);
         while (c != '\0') {
-            display_print_output(disp, c);
+            console->put_char(console->context, c);
             c = lc3_trap_x22(lc3);
         }
         break;
     }
 }
 
-/** This function allows for the opening of .hex files. */
-FILE *open_file(char *file_name) {
-    /* Attempt to open file. If file isn't found or otherwise null, allow user to
-       press enter to return to main program of the menu. */
-    FILE *input_file_pointer;
-    input_file_pointer = fopen(file_name, "r");
-    return input_file_pointer;
-}
-
-/** This functions allows for the saving of .hex files. */
-bool_t save_memory_to_file(char *file_name, lc3_snapshot_t lc3_snapshot) {
-    /* Attempt to save file. If file isn't found or otherwise null, allow user to
-       press enter to return to main program of the menu. */
-    FILE *output_file_pointer;
-    output_file_pointer = fopen(file_name, "w+");
-    if (output_file_pointer == NULL) {
-        return FALSE;
-    }
-    fprintf(output_file_pointer, "%04X\n", lc3_snapshot.starting_address);
-    int i;
-    // char string[6];
-    for (i = 0; i < MEMORY_SIZE; i++) {
-        // sprintf(string, "%04X\n", lc3_snapshot.memory_snapshot.data[i]);
-        fprintf(output_file_pointer, "%04X\n", lc3_snapshot.memory_snapshot.data[i]);
+/** Reads a character of console input from stdin for headless runs */
+int stdio_get_char(void *context) {
+    fflush(stdout);
+    int c = getchar();
+    if (c == EOF) {
+        fprintf(stderr, "GETC: end of input, halting\n");
     }
-    fclose(output_file_pointer);
-    return TRUE;
+    return c;
 }
 
-/** This function allows for the loading of hex files into memory. */
-void load_file_to_memory(lc3_p lc3, FILE *file) {
-    char line[8];
-    fgets(line, sizeof(line), file);
-
-    /** Set the starting address */
-    word_t data = strtol(line, NULL, 16);
-    lc3_set_starting_address(lc3, data);
+/** Waits for stdin to have a character or reach its end */
+bool_t stdio_poll_char(void *context, int timeout_ms) {
+    struct pollfd input = {.fd = STDIN_FILENO, .events = POLLIN};
+    return (poll(&input, 1, timeout_ms) > 0) ? TRUE : FALSE;
+}
 
-    /* Read through file line by line and store to CPU memory. */
-    int i = 0;
-    while (fscanf(file, "%hx", &data) != EOF) {
-        lc3_set_memory(lc3, lc3_get_starting_address(lc3) + i, data);
-        i += 1;
-    }
+/** Writes a character of console output to stdout for headless runs */
+void stdio_put_char(void *context, char c) { putchar(c); }
 
-    if (lc3_has_file_loaded(lc3) == FALSE) {
-        lc3_toggle_file_loaded(lc3);
+/** This functions allows for the saving of .hex files, or of .obj files if the name ends in
+ * LOADER_OBJECT_EXTENSION. */
+bool_t save_memory_to_file(char *file_name, const lc3_snapshot_t *lc3_snapshot) {
+    /* Memory is written from the starting address up to the last non-zero word, since the
+     * rest of the address space reads as zero when the file is loaded again anyway */
+    int end = MEMORY_SIZE;
+    while (end > lc3_snapshot->starting_address &&
+           lc3_snapshot->memory_snapshot.data[end - 1] == 0) {
+        end--;
     }
+    return loader_save(file_name, lc3_snapshot->starting_address,
+                       lc3_snapshot->memory_snapshot.data + lc3_snapshot->starting_address,
+                       end - lc3_snapshot->starting_address);
 }
\ No newline at end of file
@@ -42,6 +42,23 @@
 #define OUTPUT_COL_NUMBER 8
 #define OUTPUT_AREA_DEPTH 6
 
+/* Command line flags */
+#define HEADLESS_FLAG "--headless"
+#define ENGINE_FLAG "--engine="
+
+/* Execution engines. The FSM engine walks every microstate through controller(), the fast
+ * engine runs whole instructions through lc3_run_fast() and the JIT engine runs translated
+ * basic blocks through lc3_run_jit() */
+#define ENGINE_DEFAULT 0
+#define ENGINE_FSM 1
+#define ENGINE_FAST 2
+#define ENGINE_JIT 3
+
+/** Run mode executes this many instructions between looking at the clock, and redraws the
+ * display this many times a second */
+#define RUN_SLICE 10000
+#define RUN_FRAME_RATE 30
+
 #define MAX_HEX_BITS 4
 #define MAX_BIN_BITS 16
 
@@ -60,7 +77,29 @@
 #define TRAP_VECTOR_X22 0x22
 #define TRAP_VECTOR_X25 0x25
 
+typedef unsigned char engine_t;
+
 /** Allows the Display to edit memory */
 void slc3_edit_memory_handler(lc3_p, word_t address, word_t data);
 
+/** Where the console TRAP routines (GETC, OUT and PUTS) get their input and send their output.
+ * get_char returns EOF once there is no more input. poll_char waits up to the given number of
+ * milliseconds for get_char to have something without blocking, end of input included, and is
+ * NULL if the console can't tell. execute() counts the instructions run through the console,
+ * so at a TRAP the count includes the TRAP itself */
+typedef struct console_t {
+    int (*get_char)(void *context);
+    bool_t (*poll_char)(void *context, int timeout_ms);
+    void (*put_char)(void *context, char);
+    void *context;
+    unsigned long instructions;
+} console_t, *console_p;
+
+/** Executes up to the given number of instructions with the selected engine. Returns the
+ * number executed, which is less than asked for if the LC3 halted or hit a breakpoint */
+unsigned long execute(lc3_p, console_p, engine_t, unsigned long);
+
+/** Returns a monotonic clock reading in nanoseconds */
+long long get_time_ns();
+
 #endif
@@ -0,0 +1,281 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Timing Module File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#include "timing.h"
+#include "decoder.h"
+#include "memory.h"
+#include "slc3.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** Cycle costs and counters. Counters are kept per opcode so the report can show where the
+ * cycles went */
+typedef struct timing_t {
+    unsigned int state_costs[TIMING_STATE_COUNT];
+    unsigned int read_delay;
+    unsigned int write_delay;
+
+    unsigned long long cycles;
+    unsigned long long instructions;
+    unsigned long long opcode_cycles[OPCODE_COUNT];
+    unsigned long long opcode_counts[OPCODE_COUNT];
+    unsigned long long interrupt_cycles;
+    unsigned long long interrupts;
+} timing_t;
+
+/** Gets the cost of a single microstate, including the wait states of the ones that wait for
+ * memory to be ready */
+unsigned int timing_state(timing_p, int state);
+
+/** Gets the cost of entering a service routine once the PSR is saved away (microstates 45 and
+ * 37 to 54). Switching to the supervisor stack (45) only happens from user mode */
+unsigned int timing_service_routine(timing_p, bool_t from_user);
+
+/** Allocates and initializes a timing model */
+timing_p timing_create() {
+    timing_p timing = calloc(1, sizeof(timing_t));
+    int state;
+    for (state = 0; state < TIMING_STATE_COUNT; state++) {
+        timing->state_costs[state] = TIMING_STATE_COST;
+    }
+    timing->read_delay = MEM_READ_DELAY;
+    timing->write_delay = MEM_WRITE_DELAY;
+    return timing;
+}
+
+/** Deallocates the timing model */
+void timing_destroy(timing_p timing) { free(timing); }
+
+/** Reads microstate and memory costs from a file */
+bool_t timing_load_costs(timing_p timing, char *file_name) {
+    FILE *file_ptr = fopen(file_name, "r");
+    if (file_ptr == NULL) {
+        return FALSE;
+    }
+    bool_t success = TRUE;
+    char line[STRING_SIZE];
+    char name[STRING_SIZE];
+    unsigned int cost;
+    while (success == TRUE && fgets(line, sizeof(line), file_ptr) != NULL) {
+        int fields = sscanf(line, "%199s %u", name, &cost);
+        if (fields <= 0 || name[0] == '#') {
+            continue;
+        }
+        if (fields != 2) {
+            success = FALSE;
+        } else if (strcmp(name, "read") == 0) {
+            timing->read_delay = cost;
+        } else if (strcmp(name, "write") == 0) {
+            timing->write_delay = cost;
+        } else {
+            char *end;
+            long state = strtol(name, &end, 10);
+            if (*end != '\0' || state < 0 || state >= TIMING_STATE_COUNT) {
+                success = FALSE;
+            } else {
+                timing->state_costs[state] = cost;
+            }
+        }
+    }
+    fclose(file_ptr);
+    return success;
+}
+
+/** Charges the cycles of the instruction the LC3 is about to execute. The path follows the
+ * state numbers of the LC-3 FSM, which the microstate functions in lc3.c are annotated with */
+void timing_charge(timing_p timing, lc3_p lc3) {
+    word_t pc = cpu_get_pc(lc3->cpu);
+    const decoded_t *d = memory_get_decoded(lc3->memory, pc);
+
+    /** Fetch and decode */
+    unsigned int cycles = timing_state(timing, 18) + timing_state(timing, 33) +
+                          timing_state(timing, 35) + timing_state(timing, 32);
+
+    switch (d->opcode) {
+    case OPCODE_ADD:
+        cycles += timing_state(timing, 1);
+        break;
+    case OPCODE_AND:
+        cycles += timing_state(timing, 5);
+        break;
+    case OPCODE_NOT:
+        cycles += timing_state(timing, 9);
+        break;
+    case OPCODE_BR:
+        cycles += timing_state(timing, 0);
+        if (d->nzp & cpu_get_cc(lc3->cpu)) {
+            cycles += timing_state(timing, 22);
+        }
+        break;
+    case OPCODE_JMP:
+        cycles += timing_state(timing, 12);
+        break;
+    case OPCODE_JSR:
+        cycles += timing_state(timing, 4);
+        cycles += timing_state(timing, (d->jsr_imm_mode == TRUE) ? 21 : 20);
+        break;
+    case OPCODE_LD:
+        cycles += timing_state(timing, 2) + timing_state(timing, 25) +
+                  timing_state(timing, 27);
+        break;
+    case OPCODE_LDI:
+        cycles += timing_state(timing, 10) + timing_state(timing, 24) +
+                  timing_state(timing, 26) + timing_state(timing, 25) +
+                  timing_state(timing, 27);
+        break;
+    case OPCODE_LDR:
+        cycles += timing_state(timing, 6) + timing_state(timing, 25) +
+                  timing_state(timing, 27);
+        break;
+    case OPCODE_LEA:
+        cycles += timing_state(timing, 14);
+        break;
+    case OPCODE_ST:
+        cycles += timing_state(timing, 3) + timing_state(timing, 23) +
+                  timing_state(timing, 16);
+        break;
+    case OPCODE_STI:
+        cycles += timing_state(timing, 11) + timing_state(timing, 29) +
+                  timing_state(timing, 31) + timing_state(timing, 23) +
+                  timing_state(timing, 16);
+        break;
+    case OPCODE_STR:
+        cycles += timing_state(timing, 7) + timing_state(timing, 23) +
+                  timing_state(timing, 16);
+        break;
+    case OPCODE_TRAP:
+        cycles += timing_state(timing, 15) + timing_state(timing, 28) +
+                  timing_state(timing, 30);
+        break;
+    case OPCODE_RTI:
+        /** In user mode RTI raises the privilege exception (44). Otherwise the PC and PSR come
+         * off the stack (36 and 40 read them), and returning to user mode switches stacks
+         * (59) */
+        cycles += timing_state(timing, 8);
+        if (lc3->psr & PSR_USER) {
+            cycles += timing_state(timing, 44) + timing_service_routine(timing, TRUE);
+        } else {
+            word_t r6 = cpu_get_register(lc3->cpu, R6);
+            word_t psr = memory_peek(lc3->memory, r6 + 1);
+            cycles += timing_state(timing, 36) + timing_state(timing, 38) +
+                      timing_state(timing, 39) + timing_state(timing, 40) +
+                      timing_state(timing, 42) + timing_state(timing, 34) +
+                      timing_state(timing, (psr & PSR_USER) ? 59 : 51);
+        }
+        break;
+    case OPCODE_STACK: {
+        /** An overflowed push or underflowed pop stops after the check and never touches
+         * memory. Otherwise a push goes the way of ST and a pop the way of LD */
+        word_t r6 = cpu_get_register(lc3->cpu, R6);
+        cycles += timing_state(timing, TIMING_STATE_STACK);
+        if (d->imm_mode == STACK_PUSH && r6 >= STACK_MAX) {
+            cycles += timing_state(timing, 23) + timing_state(timing, 16);
+        } else if (d->imm_mode == STACK_POP && r6 <= STACK_LAST) {
+            cycles += timing_state(timing, 25) + timing_state(timing, 27);
+        }
+        break;
+    }
+    }
+
+    timing->cycles += cycles;
+    timing->instructions++;
+    timing->opcode_cycles[d->opcode] += cycles;
+    timing->opcode_counts[d->opcode]++;
+}
+
+/** Charges the cycles of the interrupt the LC3 has just taken. The interrupt is found in the
+ * fetch (18) and the PSR is saved (49) before the service routine is entered. The fetch is
+ * then made again from the service routine, which the next instruction is charged for */
+void timing_charge_interrupt(timing_p timing, lc3_p lc3) {
+    word_t r6 = cpu_get_register(lc3->cpu, R6);
+    bool_t from_user = (memory_peek(lc3->memory, r6 + 1) & PSR_USER) ? TRUE : FALSE;
+    unsigned int cycles = timing_state(timing, 18) + timing_state(timing, 49) +
+                          timing_service_routine(timing, from_user);
+    timing->cycles += cycles;
+    timing->interrupt_cycles += cycles;
+    timing->interrupts++;
+}
+
+/** Gets the cost of entering a service routine. 41 and 48 push the PSR and PC, and 52 reads
+ * the vector table */
+unsigned int timing_service_routine(timing_p timing, bool_t from_user) {
+    unsigned int cycles = (from_user == TRUE) ? timing_state(timing, 45) : 0;
+    return cycles + timing_state(timing, 37) + timing_state(timing, 41) +
+           timing_state(timing, 43) + timing_state(timing, 47) + timing_state(timing, 48) +
+           timing_state(timing, 50) + timing_state(timing, 52) + timing_state(timing, 54);
+}
+
+/** Gets the cost of a single microstate. 33, 24, 25, 28, 29, 36, 40 and 52 wait on a memory
+ * read (R), and 16, 41 and 48 wait on a memory write */
+unsigned int timing_state(timing_p timing, int state) {
+    switch (state) {
+    case 33:
+    case 24:
+    case 25:
+    case 28:
+    case 29:
+    case 36:
+    case 40:
+    case 52:
+        return timing->state_costs[state] + timing->read_delay;
+    case 16:
+    case 41:
+    case 48:
+        return timing->state_costs[state] + timing->write_delay;
+    default:
+        return timing->state_costs[state];
+    }
+}
+
+/** Gets the total number of cycles charged so far */
+unsigned long long timing_get_cycles(timing_p timing) { return timing->cycles; }
+
+/** Prints the total cycles, CPI and a per-opcode breakdown. Opcodes that never ran are left
+ * out */
+void timing_report(timing_p timing, FILE *file_ptr) {
+    double cpi = (timing->instructions == 0)
+                     ? 0.0
+                     : (double)timing->cycles / (double)timing->instructions;
+    fprintf(file_ptr, "Cycles: %llu  Instructions: %llu  CPI: %.2f\n", timing->cycles,
+            timing->instructions, cpi);
+    if (timing->interrupts > 0) {
+        fprintf(file_ptr, "Interrupts: %llu  Cycles: %llu\n", timing->interrupts,
+                timing->interrupt_cycles);
+    }
+    fprintf(file_ptr, "%-6s %12s %14s %8s %7s\n", "Opcode", "Count", "Cycles", "CPI", "Share");
+    opcode_t opcode;
+    for (opcode = 0; opcode < OPCODE_COUNT; opcode++) {
+        unsigned long long count = timing->opcode_counts[opcode];
+        if (count == 0) {
+            continue;
+        }
+        unsigned long long cycles = timing->opcode_cycles[opcode];
+        fprintf(file_ptr, "%-6s %12llu %14llu %8.2f %6.2f%%\n", decoder_opcode_name(opcode),
+                count, cycles, (double)cycles / (double)count,
+                100.0 * (double)cycles / (double)timing->cycles);
+    }
+    fflush(file_ptr);
+}
@@ -0,0 +1,73 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Timing Module Header File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#ifndef TIMING_H
+#define TIMING_H
+
+#include "global.h"
+#include "lc3.h"
+#include <stdio.h>
+
+/* Command line flags */
+#define CYCLES_FLAG "--cycles"
+#define CYCLE_COSTS_FLAG "--cycle-costs="
+
+/** The LC-3 FSM numbers its microstates with six bits, 0 through 63, though not every number
+ * is used. The stack opcode has no state of its own there, so it is charged to an extra one
+ * after them */
+#define TIMING_STATE_STACK 64
+#define TIMING_STATE_COUNT 65
+#define TIMING_STATE_COST 1
+
+typedef struct timing_t *timing_p;
+
+/** Allocates and initializes a timing model. Every microstate costs TIMING_STATE_COST cycles,
+ * and the states that wait on memory cost MEM_READ_DELAY or MEM_WRITE_DELAY more */
+timing_p timing_create();
+
+/** Deallocates the timing model */
+void timing_destroy(timing_p);
+
+/** Reads microstate and memory costs from a file. Each line is "<state> <cycles>",
+ * "read <cycles>" or "write <cycles>"; blank lines and lines starting with '#' are skipped.
+ * Returns FALSE if the file can't be opened or a line can't be understood */
+bool_t timing_load_costs(timing_p, char *file_name);
+
+/** Charges the cycles of the instruction the LC3 is about to execute. Must be called before
+ * the instruction runs, since the path it takes through the FSM depends on the CC and R6 */
+void timing_charge(timing_p, lc3_p);
+
+/** Charges the cycles of the interrupt the LC3 has just taken, which are kept apart from the
+ * instructions'. The PSR it pushed tells whether it had to switch stacks */
+void timing_charge_interrupt(timing_p, lc3_p);
+
+/** Gets the total number of cycles charged so far */
+unsigned long long timing_get_cycles(timing_p);
+
+/** Prints the total cycles, CPI, the interrupts taken and a per-opcode breakdown */
+void timing_report(timing_p, FILE *);
+
+#endif
@@ -0,0 +1,337 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Trace Decoder Tool File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#include "../decoder.h"
+#include "../trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+/* Command line flags. Records are only printed if they pass every filter given */
+#define PC_FLAG "--pc="             /* x3000 or x3000-x30FF */
+#define OPCODE_FLAG "--opcode="     /* ADD, LDR, TRAP, ... */
+#define REGISTER_FLAG "--register=" /* Changed the register, 0 through 7 */
+#define WRITE_FLAG "--write="       /* Wrote to the address */
+#define LIMIT_FLAG "--limit="       /* Stop after printing this many */
+
+/** The record being decoded and the LC3 state the trace has built up so far */
+typedef struct reader_t {
+    FILE *file_ptr;
+    unsigned long long index;
+    unsigned char flags;
+    word_t pc;
+    word_t ir;
+    unsigned char mask;
+    word_t registers[REGISTER_SIZE];
+    cc_t cc;
+    word_t write_address;
+    word_t write_data;
+    word_t psr_data;
+    word_t next_pc;
+    bool_t truncated;
+} reader_t;
+
+typedef struct filter_t {
+    word_t pc_low;
+    word_t pc_high;
+    int opcode; /* -1 for any */
+    int reg;    /* -1 for any */
+    long write_address; /* -1 for any */
+    unsigned long long limit; /* 0 for no limit */
+} filter_t;
+
+/** Reads the header. Returns FALSE if this isn't a trace this tool understands */
+bool_t read_header(reader_t *);
+
+/** Reads the next record. Returns FALSE at the end of the trace */
+bool_t read_record(reader_t *);
+
+/** Reads a byte, a little-endian word, a varint and a zigzag delta applied to a word */
+int read_byte(reader_t *);
+word_t read_word(reader_t *);
+unsigned int read_varint(reader_t *);
+word_t read_delta(reader_t *, word_t from);
+
+/** Returns whether the record passes the filter */
+bool_t matches(reader_t *, filter_t *);
+
+/** Prints the record on one line */
+void print_record(reader_t *);
+
+/** Parses an address with or without a leading x. Returns -1 if it isn't one */
+long parse_address(char *);
+
+/** Prints and filters a trace written with --trace=<file> */
+int main(int argc, char *argv[]) {
+    filter_t filter = {0x0000, 0xFFFF, -1, -1, -1, 0};
+    char *file_name = NULL;
+    int i;
+    for (i = 1; i < argc; i++) {
+        char *arg = argv[i];
+        if (strncmp(arg, PC_FLAG, strlen(PC_FLAG)) == 0) {
+            char *range = arg + strlen(PC_FLAG);
+            char *dash = strchr(range, '-');
+            if (dash != NULL) {
+                *dash = '\0';
+            }
+            long low = parse_address(range);
+            long high = (dash != NULL) ? parse_address(dash + 1) : low;
+            if (low < 0 || high < 0) {
+                fprintf(stderr, "Bad address range in %s\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+            filter.pc_low = low;
+            filter.pc_high = high;
+        } else if (strncmp(arg, OPCODE_FLAG, strlen(OPCODE_FLAG)) == 0) {
+            char *name = arg + strlen(OPCODE_FLAG);
+            for (filter.opcode = OPCODE_COUNT - 1; filter.opcode >= 0; filter.opcode--) {
+                if (strcasecmp(name, decoder_opcode_name(filter.opcode)) == 0) {
+                    break;
+                }
+            }
+            if (filter.opcode < 0) {
+                fprintf(stderr, "Unknown opcode %s\n", name);
+                return EXIT_FAILURE;
+            }
+        } else if (strncmp(arg, REGISTER_FLAG, strlen(REGISTER_FLAG)) == 0) {
+            char *name = arg + strlen(REGISTER_FLAG);
+            filter.reg = atoi((name[0] == 'R' || name[0] == 'r') ? name + 1 : name);
+            if (filter.reg < 0 || filter.reg >= REGISTER_SIZE) {
+                fprintf(stderr, "Unknown register %s\n", name);
+                return EXIT_FAILURE;
+            }
+        } else if (strncmp(arg, WRITE_FLAG, strlen(WRITE_FLAG)) == 0) {
+            filter.write_address = parse_address(arg + strlen(WRITE_FLAG));
+            if (filter.write_address < 0) {
+                fprintf(stderr, "Bad address in %s\n", arg);
+                return EXIT_FAILURE;
+            }
+        } else if (strncmp(arg, LIMIT_FLAG, strlen(LIMIT_FLAG)) == 0) {
+            filter.limit = strtoull(arg + strlen(LIMIT_FLAG), NULL, 10);
+        } else if (file_name == NULL) {
+            file_name = arg;
+        } else {
+            fprintf(stderr, "Too many arguments supplied\n");
+            return EXIT_FAILURE;
+        }
+    }
+    if (file_name == NULL) {
+        fprintf(stderr, "Usage: %s <trace> [%s<from>[-<to>]] [%s<name>] [%s<n>] [%s<address>] "
+                        "[%s<n>]\n",
+                argv[0], PC_FLAG, OPCODE_FLAG, REGISTER_FLAG, WRITE_FLAG, LIMIT_FLAG);
+        return EXIT_FAILURE;
+    }
+
+    reader_t reader;
+    memset(&reader, 0, sizeof(reader));
+    reader.file_ptr = fopen(file_name, "rb");
+    if (reader.file_ptr == NULL) {
+        fprintf(stderr, "File not found: %s\n", file_name);
+        return EXIT_FAILURE;
+    }
+    if (read_header(&reader) == FALSE) {
+        fprintf(stderr, "%s is not a version %d trace\n", file_name, TRACE_VERSION);
+        fclose(reader.file_ptr);
+        return EXIT_FAILURE;
+    }
+
+    unsigned long long shown = 0;
+    while ((filter.limit == 0 || shown < filter.limit) && read_record(&reader) == TRUE) {
+        if (matches(&reader, &filter) == TRUE) {
+            print_record(&reader);
+            shown++;
+        }
+    }
+    fclose(reader.file_ptr);
+    if (reader.truncated == TRUE) {
+        fprintf(stderr, "The trace ends in the middle of record %llu\n", reader.index);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/** Reads the header */
+bool_t read_header(reader_t *reader) {
+    int i;
+    for (i = 0; i < TRACE_MAGIC_SIZE; i++) {
+        if (read_byte(reader) != TRACE_MAGIC[i]) {
+            return FALSE;
+        }
+    }
+    if (read_byte(reader) != TRACE_VERSION) {
+        return FALSE;
+    }
+    reader->next_pc = read_word(reader);
+    for (i = 0; i < REGISTER_SIZE; i++) {
+        reader->registers[i] = read_word(reader);
+    }
+    reader->cc = read_byte(reader);
+    return !reader->truncated;
+}
+
+/** Reads the next record and applies it to the state */
+bool_t read_record(reader_t *reader) {
+    int flags = getc(reader->file_ptr);
+    if (flags == EOF) {
+        return FALSE;
+    }
+    reader->index++;
+    reader->flags = flags;
+    reader->ir = read_word(reader);
+    reader->pc = reader->next_pc;
+    if (flags & TRACE_PC_JUMP) {
+        reader->pc = read_delta(reader, reader->next_pc);
+    }
+    reader->next_pc = reader->pc + 1;
+
+    reader->mask = 0;
+    if (flags & TRACE_REGISTERS) {
+        reader->mask = read_byte(reader);
+        int i;
+        for (i = 0; i < REGISTER_SIZE; i++) {
+            if (reader->mask & (1 << i)) {
+                reader->registers[i] = read_delta(reader, reader->registers[i]);
+            }
+        }
+    }
+    if (flags & TRACE_CC) {
+        reader->cc = read_byte(reader);
+    }
+    if (flags & TRACE_MEMORY) {
+        reader->write_address = read_delta(reader, reader->write_address);
+        reader->write_data = read_varint(reader);
+    }
+    if (flags & TRACE_INTERRUPT) {
+        reader->psr_data = read_varint(reader);
+    }
+    return !reader->truncated;
+}
+
+/** Reads a byte. Running out partway through a record marks the trace as truncated */
+int read_byte(reader_t *reader) {
+    int byte = getc(reader->file_ptr);
+    if (byte == EOF) {
+        reader->truncated = TRUE;
+        return 0;
+    }
+    return byte;
+}
+
+/** Reads a little-endian word */
+word_t read_word(reader_t *reader) {
+    word_t low = read_byte(reader);
+    return low | (read_byte(reader) << 8);
+}
+
+/** Reads a varint */
+unsigned int read_varint(reader_t *reader) {
+    unsigned int value = 0;
+    int shift = 0;
+    int byte;
+    do {
+        byte = read_byte(reader);
+        value |= (unsigned int)(byte & 0x7F) << shift;
+        shift += 7;
+    } while ((byte & 0x80) && shift < 21);
+    return value;
+}
+
+/** Reads a zigzag delta and applies it to the word */
+word_t read_delta(reader_t *reader, word_t from) {
+    unsigned int zigzag = read_varint(reader);
+    int delta = (zigzag & 1) ? -(int)(zigzag >> 1) - 1 : (int)(zigzag >> 1);
+    return (word_t)(from + delta);
+}
+
+/** Returns whether the record passes the filter */
+bool_t matches(reader_t *reader, filter_t *filter) {
+    if (reader->pc < filter->pc_low || reader->pc > filter->pc_high) {
+        return FALSE;
+    }
+    if (filter->opcode >= 0 && ((reader->flags & TRACE_INTERRUPT) ||
+                                (reader->ir >> BITSHIFT_OPCODE) != filter->opcode)) {
+        return FALSE;
+    }
+    if (filter->reg >= 0 && !(reader->mask & (1 << filter->reg))) {
+        return FALSE;
+    }
+    if (filter->write_address >= 0 &&
+        (!(reader->flags & TRACE_MEMORY) || reader->write_address != filter->write_address) &&
+        (!(reader->flags & TRACE_INTERRUPT) ||
+         (word_t)(reader->write_address + 1) != filter->write_address)) {
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/** Prints the record on one line: its number, PC, IR and opcode, then what it changed. An
+ * interrupt shows as INT, with the IR of the instruction it came before */
+void print_record(reader_t *reader) {
+    const char *name = (reader->flags & TRACE_INTERRUPT)
+                           ? "INT"
+                           : decoder_opcode_name(reader->ir >> BITSHIFT_OPCODE);
+    printf("%10llu  x%04X  x%04X  %s", reader->index, reader->pc, reader->ir, name);
+    /** The changes line up in a column after the longest opcode name */
+    int pad = 7 - (int)strlen(name);
+    int i;
+    for (i = 0; i < REGISTER_SIZE; i++) {
+        if (reader->mask & (1 << i)) {
+            printf("%*sR%d=x%04X", pad, "", i, reader->registers[i]);
+            pad = 1;
+        }
+    }
+    if (reader->flags & TRACE_CC) {
+        printf("%*sCC=%s", pad, "",
+               (reader->cc & MASK_CC_N) ? "N" : (reader->cc & MASK_CC_Z) ? "Z" : "P");
+        pad = 1;
+    }
+    if (reader->flags & TRACE_MEMORY) {
+        printf("%*s[x%04X]=x%04X", pad, "", reader->write_address, reader->write_data);
+        pad = 1;
+    }
+    if (reader->flags & TRACE_INTERRUPT) {
+        printf("%*s[x%04X]=x%04X", pad, "", (word_t)(reader->write_address + 1),
+               reader->psr_data);
+    }
+    if (reader->flags & TRACE_HALT) {
+        printf("%*sHALT", pad, "");
+    }
+    printf("\n");
+}
+
+/** Parses an address with or without a leading x */
+long parse_address(char *text) {
+    if (text[0] == 'x' || text[0] == 'X') {
+        text++;
+    }
+    char *end;
+    long address = strtol(text, &end, 16);
+    if (*text == '\0' || *end != '\0' || address < 0 || address > 0xFFFF) {
+        return -1;
+    }
+    return address;
+}
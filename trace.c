@@ -0,0 +1,270 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Trace Module File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#include "trace.h"
+#include "memory.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/** How long the writer thread sleeps when the ring is empty, and how long the LC3 waits
+ * before checking a full ring again */
+#define TRACE_IDLE_NS 1000000
+
+typedef struct trace_t {
+    FILE *file_ptr;
+    pthread_t thread;
+    atomic_bool quit;
+
+    /** Single producer, single consumer ring of bytes. The LC3 only writes the tail and the
+     * writer thread only writes the head */
+    unsigned char *buffer;
+    _Alignas(64) atomic_size_t head;
+    _Alignas(64) atomic_size_t tail;
+
+    /** State before the instruction being recorded, from trace_begin */
+    word_t pc;
+    word_t registers[REGISTER_SIZE];
+    cc_t cc;
+    bool_t writes_memory;
+    word_t write_address;
+
+    /** What the deltas of the next record are taken from */
+    word_t next_pc;
+    word_t last_write_address;
+} trace_t;
+
+/** Writes everything in the ring to the file until told to quit */
+void *trace_main(void *);
+
+/** Copies bytes into the ring, waiting for room if it's full */
+void trace_push(trace_p, const unsigned char *, size_t);
+
+/** Records what changed since trace_begin, with the flags given */
+void trace_record(trace_p, lc3_p, unsigned char flags, word_t ir);
+
+/** Appends a word, little-endian. Returns the new end */
+unsigned char *trace_put_word(unsigned char *, word_t);
+
+/** Appends a varint. Returns the new end */
+unsigned char *trace_put_varint(unsigned char *, unsigned int);
+
+/** Appends the difference between two words as a zigzag varint. Returns the new end */
+unsigned char *trace_put_delta(unsigned char *, word_t from, word_t to);
+
+/** Sleeps for TRACE_IDLE_NS */
+void trace_idle();
+
+/** Opens the trace file, writes the header and starts the writer thread */
+trace_p trace_create(char *file_name, lc3_p lc3) {
+    FILE *file_ptr = fopen(file_name, "wb");
+    if (file_ptr == NULL) {
+        return NULL;
+    }
+    trace_p trace = calloc(1, sizeof(trace_t));
+    trace->file_ptr = file_ptr;
+    trace->buffer = malloc(TRACE_BUFFER_SIZE);
+    atomic_init(&trace->quit, FALSE);
+    atomic_init(&trace->head, 0);
+    atomic_init(&trace->tail, 0);
+
+    unsigned char header[TRACE_HEADER_SIZE];
+    unsigned char *end = header;
+    int i;
+    for (i = 0; i < TRACE_MAGIC_SIZE; i++) {
+        *end++ = TRACE_MAGIC[i];
+    }
+    *end++ = TRACE_VERSION;
+    trace->next_pc = cpu_get_pc(lc3->cpu);
+    end = trace_put_word(end, trace->next_pc);
+    for (i = 0; i < REGISTER_SIZE; i++) {
+        end = trace_put_word(end, cpu_get_register(lc3->cpu, i));
+    }
+    *end++ = cpu_get_cc(lc3->cpu);
+    fwrite(header, 1, end - header, file_ptr);
+
+    pthread_create(&trace->thread, NULL, trace_main, trace);
+    return trace;
+}
+
+/** Notes what the next instruction starts from */
+void trace_begin(trace_p trace, lc3_p lc3) {
+    word_t *registers = cpu_get_registers(lc3->cpu);
+    int i;
+    trace->pc = cpu_get_pc(lc3->cpu);
+    for (i = 0; i < REGISTER_SIZE; i++) {
+        trace->registers[i] = registers[i];
+    }
+    trace->cc = cpu_get_cc(lc3->cpu);
+    trace->writes_memory = lc3_get_store_address(lc3, &trace->write_address);
+}
+
+/** Records the instruction that just retired */
+void trace_end(trace_p trace, lc3_p lc3) { trace_record(trace, lc3, 0, cpu_get_ir(lc3->cpu)); }
+
+/** Records an interrupt. The PC was pushed last, so it is at the top of the stack */
+void trace_interrupt(trace_p trace, lc3_p lc3) {
+    trace->writes_memory = TRUE;
+    trace->write_address = cpu_get_register(lc3->cpu, R6);
+    trace_record(trace, lc3, TRACE_INTERRUPT, memory_peek(lc3->memory, trace->pc));
+}
+
+/** Records what changed since trace_begin */
+void trace_record(trace_p trace, lc3_p lc3, unsigned char flags, word_t ir) {
+    unsigned char record[TRACE_RECORD_MAX];
+    unsigned char *end = record + 1;
+    end = trace_put_word(end, ir);
+
+    if (trace->pc != trace->next_pc) {
+        flags |= TRACE_PC_JUMP;
+        end = trace_put_delta(end, trace->next_pc, trace->pc);
+    }
+    trace->next_pc = trace->pc + 1;
+
+    word_t *registers = cpu_get_registers(lc3->cpu);
+    unsigned char mask = 0;
+    int i;
+    for (i = 0; i < REGISTER_SIZE; i++) {
+        if (registers[i] != trace->registers[i]) {
+            mask |= 1 << i;
+        }
+    }
+    if (mask != 0) {
+        flags |= TRACE_REGISTERS;
+        *end++ = mask;
+        for (i = 0; i < REGISTER_SIZE; i++) {
+            if (mask & (1 << i)) {
+                end = trace_put_delta(end, trace->registers[i], registers[i]);
+            }
+        }
+    }
+
+    cc_t cc = cpu_get_cc(lc3->cpu);
+    if (cc != trace->cc) {
+        flags |= TRACE_CC;
+        *end++ = cc;
+    }
+
+    if (trace->writes_memory == TRUE) {
+        flags |= TRACE_MEMORY;
+        end = trace_put_delta(end, trace->last_write_address, trace->write_address);
+        end = trace_put_varint(end, memory_peek(lc3->memory, trace->write_address));
+        trace->last_write_address = trace->write_address;
+    }
+    if (flags & TRACE_INTERRUPT) {
+        end = trace_put_varint(end, memory_peek(lc3->memory, trace->write_address + 1));
+    }
+
+    if (lc3_is_halted(lc3) == TRUE) {
+        flags |= TRACE_HALT;
+    }
+    record[0] = flags;
+    trace_push(trace, record, end - record);
+}
+
+/** Waits for the writer thread to write out everything, then closes the file */
+void trace_destroy(trace_p trace) {
+    atomic_store(&trace->quit, TRUE);
+    pthread_join(trace->thread, NULL);
+    fclose(trace->file_ptr);
+    free(trace->buffer);
+    free(trace);
+}
+
+/** Writes everything in the ring to the file until told to quit. The quit flag is checked
+ * before the ring, so whatever was pushed before quitting still gets written */
+void *trace_main(void *context) {
+    trace_p trace = context;
+    for (;;) {
+        bool_t quit = atomic_load(&trace->quit);
+        size_t head = atomic_load_explicit(&trace->head, memory_order_relaxed);
+        size_t tail = atomic_load_explicit(&trace->tail, memory_order_acquire);
+        if (head == tail) {
+            if (quit == TRUE) {
+                break;
+            }
+            trace_idle();
+            continue;
+        }
+        /** Up to the end of the ring; whatever wrapped around goes next time */
+        size_t start = head % TRACE_BUFFER_SIZE;
+        size_t count = tail - head;
+        if (count > TRACE_BUFFER_SIZE - start) {
+            count = TRACE_BUFFER_SIZE - start;
+        }
+        fwrite(trace->buffer + start, 1, count, trace->file_ptr);
+        atomic_store_explicit(&trace->head, head + count, memory_order_release);
+    }
+    fflush(trace->file_ptr);
+    return NULL;
+}
+
+/** Copies bytes into the ring, waiting for room if it's full */
+void trace_push(trace_p trace, const unsigned char *bytes, size_t count) {
+    size_t tail = atomic_load_explicit(&trace->tail, memory_order_relaxed);
+    while (tail + count - atomic_load_explicit(&trace->head, memory_order_acquire) >
+           TRACE_BUFFER_SIZE) {
+        trace_idle();
+    }
+    size_t i;
+    for (i = 0; i < count; i++) {
+        trace->buffer[(tail + i) % TRACE_BUFFER_SIZE] = bytes[i];
+    }
+    atomic_store_explicit(&trace->tail, tail + count, memory_order_release);
+}
+
+/** Appends a word, little-endian */
+unsigned char *trace_put_word(unsigned char *end, word_t word) {
+    *end++ = word & 0xFF;
+    *end++ = word >> 8;
+    return end;
+}
+
+/** Appends a varint */
+unsigned char *trace_put_varint(unsigned char *end, unsigned int value) {
+    while (value >= 0x80) {
+        *end++ = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    *end++ = value;
+    return end;
+}
+
+/** Appends the difference between two words as a zigzag varint */
+unsigned char *trace_put_delta(unsigned char *end, word_t from, word_t to) {
+    short delta = (short)(word_t)(to - from);
+    unsigned int zigzag = (delta < 0) ? ((unsigned int)(-(delta + 1)) << 1) | 1
+                                      : (unsigned int)delta << 1;
+    return trace_put_varint(end, zigzag);
+}
+
+/** Sleeps for TRACE_IDLE_NS */
+void trace_idle() {
+    struct timespec delay = {0, TRACE_IDLE_NS};
+    nanosleep(&delay, NULL);
+}
@@ -0,0 +1,93 @@
+/**
+ *  LC-3 Simulator
+ *  Final Project (Project #6)
+ *  TCSS 372 - Computer Architecture
+ *  Spring 2018
+ * 
+ *  Trace Module Header File
+ * 
+ *  This is a simulator of the LC-3 (Little Computer) machine using an 
+ *  object-oriented approach in C. The simulator includes all standard LC-3 
+ *  functionality based on the finite state machine approach and the corresponding
+ *  opcode tables for the machine, with an additional push-pop stack feature utilized 
+ *  on the previously reserved (1101) opcode.
+ * 
+ *  Group Members:
+ *  Michael Fulton
+ *  Enoch Chan
+ *  Logan Stafford
+ * 
+ *  Base Code Contributors:
+ *  Sam Brendel
+ *  Michael Josten
+ *  Sam Anderson
+ *  Tyler Schupack  
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "global.h"
+#include "lc3.h"
+
+/* Command line flag. Names the file the trace is written to */
+#define TRACE_FLAG "--trace="
+
+/** A trace file starts with the magic number, the format version and the state of the LC3
+ * before the first instruction: the PC, R0 through R7 and the CC. Words are little-endian */
+#define TRACE_MAGIC "LC3T"
+#define TRACE_MAGIC_SIZE 4
+#define TRACE_VERSION 2
+#define TRACE_HEADER_SIZE (TRACE_MAGIC_SIZE + 1 + 2 + 2 * REGISTER_SIZE + 1)
+
+/** After the header comes one record per retired instruction. Each record starts with a byte
+ * of these flags and the IR (a word), followed by whichever of these parts the flags call for:
+ *   TRACE_PC_JUMP    The PC, as the difference from the previous record's PC + 1
+ *   TRACE_REGISTERS  A byte with a bit per changed register, then for each of them in order
+ *                    the difference from its old value
+ *   TRACE_CC         The new CC in a byte
+ *   TRACE_MEMORY     The address written, as the difference from the last address written,
+ *                    then the word written
+ *   TRACE_INTERRUPT  Not an instruction but an interrupt, taken before the instruction at the
+ *                    PC ran; the IR is that instruction's. The memory part is the PC pushed
+ *                    on the supervisor stack, and the PSR pushed above it follows as a varint
+ * Differences are zigzag encoded (0, -1, 1, -2, ...) 16-bit values and they, like the word
+ * written, are stored as varints: seven bits per byte, low bits first, with the high bit set
+ * on every byte but the last. A small change takes one byte */
+#define TRACE_PC_JUMP 0x01
+#define TRACE_REGISTERS 0x02
+#define TRACE_CC 0x04
+#define TRACE_MEMORY 0x08
+#define TRACE_HALT 0x10 /* The instruction halted the LC3 */
+#define TRACE_INTERRUPT 0x20
+
+/** The largest a record can get: the flags, the IR, a PC, a register mask, eight registers,
+ * the CC and a memory write, with every varint at its longest, and an interrupt's PSR */
+#define TRACE_RECORD_MAX (1 + 2 + 3 + 1 + 3 * REGISTER_SIZE + 1 + 3 + 3 + 3)
+
+/** Size of the ring the LC3 writes records into for the writer thread. Must be a power of
+ * two */
+#define TRACE_BUFFER_SIZE (1 << 20)
+
+typedef struct trace_t *trace_p;
+
+/** Opens the trace file, writes the header from the LC3's current state and starts the
+ * writer thread. Returns NULL if the file can't be opened */
+trace_p trace_create(char *file_name, lc3_p);
+
+/** Notes what the next instruction starts from. Must be called before each instruction */
+void trace_begin(trace_p, lc3_p);
+
+/** Records the instruction that just retired. Only waits if the writer thread has fallen a
+ * whole buffer behind */
+void trace_end(trace_p, lc3_p);
+
+/** Records an interrupt taken since trace_begin, in place of an instruction. trace_begin must
+ * be called again before the instruction that follows */
+void trace_interrupt(trace_p, lc3_p);
+
+/** Waits for the writer thread to write out everything recorded, then closes the file and
+ * deallocates the trace */
+void trace_destroy(trace_p);
+
+#endif